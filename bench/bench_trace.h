@@ -0,0 +1,45 @@
+
+#ifndef ZOOM_ANALYSIS_BENCH_TRACE_H
+#define ZOOM_ANALYSIS_BENCH_TRACE_H
+
+#include <string>
+#include <vector>
+
+#include "lib/net.h"
+#include "lib/pcap_file_reader.h"
+#include "lib/zoom_flow_tracker.h"
+
+namespace bench {
+
+    //! a packet of the benchmark trace together with the verdict of the flow tracker
+    struct trace_pkt {
+        std::vector<unsigned char> buf;
+        timeval ts;
+        unsigned short frame_len;
+        bool zoom, p2p;
+    };
+
+    //! loads the Ethernet/IPv4 packets of a trace into memory and classifies them once
+    inline std::vector<trace_pkt> load_trace(const std::string& file_name) {
+
+        pcap_file_reader reader(file_name);
+        zoom::flow_tracker tracker;
+        std::vector<trace_pkt> pkts;
+        pcap_pkt pkt;
+
+        while (reader.next(pkt)) {
+
+            if (net::eth::type_from_buf(pkt.buf) != net::eth::type::ipv4) continue;
+
+            auto ip_5t = net::ipv4_5tuple::from_ipv4_pkt_data(pkt.buf + net::eth::HDR_LEN);
+            auto flow = tracker.track(ip_5t, pkt.ts, pkt.frame_len);
+
+            pkts.push_back({{pkt.buf, pkt.buf + pkt.cap_len}, pkt.ts, pkt.frame_len,
+                            flow && flow->is_udp(), flow && flow->is_p2p()});
+        }
+
+        return pkts;
+    }
+}
+
+#endif
@@ -0,0 +1,154 @@
+
+#include <catch.h>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include "lib/csv_buffer.h"
+#include "lib/zoom.h"
+
+#include "bench_trace.h"
+
+namespace {
+
+    const std::size_t ROWS = 100000;
+
+    //! packet log row as formatted by zoom::offline_analyzer before csv_buffer (reference)
+    void write_pkt_row(std::ostream& os, const zoom::pkt& pkt) {
+
+        os << std::dec << pkt.ts.s << "," << pkt.ts.us << ",u," << (pkt.flags.srv ? "s," : "p,")
+           << pkt.ip_5t << "," << (pkt.zoom_media_type == zoom::AUDIO_TYPE ? "a," : "v,");
+
+        if (pkt.pkts_in_frame) {
+            os << pkt.pkts_in_frame << ",";
+        } else {
+            os << "NA,";
+        }
+
+        os << std::dec << (unsigned) pkt.proto.rtp.ssrc << ","
+           << std::dec << (unsigned) pkt.proto.rtp.pt << ","
+           << std::dec << (unsigned) pkt.proto.rtp.seq << ","
+           << std::dec << (unsigned) pkt.proto.rtp.ts << ","
+           << std::dec << (unsigned) pkt.pcap_frame_len << ","
+           << std::dec << (unsigned) pkt.udp_pl_len << ",";
+
+        os << "0x";
+        os << std::hex << std::setw(2) << std::setfill('0') << (unsigned) pkt.rtp_ext1[0];
+        os << std::hex << std::setw(2) << std::setfill('0') << (unsigned) pkt.rtp_ext1[1];
+        os << std::hex << std::setw(2) << std::setfill('0') << (unsigned) pkt.rtp_ext1[2];
+        os << ",0" << std::endl;
+    }
+
+    //! the same row formatted with csv_buffer
+    void write_pkt_row(csv_buffer& row, const zoom::pkt& pkt) {
+
+        row.put(pkt.ts.s).put(',').put(pkt.ts.us).put(",u,").put(pkt.flags.srv ? "s," : "p,")
+           .put((unsigned) pkt.ip_5t.ip_proto).put(',')
+           .put_ipv4(pkt.ip_5t.ip_src).put(',').put(pkt.ip_5t.tp_src).put(',')
+           .put_ipv4(pkt.ip_5t.ip_dst).put(',').put(pkt.ip_5t.tp_dst).put(',')
+           .put(pkt.zoom_media_type == zoom::AUDIO_TYPE ? "a," : "v,");
+
+        if (pkt.pkts_in_frame) {
+            row.put(pkt.pkts_in_frame).put(',');
+        } else {
+            row.put("NA,");
+        }
+
+        row.put((unsigned) pkt.proto.rtp.ssrc).put(',')
+           .put((unsigned) pkt.proto.rtp.pt).put(',')
+           .put((unsigned) pkt.proto.rtp.seq).put(',')
+           .put((unsigned) pkt.proto.rtp.ts).put(',')
+           .put((unsigned) pkt.pcap_frame_len).put(',')
+           .put((unsigned) pkt.udp_pl_len).put(',')
+           .put("0x").put_hex(pkt.rtp_ext1[0]).put_hex(pkt.rtp_ext1[1]).put_hex(pkt.rtp_ext1[2])
+           .put(",0\n");
+    }
+
+    //! ROWS packet records built from the RTP packets of the trace
+    std::vector<zoom::pkt> load_rows() {
+
+        std::vector<zoom::pkt> rtp_pkts, rows;
+
+        for (const auto& p: bench::load_trace(BENCH_DATA_DIR "zoom_test.pcap")) {
+
+            if (!p.zoom) continue;
+
+            zoom::pkt pkt{zoom::parse_zoom_pkt_buf(p.buf.data(), true, p.p2p), p.ts, p.frame_len,
+                          p.p2p};
+
+            if (pkt.flags.rtp) rtp_pkts.push_back(pkt);
+        }
+
+        for (std::size_t i = 0; i < ROWS; i++) {
+            rows.push_back(rtp_pkts[i % rtp_pkts.size()]);
+            rows.back().ts.us = (std::uint32_t) (i % 1000000);
+            rows.back().proto.rtp.seq = (std::uint16_t) i;
+        }
+
+        return rows;
+    }
+
+    template <typename WriteRows>
+    double rows_per_s(WriteRows&& write_rows) {
+        auto start = std::chrono::steady_clock::now();
+        write_rows();
+        std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+        return (double) ROWS / d.count();
+    }
+}
+
+TEST_CASE("csv_buffer: packet log rows", "[csv]") {
+
+    static const auto rows = load_rows();
+    auto file_name = (std::filesystem::temp_directory_path() / "zoom_analysis_csv_bench.csv").string();
+
+    // both formatters must produce the same bytes
+    std::ostringstream expected;
+    csv_buffer buf;
+
+    for (const auto& pkt: rows) {
+        write_pkt_row(expected, pkt);
+        write_pkt_row(buf, pkt);
+    }
+
+    REQUIRE(buf.view() == expected.str());
+
+    auto write_ostream = [&]() {
+        std::ofstream os(file_name);
+
+        for (const auto& pkt: rows)
+            write_pkt_row(os, pkt);
+    };
+
+    auto write_csv_buffer = [&]() {
+        std::ofstream os(file_name);
+        csv_buffer row;
+
+        for (const auto& pkt: rows) {
+            write_pkt_row(row, pkt);
+
+            if (row.full())
+                row.write_to(os);
+        }
+
+        row.write_to(os);
+    };
+
+    BENCHMARK("std::ofstream << with std::endl (100k rows)") {
+        write_ostream();
+    };
+
+    BENCHMARK("csv_buffer, 64 KiB writes (100k rows)") {
+        write_csv_buffer();
+    };
+
+    std::cout << "- std::ofstream: " << (unsigned long) rows_per_s(write_ostream) << " rows/s"
+              << std::endl;
+    std::cout << "- csv_buffer: " << (unsigned long) rows_per_s(write_csv_buffer) << " rows/s"
+              << std::endl;
+
+    std::filesystem::remove(file_name);
+}
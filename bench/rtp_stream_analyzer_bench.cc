@@ -0,0 +1,209 @@
+
+#include <catch.h>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "lib/rtp_stream_analyzer.h"
+#include "lib/zoom.h"
+
+namespace {
+
+    const unsigned FRAMES = 100000;
+    const unsigned STREAMS = 10000, STREAM_PKTS = 192;
+
+    //! sums up the evicted frames, called without std::function
+    struct frame_sink {
+        unsigned long* frames;
+        unsigned long* pl_len;
+
+        template <typename Analyzer, typename Frame>
+        void frame(const Analyzer&, const Frame& f) {
+            (*frames)++, *pl_len += f.total_pl_len + f.pkts_seen;
+        }
+
+        template <typename Analyzer, typename Stats>
+        void stats(const Analyzer&, unsigned, unsigned, const Stats&) { }
+
+        template <typename Analyzer, typename Stats>
+        void rollup(const Analyzer&, unsigned, unsigned, unsigned, const Stats&) { }
+    };
+
+    // same ring and meta data as zoom::offline_analyzer
+    using stream_analyzer = rtp_stream_analyzer<zoom::media_stream_key, zoom::rtp_pkt_meta, 64>;
+    using sink_stream_analyzer = rtp_stream_analyzer<zoom::media_stream_key, zoom::rtp_pkt_meta,
+                                                     64, frame_sink>;
+
+    struct rtp_pkt {
+        std::uint16_t seq;
+        std::uint32_t ts;
+        timeval tv;
+        unsigned pl_len;
+        zoom::rtp_pkt_meta meta;
+    };
+
+    //! FRAMES video frames at 30 fps of 1 to 12 packets each, every 50th packet is reordered
+    std::vector<rtp_pkt> video_pkts() {
+
+        std::vector<rtp_pkt> pkts;
+        std::uint16_t seq = 1;
+
+        for (unsigned f = 0; f < FRAMES; f++) {
+
+            unsigned n = 1 + (f * 7) % 12;
+            auto us = (long) f * 33333;
+
+            for (unsigned i = 0; i < n; i++) {
+                pkts.push_back({seq++, 3000 * f + 1, {us / 1000000, us % 1000000 + i},
+                                i + 1 < n ? 1000u : 400u,
+                                {.rtp_ext1 = {0, 0, 0}, .pkt_type = zoom::VIDEO_TYPE,
+                                 .pkts_hint = n}});
+            }
+        }
+
+        for (std::size_t i = 50; i < pkts.size(); i += 50)
+            std::swap(pkts[i - 1], pkts[i]);
+
+        return pkts;
+    }
+
+    //! returns the number of frames handed to the frame handler
+    unsigned long run(const std::vector<rtp_pkt>& pkts, unsigned long& pl_len) {
+
+        unsigned long frames = 0;
+
+        stream_analyzer a([&](const auto&, const auto& f) {
+                              frames++, pl_len += f.total_pl_len + f.pkts_seen;
+                          },
+                          [](const auto&, unsigned, unsigned, const auto&) { },
+                          90000, zoom::media_stream_key{});
+
+        for (const auto& p: pkts)
+            a.add(p.seq, p.ts, p.tv, p.pl_len, p.meta);
+
+        a.flush();
+        return frames;
+    }
+
+    //! the same with a frame_sink
+    unsigned long run_sink(const std::vector<rtp_pkt>& pkts, unsigned long& pl_len) {
+
+        unsigned long frames = 0;
+        sink_stream_analyzer a(frame_sink{&frames, &pl_len}, 90000, zoom::media_stream_key{});
+
+        for (const auto& p: pkts)
+            a.add(p.seq, p.ts, p.tv, p.pl_len, p.meta);
+
+        a.flush();
+        return frames;
+    }
+
+    std::vector<sink_stream_analyzer> make_streams(unsigned long& frames, unsigned long& pl_len) {
+        return {STREAMS, sink_stream_analyzer(frame_sink{&frames, &pl_len}, 90000,
+                                              zoom::media_stream_key{})};
+    }
+
+    //! adds STREAM_PKTS packets to each stream (3 packets per frame) and flushes them, packets are
+    //! interleaved round-robin such that consecutive packets belong to different streams
+    void run_streams(std::vector<sink_stream_analyzer>& streams) {
+
+        zoom::rtp_pkt_meta meta = {.rtp_ext1 = {0, 0, 0}, .pkt_type = zoom::VIDEO_TYPE,
+                                   .pkts_hint = 3};
+
+        for (unsigned i = 0; i < STREAM_PKTS; i++) {
+
+            auto us = (long) (i / 3) * 33333 + i % 3;
+
+            for (auto& a: streams)
+                a.add((std::uint16_t) (i + 1), 3000 * (i / 3) + 1, {us / 1000000, us % 1000000},
+                      1000, meta);
+        }
+
+        for (auto& a: streams)
+            a.flush();
+    }
+
+    template <typename Run>
+    double frames_per_s(Run&& run) {
+        auto start = std::chrono::steady_clock::now();
+        auto frames = run();
+        std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+        return (double) frames / d.count();
+    }
+}
+
+TEST_CASE("rtp_stream_analyzer: frame eviction of video streams", "[rtp_stream_analyzer]") {
+
+    static const auto pkts = video_pkts();
+    unsigned long pl_len = 0, sink_pl_len = 0;
+
+    REQUIRE(run(pkts, pl_len) == FRAMES);
+    REQUIRE(run_sink(pkts, sink_pl_len) == FRAMES);
+    REQUIRE(sink_pl_len == pl_len);
+
+    BENCHMARK("add + flush, std::function handlers (100k frames)") {
+        return run(pkts, pl_len);
+    };
+
+    BENCHMARK("add + flush, sink (100k frames)") {
+        return run_sink(pkts, pl_len);
+    };
+
+    std::cout << "- std::function handlers: "
+              << (unsigned long) frames_per_s([&]() { return run(pkts, pl_len); }) << " frames/s"
+              << std::endl;
+    std::cout << "- sink: "
+              << (unsigned long) frames_per_s([&]() { return run_sink(pkts, pl_len); })
+              << " frames/s" << std::endl;
+}
+
+TEST_CASE("rtp_stream_analyzer: 10k concurrent streams", "[rtp_stream_analyzer]") {
+
+    unsigned long frames = 0, pl_len = 0;
+    auto streams = make_streams(frames, pl_len);
+
+    run_streams(streams);
+    REQUIRE(frames == STREAMS * STREAM_PKTS / 3);
+
+    // the streams are set up outside of the measurement
+    BENCHMARK_ADVANCED("add + flush, 10k streams (1.92M packets)")(
+            Catch::Benchmark::Chronometer meter) {
+
+        std::vector<std::vector<sink_stream_analyzer>> runs(meter.runs());
+
+        for (auto& run: runs)
+            run = make_streams(frames, pl_len);
+
+        meter.measure([&](int i) { run_streams(runs[i]); });
+    };
+
+    std::cout << "- analyzer size: " << sizeof(sink_stream_analyzer) << " Bytes" << std::endl;
+}
+
+TEST_CASE("rtp_stream_analyzer: jitter calculators", "[rtp_stream_analyzer]") {
+
+    // last packet of each frame: RTP timestamp and arrival time
+    std::vector<std::pair<std::uint32_t, timeval>> frames;
+
+    for (const auto& p: video_pkts()) {
+        if (frames.empty() || frames.back().first != p.ts)
+            frames.emplace_back(p.ts, p.tv);
+        else
+            frames.back().second = p.tv;
+    }
+
+    auto run_jitter = [&](auto calc) {
+        double sum = 0;
+        for (const auto& [rtp_ts, tv]: frames)
+            sum += calc.add_frame(tv, rtp_ts);
+        return sum;
+    };
+
+    BENCHMARK("jitter_calculator (100k frames)") {
+        return run_jitter(jitter_calculator(90000));
+    };
+
+    BENCHMARK("rfc3550_jitter_calculator (100k frames)") {
+        return run_jitter(rfc3550_jitter_calculator(90000));
+    };
+}
@@ -0,0 +1,94 @@
+
+#include <catch.h>
+#include <random>
+
+#include "lib/zoom.h"
+
+#include "bench_trace.h"
+
+namespace {
+
+    const std::size_t BATCH_PKTS = 10000000;
+    const std::size_t ARENA_SLOTS = 1 << 18, SLOT_BYTES = 256; // 64 MiB, exceeds the LLC
+    const std::size_t CHUNK_PKTS = 4096;
+
+    //! synthetic batch of Zoom packets scattered across memory like buffers of a capture ring
+    struct synthetic_batch {
+
+        std::vector<unsigned char> arena;
+        std::vector<const unsigned char*> bufs;
+        std::vector<zoom::net_headers> net_hdrs;
+        std::unique_ptr<bool[]> is_p2p;
+
+        explicit synthetic_batch(const std::vector<bench::trace_pkt>& trace)
+            : arena(ARENA_SLOTS * SLOT_BYTES), is_p2p(new bool[BATCH_PKTS]) {
+
+            std::vector<const bench::trace_pkt*> zoom_pkts;
+            std::vector<zoom::net_headers> slot_net_hdrs(ARENA_SLOTS);
+            std::mt19937 rng(42);
+
+            for (const auto& p: trace) {
+                if (p.zoom) zoom_pkts.push_back(&p);
+            }
+
+            for (std::size_t slot = 0; slot < ARENA_SLOTS; slot++) {
+                const auto& p = *zoom_pkts[slot % zoom_pkts.size()];
+                auto* slot_buf = arena.data() + slot * SLOT_BYTES;
+                std::copy_n(p.buf.begin(), std::min(p.buf.size(), SLOT_BYTES), slot_buf);
+                slot_net_hdrs[slot] = zoom::parse_net_hdrs(slot_buf);
+            }
+
+            bufs.reserve(BATCH_PKTS);
+            net_hdrs.reserve(BATCH_PKTS);
+
+            for (std::size_t i = 0; i < BATCH_PKTS; i++) {
+                auto slot = rng() % ARENA_SLOTS;
+                bufs.push_back(arena.data() + slot * SLOT_BYTES);
+                net_hdrs.push_back(slot_net_hdrs[slot]);
+                is_p2p[i] = zoom_pkts[slot % zoom_pkts.size()]->p2p;
+            }
+        }
+    };
+}
+
+TEST_CASE("zoom: batched classification of a synthetic 10M-packet batch", "[zoom][classify]") {
+
+    static const synthetic_batch batch(bench::load_trace(BENCH_DATA_DIR "zoom_test.pcap"));
+    std::vector<zoom::headers> hdrs(CHUNK_PKTS);
+
+    BENCHMARK("per packet: parse_zoom_hdrs (10M pkts)") {
+
+        std::uint64_t sum = 0;
+
+        for (std::size_t i = 0; i < BATCH_PKTS; i += CHUNK_PKTS) {
+
+            auto n = std::min(CHUNK_PKTS, BATCH_PKTS - i);
+
+            for (std::size_t j = 0; j < n; j++) {
+                hdrs[j] = zoom::parse_zoom_hdrs(batch.bufs[i + j], batch.net_hdrs[i + j],
+                                                batch.is_p2p[i + j]);
+            }
+
+            sum += hdrs[0].rtp_rtcp_offset + hdrs[n - 1].rtp_rtcp_offset;
+        }
+
+        return sum;
+    };
+
+    BENCHMARK("batched: parse_zoom_hdrs_batch (10M pkts)") {
+
+        std::uint64_t sum = 0;
+
+        for (std::size_t i = 0; i < BATCH_PKTS; i += CHUNK_PKTS) {
+
+            auto n = std::min(CHUNK_PKTS, BATCH_PKTS - i);
+
+            zoom::parse_zoom_hdrs_batch(batch.bufs.data() + i, batch.net_hdrs.data() + i,
+                                        batch.is_p2p.get() + i, n, hdrs.data());
+
+            sum += hdrs[0].rtp_rtcp_offset + hdrs[n - 1].rtp_rtcp_offset;
+        }
+
+        return sum;
+    };
+}
@@ -0,0 +1,67 @@
+
+#include <catch.h>
+
+#include "lib/net.h"
+#include "lib/zoom.h"
+
+#include "bench_trace.h"
+
+TEST_CASE("zoom: fused parsing of 5-tuple, Zoom headers and zoom::pkt", "[zoom][parse]") {
+
+    static const auto pkts = bench::load_trace(BENCH_DATA_DIR "zoom_test.pcap");
+
+    // both paths must produce the same records
+    for (const auto& p: pkts) {
+
+        if (!p.zoom) continue;
+
+        auto hdr = zoom::parse_zoom_pkt_buf(p.buf.data(), true, p.p2p);
+        zoom::pkt expected{hdr, p.ts, p.frame_len, p.p2p};
+
+        auto net_hdr = zoom::parse_net_hdrs(p.buf.data());
+        zoom::pkt fused{net_hdr, zoom::parse_zoom_hdrs(p.buf.data(), net_hdr, p.p2p),
+                        p.ts, p.frame_len, p.p2p};
+
+        REQUIRE(fused.ip_5t == expected.ip_5t);
+        REQUIRE(fused.udp_pl_len == expected.udp_pl_len);
+        REQUIRE(fused.proto.rtp.ssrc == expected.proto.rtp.ssrc);
+    }
+
+    BENCHMARK("separate: from_ipv4_pkt_data + parse_zoom_pkt_buf + zoom::pkt (per trace)") {
+
+        std::uint64_t sum = 0;
+
+        for (const auto& p: pkts) {
+
+            auto ip_5t = net::ipv4_5tuple::from_ipv4_pkt_data(p.buf.data() + net::eth::HDR_LEN);
+            sum += ip_5t.tp_src;
+
+            if (p.zoom) {
+                auto hdr = zoom::parse_zoom_pkt_buf(p.buf.data(), true, p.p2p);
+                zoom::pkt zpkt{hdr, p.ts, p.frame_len, p.p2p};
+                sum += zpkt.proto.rtp.seq + zpkt.udp_pl_len;
+            }
+        }
+
+        return sum;
+    };
+
+    BENCHMARK("fused: parse_net_hdrs + parse_zoom_hdrs + zoom::pkt (per trace)") {
+
+        std::uint64_t sum = 0;
+
+        for (const auto& p: pkts) {
+
+            auto net_hdr = zoom::parse_net_hdrs(p.buf.data());
+            sum += net_hdr.ip_5t.tp_src;
+
+            if (p.zoom) {
+                auto hdr = zoom::parse_zoom_hdrs(p.buf.data(), net_hdr, p.p2p);
+                zoom::pkt zpkt{net_hdr, hdr, p.ts, p.frame_len, p.p2p};
+                sum += zpkt.proto.rtp.seq + zpkt.udp_pl_len;
+            }
+        }
+
+        return sum;
+    };
+}
@@ -5,10 +5,13 @@
 #include <optional>
 #include <iostream>
 
+#include "../lib/checkpoint.h"
 #include "../lib/net.h"
+#include "../lib/output_stream.h"
 #include "../lib/pcap_file_reader.h"
 #include "../lib/pcap_file_writer.h"
 #include "../lib/util.h"
+#include "../lib/zoom_approx_flow_tracker.h"
 #include "../lib/zoom_flow_tracker.h"
 
 namespace zoom_flows {
@@ -21,8 +24,17 @@ namespace zoom_flows {
         std::optional<std::string> types_out_file_name = std::nullopt;
         std::optional<std::string> rate_out_file_name  = std::nullopt;
         std::optional<std::string> zpkt_out_file_name  = std::nullopt;
+        std::optional<std::string> checkpoint_file_name = std::nullopt;
+        std::optional<std::string> ipv6_nets_file_name = std::nullopt;
+
+        std::optional<unsigned> approx_memory_kb = std::nullopt;
+        std::optional<unsigned> follow_interval_s = std::nullopt;
+        std::optional<unsigned> dedup_window_us = std::nullopt;
 
         bool p2p_only = false;
+        bool bidirectional = false;
+        bool compare_approx = false;
+        bool resume = false;
     };
 
     void print_help(cxxopts::Options& opts, int exit_code = 0) {
@@ -51,6 +63,19 @@ namespace zoom_flows {
                 ("z,zpkt-out", "zoom packets binary output file (optional)",
                  cxxopts::value<std::string>(),"OUT.zpkt")
                 ("2,p2p-only", "only process STUN and P2P packets")
+                ("b,bidirectional", "track both directions of a flow as a single flow")
+                ("a,approx", "track flows in fixed memory of KB kilobytes (optional)",
+                 cxxopts::value<unsigned>(), "KB")
+                ("c,compare", "compare approximate with exact tracking (requires -a)")
+                ("k,checkpoint", "write state to FILE after each input file (optional)",
+                 cxxopts::value<std::string>(), "FILE")
+                ("R,resume", "restore state from the -k checkpoint and skip processed input files")
+                ("F,follow", "keep polling the input directory every SECONDS for new files",
+                 cxxopts::value<unsigned>(), "SECONDS")
+                ("d,dedup", "drop IPv4 packets captured twice within USEC microseconds (optional)",
+                 cxxopts::value<unsigned>(), "USEC")
+                ("6,ipv6-nets", "also track IPv6 flows to the Zoom prefixes listed in FILE (optional)",
+                 cxxopts::value<std::string>(), "FILE")
                 ("h,help", "print this help message");
 
         return opts;
@@ -88,11 +113,75 @@ namespace zoom_flows {
             config.zpkt_out_file_name = parsed["z"].as<std::string>();
         }
 
+        if (parsed.count("a")) {
+            config.approx_memory_kb = parsed["a"].as<unsigned>();
+        }
+
+        if (parsed.count("k")) {
+            config.checkpoint_file_name = parsed["k"].as<std::string>();
+        }
+
+        if (parsed.count("F")) {
+            config.follow_interval_s = parsed["F"].as<unsigned>();
+        }
+
+        if (parsed.count("d")) {
+            config.dedup_window_us = parsed["d"].as<unsigned>();
+        }
+
+        if (parsed.count("6")) {
+            config.ipv6_nets_file_name = parsed["6"].as<std::string>();
+        }
+
         if (parsed.count("h")) {
             print_help(opts);
         }
 
         config.p2p_only = parsed.count("2");
+        config.bidirectional = parsed.count("b");
+        config.compare_approx = parsed.count("c");
+        config.resume = parsed.count("R");
+
+        if (config.approx_memory_kb && *config.approx_memory_kb == 0) {
+            std::cerr << "error: -a requires a memory budget of at least 1 KB." << std::endl;
+            print_help(opts, 1);
+        }
+
+        if (config.compare_approx && !config.approx_memory_kb) {
+            std::cerr << "error: -c requires -a." << std::endl;
+            print_help(opts, 1);
+        }
+
+        if (config.approx_memory_kb && !config.compare_approx && config.flows_out_file_name) {
+            std::cerr << "error: flow summary requires exact tracking (use -c with -a)."
+                      << std::endl;
+            print_help(opts, 1);
+        }
+
+        if (config.ipv6_nets_file_name && config.approx_memory_kb && !config.compare_approx) {
+            std::cerr << "error: IPv6 flows require exact tracking (use -c with -a)." << std::endl;
+            print_help(opts, 1);
+        }
+
+        if (config.resume && !config.checkpoint_file_name) {
+            std::cerr << "error: -R requires -k." << std::endl;
+            print_help(opts, 1);
+        }
+
+        if (config.checkpoint_file_name && config.approx_memory_kb) {
+            std::cerr << "error: checkpoints require exact tracking (no -a)." << std::endl;
+            print_help(opts, 1);
+        }
+
+        if (config.follow_interval_s && !std::filesystem::is_directory(config.input_path)) {
+            std::cerr << "error: -F requires a directory as input path." << std::endl;
+            print_help(opts, 1);
+        }
+
+        if (config.follow_interval_s && *config.follow_interval_s == 0) {
+            std::cerr << "error: -F requires an interval of at least 1s." << std::endl;
+            print_help(opts, 1);
+        }
 
         return config;
     }
@@ -1,25 +1,155 @@
 
 #include <array>
+#include <csignal>
+#include <thread>
+#include <unordered_set>
 
 #include "zoom_flows.h"
 #include "../lib/zoom.h"
 #include "../lib/simple_binary_writer.h"
 #include "../lib/mac_counter.h"
+#include "../lib/pkt_dedup.h"
+#include "../lib/zoom_nets.h"
+
+namespace {
+
+    volatile std::sig_atomic_t stop_requested = 0;
+
+    void request_stop(int) {
+        stop_requested = 1;
+    }
+}
 
 int main(int argc, char** argv) {
 
     auto config = zoom_flows::parse_options(zoom_flows::set_options(), argc, argv);
     pcap_file_writer pcap_out;
-    std::ofstream flows_out, types_out, rate_out;
+    output_stream flows_out, types_out, rate_out;
     simple_binary_writer<zoom::pkt> zpkt_writer;
 
-    auto in_files = util::files_in_directory(config.input_path, "pcap");
-    std::sort(in_files.begin(), in_files.end(), util::compare_file_ext_seq);
+    // newest input file held back in follow mode, reported when stopping
+    std::optional<std::string> held_back_file;
 
-    if (config.pcap_out_file_name) {
-        pcap_out.open(*config.pcap_out_file_name, pcap_link_type::eth);
+    // lists the input files in order, in follow mode without the newest file, which the capture
+    // may still be writing to, and without the pcap output if it is written to the input directory
+    auto list_input_files = [&]() {
+
+        auto files = util::files_in_directory(config.input_path, {"pcap", "pcapng"});
+
+        if (config.pcap_out_file_name) {
+            auto pcap_out_path = std::filesystem::weakly_canonical(*config.pcap_out_file_name);
+
+            files.erase(std::remove_if(files.begin(), files.end(), [&](const auto& f) {
+                return std::filesystem::weakly_canonical(f) == pcap_out_path;
+            }), files.end());
+        }
+
+        std::sort(files.begin(), files.end(), util::compare_file_ext_seq);
+
+        if (config.follow_interval_s && !files.empty()) {
+            held_back_file = files.back();
+            files.pop_back();
+        }
+
+        return files;
+    };
+
+    auto in_files = list_input_files();
+
+    pcap_pkt pkt;
+    zoom::flow_tracker flow_tracker(300, config.bidirectional);
+    std::optional<zoom::approx_flow_tracker> approx_tracker;
+    std::optional<pkt_dedup> dedup;
+    zoom::approx_flow_tracker::comparison approx_comparison;
+    mac_counter mac_counter;
+
+    struct pkts_bytes {
+        unsigned long pkts = 0, bytes = 0;
+
+        void increment(unsigned long pkts_inc, unsigned long bytes_inc) {
+            pkts += pkts_inc;
+            bytes += bytes_inc;
+        }
+    };
+
+    std::array<pkts_bytes, 256> p2p_inner_types, srv_inner_types, srv_outer_types;
+
+    unsigned last_ts = 0;
+    std::uint64_t pkts_without_mac = 0;
+    std::uint64_t last_total_pkt_count = 0, last_zoom_pkt_count = 0, last_zoom_byte_count = 0;
+
+    // sizes of the continuously written outputs at the last checkpoint, -1 if disabled
+    struct output_positions {
+        std::int64_t pcap = -1, zpkt = -1, rate = -1;
+    } out_pos;
+
+    if (config.dedup_window_us) {
+        dedup.emplace(*config.dedup_window_us);
+    }
+
+    std::vector<std::string> processed_files;
+    std::unordered_set<std::string> processed_file_set;
+
+    auto remove_processed_files = [&](std::vector<std::string>& files) {
+        files.erase(std::remove_if(files.begin(), files.end(), [&](const auto& f) {
+            return processed_file_set.count(f) > 0;
+        }), files.end());
+    };
+
+    if (config.resume && std::filesystem::exists(*config.checkpoint_file_name)) {
+
+        try {
+            checkpoint::reader checkpoint_in(*config.checkpoint_file_name, "zoom_flows");
+
+            checkpoint_in.read(processed_files);
+            flow_tracker.restore(checkpoint_in);
+            checkpoint_in.read(p2p_inner_types);
+            checkpoint_in.read(srv_inner_types);
+            checkpoint_in.read(srv_outer_types);
+            mac_counter.restore(checkpoint_in);
+            checkpoint_in.read(pkts_without_mac);
+            checkpoint_in.read(last_ts);
+            checkpoint_in.read(last_total_pkt_count);
+            checkpoint_in.read(last_zoom_pkt_count);
+            checkpoint_in.read(last_zoom_byte_count);
+            checkpoint_in.read(out_pos);
+
+            if (checkpoint_in.read<bool>() != dedup.has_value())
+                throw std::runtime_error("checkpoint was taken with another -d setting");
+
+            if (dedup)
+                dedup->restore(checkpoint_in);
+
+            if (config.pcap_out_file_name && out_pos.pcap >= 0)
+                checkpoint::truncate_output(*config.pcap_out_file_name, out_pos.pcap);
+
+            if (config.zpkt_out_file_name && out_pos.zpkt >= 0)
+                checkpoint::truncate_output(*config.zpkt_out_file_name, out_pos.zpkt);
+
+            if (config.rate_out_file_name && out_pos.rate >= 0)
+                checkpoint::truncate_output(*config.rate_out_file_name, out_pos.rate);
+
+        } catch (const std::exception& e) {
+            std::cerr << "error: could not resume: " << e.what() << ", exiting." << std::endl;
+            exit(1);
+        }
+
+        processed_file_set.insert(processed_files.begin(), processed_files.end());
+        remove_processed_files(in_files);
+
+        std::cout << "- resuming from " << *config.checkpoint_file_name << " after "
+                  << processed_files.size() << " input files" << std::endl;
+
+        if (in_files.empty() && !config.follow_interval_s) {
+            std::cout << "- no new input files, exiting." << std::endl;
+            exit(0);
+        }
     }
 
+    // the pcap output is opened with the link type of the first input file
+    std::optional<pcap_link_type> pcap_out_link_type;
+    bool pcap_out_append = out_pos.pcap >= 0;
+
     if (config.flows_out_file_name) {
         flows_out.open(*config.flows_out_file_name);
 
@@ -41,62 +171,245 @@ int main(int argc, char** argv) {
     }
 
     if (config.rate_out_file_name) {
-        rate_out.open(*config.rate_out_file_name);
+        rate_out.open(*config.rate_out_file_name, out_pos.rate >= 0);
 
         if (!rate_out.is_open()) {
             std::cerr << "error: could not open rate output file " << *config.rate_out_file_name
                       << ", exiting." << std::endl;
             exit(1);
         }
+
+        if (out_pos.rate < 0) {
+            rate_out << "ts_s,total_pkts,zoom_pkts,zoom_bytes" << std::endl;
+        }
     }
 
     if (config.zpkt_out_file_name) {
-        zpkt_writer.open(*config.zpkt_out_file_name);
+        zpkt_writer.open(*config.zpkt_out_file_name, out_pos.zpkt >= 0);
     }
 
-    pcap_pkt pkt;
-    zoom::flow_tracker flow_tracker;
-    mac_counter mac_counter;
+    if (config.ipv6_nets_file_name) {
 
-    struct pkts_bytes {
-        unsigned long pkts = 0, bytes = 0;
+        try {
+            zoom::nets::load_ipv6_nets(*config.ipv6_nets_file_name);
+        } catch (const std::exception& e) {
+            std::cerr << "error: " << e.what() << ", exiting." << std::endl;
+            exit(1);
+        }
 
-        void increment(unsigned long pkts_inc, unsigned long bytes_inc) {
-            pkts += pkts_inc;
-            bytes += bytes_inc;
+        std::cout << "- matching " << zoom::nets::NETS6.size() << " IPv6 Zoom prefixes from "
+                  << *config.ipv6_nets_file_name << std::endl;
+    }
+
+    if (config.approx_memory_kb) {
+        approx_tracker.emplace(zoom::approx_flow_tracker::config::for_memory(
+            (std::size_t) *config.approx_memory_kb * 1024));
+    }
+
+    // approximate tracking drives filtering unless it is only compared against exact tracking
+    bool exact_tracking = !approx_tracker || config.compare_approx;
+
+    // packets seen by the capture, counted from the source MAC addresses if available
+    auto total_pkts = [&]() {
+        return mac_counter.count() + pkts_without_mac;
+    };
+
+    auto zoom_pkts_detected = [&]() {
+        return exact_tracking ? flow_tracker.count_zoom_pkts_detected()
+                              : approx_tracker->count_zoom_pkts_detected();
+    };
+
+    auto zoom_bytes_detected = [&]() {
+        return exact_tracking ? flow_tracker.count_zoom_bytes_detected()
+                              : approx_tracker->count_zoom_bytes_detected();
+    };
+
+    // flushes the continuously written outputs and records their sizes
+    auto flush_outputs = [&]() {
+
+        if (pcap_out_link_type) {
+            out_pos.pcap = pcap_out.flush();
+        }
+        out_pos.zpkt = config.zpkt_out_file_name ? zpkt_writer.flush() : -1;
+
+        if (config.rate_out_file_name) {
+            out_pos.rate = rate_out.flush_position();
         }
     };
 
-    std::array<pkts_bytes, 256> p2p_inner_types, srv_inner_types, srv_outer_types;
+    // writes the state after all of processed_files have been processed completely
+    auto write_checkpoint = [&]() {
+
+        flush_outputs();
+
+        checkpoint::writer checkpoint_out(*config.checkpoint_file_name, "zoom_flows");
+        checkpoint_out.write(processed_files);
+        flow_tracker.save(checkpoint_out);
+        checkpoint_out.write(p2p_inner_types);
+        checkpoint_out.write(srv_inner_types);
+        checkpoint_out.write(srv_outer_types);
+        mac_counter.save(checkpoint_out);
+        checkpoint_out.write(pkts_without_mac);
+        checkpoint_out.write(last_ts);
+        checkpoint_out.write(last_total_pkt_count);
+        checkpoint_out.write(last_zoom_pkt_count);
+        checkpoint_out.write(last_zoom_byte_count);
+        checkpoint_out.write(out_pos);
+        checkpoint_out.write(dedup.has_value());
+
+        if (dedup) {
+            dedup->save(checkpoint_out);
+        }
 
-    pcap_file_reader pcap_in(in_files);
+        checkpoint_out.commit();
+    };
 
-    if (pcap_in.datalink_type() != pcap_link_type::eth) {
-        std::cerr << "error: only ethernet supported right now, exiting." << std::endl;
-        exit(1);
-    }
+    // (re)writes the flow and type summaries from the current state
+    auto write_summaries = [&]() {
 
-    unsigned last_ts = 0;
-    std::uint64_t last_total_pkt_count = 0, last_zoom_pkt_count = 0, last_zoom_byte_count = 0;
+        if (config.flows_out_file_name) {
+
+            if (!flows_out.is_open()) {
+                flows_out.open(*config.flows_out_file_name);
+            }
+
+            flows_out << "flow_id,ip_proto,ip_src,tp_src,ip_dst,tp_dst,type,pkts,bytes,"
+                      << "start_ts_tvs,start_ts_tvus,end_ts_tvs,end_ts_tvus";
+
+            if (config.bidirectional) {
+                flows_out << ",dir,pkts_to_srv,bytes_to_srv,pkts_from_srv,bytes_from_srv";
+            }
+
+            flows_out << std::endl;
+
+            auto write_flow = [&](const auto& ip_5t, const zoom::flow_tracker::flow_stats& stats) {
+                flows_out << stats.id << "," << ip_5t << ","
+                          << zoom::flow_tracker::flow_type_string(stats.type) << ","
+                          << stats.pkts << "," << stats.bytes << ","
+                          << stats.start_ts.tv_sec << "," << stats.start_ts.tv_usec << ","
+                          << stats.last_ts.tv_sec << "," << stats.last_ts.tv_usec;
+
+                if (config.bidirectional) {
+                    flows_out << "," << zoom::flow_tracker::flow_dir_string(stats.dir) << ","
+                              << stats.pkts_to_srv << "," << stats.bytes_to_srv << ","
+                              << stats.pkts_from_srv << "," << stats.bytes_from_srv;
+                }
+
+                flows_out << std::endl;
+            };
+
+            for (const auto& [ip_5t, stats]: flow_tracker.flows()) {
+                write_flow(ip_5t, stats);
+            }
+
+            for (const auto& [ip_5t, stats]: flow_tracker.flows6()) {
+                write_flow(ip_5t, stats);
+            }
+
+            flows_out.close();
+        }
+
+        if (config.types_out_file_name) {
+
+            if (!types_out.is_open()) {
+                types_out.open(*config.types_out_file_name);
+            }
+
+            types_out << "mode,outer_type,inner_type,pkts,bytes" << std::endl;
+
+            for (unsigned type = 0; type < 256; type++) {
+                if (p2p_inner_types[type].pkts > 0) {
+                    types_out << "p2p,NA," << (unsigned) type << "," << p2p_inner_types[type].pkts
+                              << "," << p2p_inner_types[type].bytes << std::endl;
+                }
+            }
+
+            for (unsigned type = 0; type < 256; type++) {
+                if (srv_inner_types[type].pkts > 0) {
+                    types_out << "srv,5," << (unsigned) type << "," << srv_inner_types[type].pkts
+                              << "," << srv_inner_types[type].bytes << std::endl;
+                }
+            }
+
+            for (unsigned type = 0; type < 256; type++) {
+                if (type != 5 && srv_outer_types[type].pkts > 0) {
+                    types_out << "srv," << (unsigned) type << ",NA," << srv_outer_types[type].pkts
+                              << "," << srv_outer_types[type].bytes << std::endl;
+                }
+            }
+
+            types_out.close();
+        }
+    };
 
+    unsigned input_file_count = 0;
+    unsigned long pkt_count = 0;
+    double time_in_loop = 0;
+
+    auto mark_processed = [&](const std::vector<std::string>& files, unsigned from, unsigned to) {
+        for (unsigned i = from; i < to; i++) {
+            processed_files.push_back(files[i]);
+            processed_file_set.insert(files[i]);
+        }
+    };
 
-    while (pcap_in.next(pkt)) {
+    // counts, writes and forwards a packet of a Zoom flow, net_hdr is zoom::net_headers or
+    // zoom::net6_headers
+    auto process_zoom_pkt = [&](const pcap_pkt& pkt, const auto& net_hdr,
+                                const zoom::flow_tracker::flow_stats& zoom_flow) {
+
+        // p2p-only option:
+        if (config.p2p_only && !zoom_flow.is_p2p() && !zoom_flow.is_stun()) return;
+
+        auto hdr = zoom_flow.is_p2p() ? zoom::parse_zoom_hdrs<true>(pkt.buf, net_hdr)
+                                      : zoom::parse_zoom_hdrs<false>(pkt.buf, net_hdr);
+
+        if (zoom_flow.type == zoom::flow_tracker::flow_type::udp_p2p) {
+            p2p_inner_types[hdr.zoom_inner[0]].increment(1, net_hdr.udp_dgram_len);
+        } else if (zoom_flow.type == zoom::flow_tracker::flow_type::udp_srv) {
+
+            srv_outer_types[hdr.zoom_outer[0]].increment(1, net_hdr.udp_dgram_len);
+
+            if (hdr.zoom_outer[0] == zoom::SRV_MEDIA_TYPE) {
+                srv_inner_types[hdr.zoom_inner[0]].increment(1, net_hdr.udp_dgram_len);
+            }
+        }
+
+        if (config.zpkt_out_file_name && zoom_flow.is_udp()) {
+            zoom::pkt zpkt{net_hdr, hdr, pkt.ts, pkt.frame_len, zoom_flow.is_p2p()};
+            zpkt_writer.write(zpkt);
+        }
+
+        if (config.pcap_out_file_name) {
+            pcap_out.write(pkt);
+        }
+    };
+
+    // processes a packet with link layer framing L, which is resolved per file (VLAN tags per
+    // frame) so that the parsers below are specialized and free of link layer branches
+    auto process_pkt = [&](auto link_layer, const pcap_pkt& pkt) {
+
+        constexpr net::link_layer L = decltype(link_layer)::value;
 
         if (config.rate_out_file_name) {
-            mac_counter.add(((net::eth::hdr*) pkt.buf)->src_addr);
+
+            // the capture encodes a packet counter in the source MAC address
+            if constexpr (L == net::link_layer::eth || L == net::link_layer::eth_vlan) {
+                mac_counter.add(((net::eth::hdr*) pkt.buf)->src_addr);
+            } else {
+                pkts_without_mac++;
+            }
 
             if (last_ts == 0) {
                 last_ts = pkt.ts.tv_sec;
-                last_total_pkt_count = mac_counter.count();
-
-                rate_out << "ts_s,total_pkts,zoom_pkts,zoom_bytes" << std::endl;
+                last_total_pkt_count = total_pkts();
             }
 
             if (pkt.ts.tv_sec > last_ts) {
 
-                std::uint64_t current_total_pkt_count = mac_counter.count();
-                std::uint64_t current_zoom_pkt_count = flow_tracker.count_zoom_pkts_detected();
-                std::uint64_t current_zoom_byte_count = flow_tracker.count_zoom_bytes_detected();
+                std::uint64_t current_total_pkt_count = total_pkts();
+                std::uint64_t current_zoom_pkt_count = zoom_pkts_detected();
+                std::uint64_t current_zoom_byte_count = zoom_bytes_detected();
 
                 rate_out << last_ts << ","
                          << (current_total_pkt_count - last_total_pkt_count)
@@ -111,102 +424,229 @@ int main(int argc, char** argv) {
             }
         }
 
-        // must be IPv4
-        if (net::eth::type_from_buf(pkt.buf) != net::eth::type::ipv4) continue;
+        // must be IPv4, or IPv6 if IPv6 Zoom prefixes were given (only tracked exactly)
+        if (!net::is_ipv4<L>(pkt.buf)) {
 
-        auto ip_5t = net::ipv4_5tuple::from_ipv4_pkt_data(pkt.buf + net::eth::HDR_LEN);
-        auto zoom_flow = flow_tracker.track(ip_5t, pkt.ts, pkt.frame_len);
+            if (config.ipv6_nets_file_name && exact_tracking && net::is_ipv6<L>(pkt.buf)) {
 
-        if (zoom_flow) {
+                auto net6_hdr = zoom::parse_net6_hdrs<L>(pkt.buf);
 
-            // p2p-only option:
-            if (config.p2p_only && !zoom_flow->is_p2p() && !zoom_flow->is_stun()) continue;
+                if (auto zoom_flow = flow_tracker.track(net6_hdr.ip_5t, pkt.ts, pkt.frame_len)) {
+                    process_zoom_pkt(pkt, net6_hdr, *zoom_flow);
+                }
+            }
 
-            auto hdr = zoom::parse_zoom_pkt_buf(pkt.buf, true, zoom_flow->is_p2p());
+            return;
+        }
 
-            if (zoom_flow->type == zoom::flow_tracker::flow_type::udp_p2p) {
-                p2p_inner_types[hdr.zoom_inner[0]].increment(1, ntohs(hdr.udp->dgram_len));
-            } else if (zoom_flow->type == zoom::flow_tracker::flow_type::udp_srv) {
+        auto net_hdr = zoom::parse_net_hdrs<L>(pkt.buf);
+        const auto& ip_5t = net_hdr.ip_5t;
 
-                srv_outer_types[hdr.zoom_outer[0]].increment(1, ntohs(hdr.udp->dgram_len));
+        // packets truncated before the end of the IP header are never counted as duplicates
+        if (dedup) {
+            auto ip_offset = (std::size_t) ((const unsigned char*) net_hdr.ip - pkt.buf);
 
-                if (hdr.zoom_outer[0] == zoom::SRV_MEDIA_TYPE) {
-                    srv_inner_types[hdr.zoom_inner[0]].increment(1, ntohs(hdr.udp->dgram_len));
-                }
-            }
+            if (pkt.cap_len > ip_offset && pkt.cap_len >= ip_offset + net_hdr.ip->ihl_bytes()) {
+
+                std::size_t ip_len = pkt.cap_len - ip_offset;
 
-            if (config.zpkt_out_file_name && zoom_flow->is_udp()) {
-                zoom::pkt zpkt{hdr, pkt.ts, pkt.frame_len, zoom_flow->is_p2p()};
-                zpkt_writer.write(zpkt);
+                if (dedup->is_duplicate(net_hdr.ip, ip_5t, ip_len, pkt.ts))
+                    return;
             }
+        }
 
-            if (config.pcap_out_file_name) {
-                pcap_out.write(pkt);
+        std::optional<zoom::flow_tracker::flow_stats> zoom_flow;
+
+        if (exact_tracking) {
+            zoom_flow = flow_tracker.track(ip_5t, pkt.ts, pkt.frame_len);
+        }
+
+        if (approx_tracker) {
+            auto approx_flow = approx_tracker->track(ip_5t, pkt.ts, pkt.frame_len);
+
+            if (config.compare_approx) {
+                approx_comparison.add(zoom_flow, approx_flow);
+            } else {
+                zoom_flow = approx_flow;
             }
         }
 
-        if ((pcap_in.pkt_count() % 10000000) == 0) {
-            std::cout << "- " << pcap_in.pkt_count() << std::endl;
+        if (zoom_flow) {
+            process_zoom_pkt(pkt, net_hdr, *zoom_flow);
         }
-    }
+    };
 
-    pcap_in.close();
+    auto process_files = [&](const std::vector<std::string>& files) {
 
-    if (config.pcap_out_file_name) {
-        pcap_out.close();
-    }
+        pcap_file_reader pcap_in(files);
+        auto link_type = pcap_in.datalink_type();
 
-    if (config.flows_out_file_name) {
-        flows_out << "flow_id,ip_proto,ip_src,tp_src,ip_dst,tp_dst,type,pkts,bytes,"
-                  << "start_ts_tvs,start_ts_tvus,end_ts_tvs,end_ts_tvus" << std::endl;
+        if (link_type != pcap_link_type::eth && link_type != pcap_link_type::raw
+            && (int) link_type != DLT_RAW && link_type != pcap_link_type::loop
+            && link_type != pcap_link_type::null && link_type != pcap_link_type::ipv4
+            && link_type != pcap_link_type::ipv6) {
+            std::cerr << "error: unsupported link type " << (int) link_type
+                      << " (supported: ethernet, raw IP, loopback), exiting." << std::endl;
+            exit(1);
+        }
 
-        for (const auto& [ip_5t, stats]: flow_tracker.flows()) {
-            flows_out << stats.id << "," << ip_5t << ","
-                      << zoom::flow_tracker::flow_type_string(stats.type) << "," << stats.pkts << ","
-                      << stats.bytes << "," << stats.start_ts.tv_sec << "," << stats.start_ts.tv_usec
-                      << "," << stats.last_ts.tv_sec << "," << stats.last_ts.tv_usec << std::endl;
+        if (config.pcap_out_file_name && !pcap_out_link_type) {
+            pcap_out.open(*config.pcap_out_file_name, link_type, pcap_out_append);
+            pcap_out_link_type = link_type;
+        } else if (config.pcap_out_file_name && *pcap_out_link_type != link_type) {
+            std::cerr << "error: link type of " << files.front()
+                      << " differs from earlier input files, exiting." << std::endl;
+            exit(1);
         }
 
-        flows_out.close();
-    }
+        unsigned current_file = 0;
 
-    if (config.types_out_file_name) {
+        auto next_pkt = [&]() {
 
-        types_out << "mode,outer_type,inner_type,pkts,bytes" << std::endl;
+            if (!pcap_in.next(pkt)) return false;
 
-        for (unsigned type = 0; type < 256; type++) {
-            if (p2p_inner_types[type].pkts > 0) {
-                types_out << "p2p,NA," << (unsigned) type << "," << p2p_inner_types[type].pkts
-                          << "," << p2p_inner_types[type].bytes << std::endl;
+            if (pcap_in.current_file() != current_file) {
+                mark_processed(files, current_file, pcap_in.current_file());
+                current_file = pcap_in.current_file();
+
+                if (config.checkpoint_file_name) {
+                    write_checkpoint();
+                }
             }
-        }
 
-        for (unsigned type = 0; type < 256; type++) {
-            if (srv_inner_types[type].pkts > 0) {
-                types_out << "srv,5," << (unsigned) type << "," << srv_inner_types[type].pkts
-                          << "," << srv_inner_types[type].bytes << std::endl;
+            if ((++pkt_count % 10000000) == 0) {
+                std::cout << "- " << pkt_count << std::endl;
+            }
+
+            return true;
+        };
+
+        if (link_type == pcap_link_type::eth) {
+            while (next_pkt()) {
+                if (net::is_vlan_tagged(pkt.buf)) {
+                    process_pkt(net::link_layer_tag<net::link_layer::eth_vlan>{}, pkt);
+                } else {
+                    process_pkt(net::link_layer_tag<net::link_layer::eth>{}, pkt);
+                }
+            }
+        } else if (link_type == pcap_link_type::loop || link_type == pcap_link_type::null) {
+            while (next_pkt()) {
+                process_pkt(net::link_layer_tag<net::link_layer::loop>{}, pkt);
+            }
+        } else {
+            // raw IP: DLT_RAW, LINKTYPE_RAW, LINKTYPE_IPV4 and LINKTYPE_IPV6
+            while (next_pkt()) {
+                process_pkt(net::link_layer_tag<net::link_layer::raw>{}, pkt);
             }
         }
 
-        for (unsigned type = 0; type < 256; type++) {
-            if (type != 5 && srv_outer_types[type].pkts > 0) {
-                types_out << "srv," << (unsigned) type << ",NA," << srv_outer_types[type].pkts
-                          << "," << srv_outer_types[type].bytes << std::endl;
+        pcap_in.close();
+        mark_processed(files, current_file, files.size());
+        input_file_count += pcap_in.file_count();
+        time_in_loop += pcap_in.time_in_loop();
+
+        if (config.checkpoint_file_name) {
+            write_checkpoint();
+        }
+    };
+
+    if (!in_files.empty()) {
+        process_files(in_files);
+    }
+
+    if (config.follow_interval_s) {
+
+        std::signal(SIGINT, request_stop);
+        std::signal(SIGTERM, request_stop);
+
+        std::cout << "- following " << config.input_path << " every " << *config.follow_interval_s
+                  << "s, stop with Ctrl+C" << std::endl;
+
+        while (!stop_requested) {
+
+            flush_outputs();
+            write_summaries();
+
+            auto poll_end = std::chrono::steady_clock::now()
+                            + std::chrono::seconds(*config.follow_interval_s);
+
+            while (!stop_requested && std::chrono::steady_clock::now() < poll_end) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+
+            if (stop_requested) break;
+
+            auto new_files = list_input_files();
+            remove_processed_files(new_files);
+
+            if (!new_files.empty()) {
+                std::cout << "- processing " << new_files.size() << " new input file(s)"
+                          << std::endl;
+                process_files(new_files);
             }
         }
+    }
 
-        types_out.close();
+    if (pcap_out_link_type) {
+        pcap_out.close();
     }
 
     if (config.zpkt_out_file_name) {
         zpkt_writer.close();
     }
 
-    std::cout << "- input files: " << pcap_in.file_count() << std::endl;
-    std::cout << "- total pkts: " << flow_tracker.count_total_pkts_processed() << std::endl;
-    std::cout << "- zoom pkts: " << flow_tracker.count_zoom_pkts_detected() << std::endl;
-    std::cout << "- zoom flows: " << flow_tracker.count_zoom_flows_detected() << std::endl;
-    std::cout << "- runtime [s]: " << std::fixed << std::setw(3) << pcap_in.time_in_loop()
+    write_summaries();
+
+    std::cout << "- input files: " << input_file_count << std::endl;
+
+    if (held_back_file && !processed_file_set.count(*held_back_file)) {
+        std::cout << "- skipped newest input file " << *held_back_file
+                  << ", which may still be written to" << (config.checkpoint_file_name
+                      ? " (resume with -R without -F to process it)" : "") << std::endl;
+    }
+
+    if (exact_tracking) {
+        std::cout << "- total pkts: " << flow_tracker.count_total_pkts_processed() << std::endl;
+        std::cout << "- zoom pkts: " << flow_tracker.count_zoom_pkts_detected() << std::endl;
+        std::cout << "- zoom flows: " << flow_tracker.count_zoom_flows_detected() << std::endl;
+    }
+
+    if (dedup) {
+        std::cout << "- dedup: dropped " << dedup->dropped_count() << "/" << dedup->checked_count()
+                  << " pkts within " << dedup->window_us() << " us (memory [B]: "
+                  << dedup->memory_bytes() << ")" << std::endl;
+    }
+
+    if (approx_tracker) {
+        std::cout << "- approx: total pkts: " << approx_tracker->count_total_pkts_processed()
+                  << std::endl;
+        std::cout << "- approx: zoom pkts: " << approx_tracker->count_zoom_pkts_detected()
+                  << std::endl;
+        std::cout << "- approx: memory [B]: " << approx_tracker->memory_bytes() << std::endl;
+        std::cout << "- approx: peer filter false positive rate: "
+                  << approx_tracker->peer_filter_false_positive_rate() << std::endl;
+        std::cout << "- approx: pkts/bytes error bound (p=" << approx_tracker->error_bound_confidence()
+                  << "): " << approx_tracker->pkts_error_bound() << "/"
+                  << approx_tracker->bytes_error_bound() << std::endl;
+    }
+
+    if (config.compare_approx) {
+        approx_comparison.add_counter_errors(flow_tracker, *approx_tracker);
+
+        std::cout << "- compare: pkts agree: " << approx_comparison.agree << "/"
+                  << approx_comparison.pkts << std::endl;
+        std::cout << "- compare: false positives: " << approx_comparison.false_positives
+                  << ", false negatives: " << approx_comparison.false_negatives
+                  << ", type mismatches: " << approx_comparison.type_mismatches << std::endl;
+        std::cout << "- compare: pkts rel. error (mean/max): "
+                  << approx_comparison.mean_pkts_rel_error << "/"
+                  << approx_comparison.max_pkts_rel_error << std::endl;
+        std::cout << "- compare: bytes rel. error (mean/max): "
+                  << approx_comparison.mean_bytes_rel_error << "/"
+                  << approx_comparison.max_bytes_rel_error << std::endl;
+    }
+
+    std::cout << "- runtime [s]: " << std::fixed << std::setw(3) << time_in_loop
               << std::endl;
 
     if (config.flows_out_file_name) {
@@ -221,6 +661,10 @@ int main(int argc, char** argv) {
         std::cout << "- wrote rate summary to " << *config.rate_out_file_name << std::endl;
     }
 
+    if (config.checkpoint_file_name) {
+        std::cout << "- wrote checkpoint to " << *config.checkpoint_file_name << std::endl;
+    }
+
     if (config.pcap_out_file_name) {
         std::cout << "- wrote " << pcap_out.count() << " filtered packets to "
                   << *config.pcap_out_file_name << std::endl;
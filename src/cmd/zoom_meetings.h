@@ -79,12 +79,13 @@ namespace zoom_meetings {
         std::uint16_t tp_dst = 0;
         std::uint8_t zoom_type = 0;
         bool p2p = false;
+        bool ipv6 = false; // ip_src and ip_dst are address digests (see zoom::pkt)
 
         bool operator<(const stream_key &other) const {
 
-            return std::tie(ssrc, ip_src, tp_src, ip_dst, tp_dst, zoom_type, p2p) <
+            return std::tie(ssrc, ip_src, tp_src, ip_dst, tp_dst, zoom_type, p2p, ipv6) <
                    std::tie(other.ssrc, other.ip_src, other.tp_src, other.ip_dst, other.tp_dst,
-                            other.zoom_type, other.p2p);
+                            other.zoom_type, other.p2p, other.ipv6);
         }
 
         static struct stream_key from_pkt(const zoom::pkt& pkt) {
@@ -97,7 +98,8 @@ namespace zoom_meetings {
                     .ip_dst    = pkt.ip_5t.ip_dst,
                     .tp_dst    = pkt.ip_5t.tp_dst,
                     .zoom_type = pkt.zoom_media_type,
-                    .p2p       = (bool) pkt.flags.p2p
+                    .p2p       = (bool) pkt.flags.p2p,
+                    .ipv6      = (bool) pkt.flags.ipv6
                 };
             } else {
                 throw std::logic_error("stream_key::from_pkt: pkt record is not an rtp packet");
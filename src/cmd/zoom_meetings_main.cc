@@ -114,9 +114,9 @@ struct streams {
                     << (stream_key.p2p ? "udp_p2p" : "udp_srv") << ","
                     << stream_state.start_ts_s << ","
                     << stream_state.end_ts_s << ","
-                    << net::ipv4::addr_to_str(stream_key.ip_src) << ","
+                    << (stream_key.ipv6 ? "NA" : net::ipv4::addr_to_str(stream_key.ip_src)) << ","
                     << stream_key.tp_src << ","
-                    << net::ipv4::addr_to_str(stream_key.ip_dst) << ","
+                    << (stream_key.ipv6 ? "NA" : net::ipv4::addr_to_str(stream_key.ip_dst)) << ","
                     << stream_key.tp_dst << ","
                     << (unsigned) stream_key.zoom_type << ","
                     << ssrc << ","
@@ -238,9 +238,9 @@ public:
                     << (stream_key.p2p ? "udp_p2p" : "udp_srv") << ","
                     << stream_state.start_ts_s << ","
                     << stream_state.end_ts_s << ","
-                    << net::ipv4::addr_to_str(stream_key.ip_src) << ","
+                    << (stream_key.ipv6 ? "NA" : net::ipv4::addr_to_str(stream_key.ip_src)) << ","
                     << stream_key.tp_src << ","
-                    << net::ipv4::addr_to_str(stream_key.ip_dst) << ","
+                    << (stream_key.ipv6 ? "NA" : net::ipv4::addr_to_str(stream_key.ip_dst)) << ","
                     << stream_key.tp_dst << ","
                     << (unsigned) stream_key.zoom_type << ","
                     << stream_key.ssrc << ","
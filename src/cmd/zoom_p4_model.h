@@ -0,0 +1,107 @@
+
+#include <cxxopts/cxxopts.h>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <vector>
+
+#include "../lib/net.h"
+#include "../lib/pcap_file_reader.h"
+#include "../lib/util.h"
+#include "../lib/zoom_flow_tracker.h"
+#include "../lib/zoom_p4_model.h"
+
+namespace zoom_p4_model {
+
+    struct config {
+        std::string input_path;
+        std::string p4_src_dir = "p4/src";
+        std::vector<unsigned> idx_widths = {zoom::p4_model::BF_IDX_WIDTH};
+        std::uint32_t time_dur_cutoff = zoom::p4_model::TIME_DUR_CUTOFF;
+        std::optional<std::string> summary_out_file_name = std::nullopt;
+    };
+
+    void print_help(cxxopts::Options& opts, int exit_code = 0) {
+
+        std::ostream& os = (exit_code ? std::cerr : std::cout);
+        os << opts.help({""}) << std::endl;
+        exit(exit_code);
+    }
+
+    cxxopts::Options set_options() {
+
+        cxxopts::Options opts("zoom_p4_model",
+                              "Replays packets through a model of the P4 program and compares "
+                              "with zoom_flows");
+
+        opts.add_options()
+                ("i,in", "input file/path",
+                 cxxopts::value<std::string>(),"IN.pcap or IN/")
+                ("d,p4-dir", "directory with entries_match_*.p4inc (default: p4/src)",
+                 cxxopts::value<std::string>(), "DIR")
+                ("w,idx-width", "comma-separated register index widths (default: 16)",
+                 cxxopts::value<std::string>(), "W,...")
+                ("c,cutoff", "register expiry in units of 2^16 ns (default: 0x9D2922A)",
+                 cxxopts::value<std::string>(), "TICKS")
+                ("o,out", "per-width summary output file (optional)",
+                 cxxopts::value<std::string>(), "OUT.csv")
+                ("h,help", "print this help message");
+
+        return opts;
+    }
+
+    config parse_options(cxxopts::Options opts, int argc, char** argv) {
+
+        config config{};
+
+        auto parsed = opts.parse(argc, argv);
+
+        if (parsed.count("i")) {
+            config.input_path = parsed["i"].as<std::string>();
+        } else {
+            print_help(opts, 1);
+        }
+
+        if (parsed.count("d")) {
+            config.p4_src_dir = parsed["d"].as<std::string>();
+        }
+
+        try {
+
+            if (parsed.count("w")) {
+
+                std::istringstream iss(parsed["w"].as<std::string>());
+                std::string width;
+                config.idx_widths.clear();
+
+                while (std::getline(iss, width, ',')) {
+                    config.idx_widths.push_back((unsigned) std::stoul(width));
+                }
+            }
+
+            if (parsed.count("c")) {
+                config.time_dur_cutoff = (std::uint32_t) std::stoul(parsed["c"].as<std::string>(),
+                                                                    nullptr, 0);
+            }
+
+        } catch (const std::logic_error&) {
+            std::cerr << "error: invalid -w or -c value." << std::endl;
+            print_help(opts, 1);
+        }
+
+        if (config.idx_widths.empty()) {
+            std::cerr << "error: -w requires at least one width." << std::endl;
+            print_help(opts, 1);
+        }
+
+        if (parsed.count("o")) {
+            config.summary_out_file_name = parsed["o"].as<std::string>();
+        }
+
+        if (parsed.count("h")) {
+            print_help(opts);
+        }
+
+        return config;
+    }
+}
@@ -0,0 +1,165 @@
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+
+#include "zoom_p4_model.h"
+
+int main(int argc, char** argv) {
+
+    auto config = zoom_p4_model::parse_options(zoom_p4_model::set_options(), argc, argv);
+    std::ofstream summary_out;
+
+    auto in_files = util::files_in_directory(config.input_path, {"pcap", "pcapng"});
+    std::sort(in_files.begin(), in_files.end(), util::compare_file_ext_seq);
+
+    if (config.summary_out_file_name) {
+        summary_out.open(*config.summary_out_file_name);
+
+        if (!summary_out.is_open()) {
+            std::cerr << "error: could not open summary output file "
+                      << *config.summary_out_file_name << ", exiting." << std::endl;
+            exit(1);
+        }
+    }
+
+    std::vector<zoom::p4_model> models;
+    std::vector<zoom::p4_model::comparison> comparisons(config.idx_widths.size());
+
+    try {
+        for (auto width: config.idx_widths) {
+            models.push_back(zoom::p4_model::from_p4_src_dir(config.p4_src_dir,
+                                                             {width, config.time_dur_cutoff}));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << ", exiting." << std::endl;
+        exit(1);
+    }
+
+    zoom::flow_tracker flow_tracker;
+
+    pcap_file_reader pcap_in(in_files);
+
+    if (pcap_in.datalink_type() != pcap_link_type::eth) {
+        std::cerr << "error: only ethernet supported right now, exiting." << std::endl;
+        exit(1);
+    }
+
+    // packets are replayed through the models in batches, so that their throughput can be
+    // measured separately from reading the input and running the flow tracker
+    struct batch_pkt {
+        net::ipv4_5tuple ip_5t;
+        timeval ts;
+        unsigned frame_len;
+    };
+
+    static const std::size_t BATCH_SIZE = 65536;
+    std::vector<batch_pkt> batch;
+    std::vector<std::vector<std::optional<zoom::flow_tracker::flow_type>>> verdicts(models.size());
+    std::vector<double> model_time_s(models.size(), 0.0);
+    unsigned long long non_ipv4_pkts = 0;
+
+    batch.reserve(BATCH_SIZE);
+
+    auto replay_batch = [&]() {
+
+        for (std::size_t m = 0; m < models.size(); m++) {
+
+            verdicts[m].resize(batch.size());
+            auto start = std::chrono::high_resolution_clock::now();
+
+            for (std::size_t i = 0; i < batch.size(); i++) {
+                verdicts[m][i] = models[m].process(batch[i].ip_5t, batch[i].ts);
+            }
+
+            model_time_s[m] += util::seconds_since(start);
+        }
+
+        for (std::size_t i = 0; i < batch.size(); i++) {
+
+            auto zoom_flow = flow_tracker.track(batch[i].ip_5t, batch[i].ts, batch[i].frame_len);
+
+            for (std::size_t m = 0; m < models.size(); m++) {
+                comparisons[m].add(zoom_flow, verdicts[m][i]);
+            }
+        }
+
+        batch.clear();
+    };
+
+    pcap_pkt pkt;
+
+    while (pcap_in.next(pkt)) {
+
+        // the switch counts but never accepts non-IPv4 packets
+        if (net::eth::type_from_buf(pkt.buf) != net::eth::type::ipv4) {
+            non_ipv4_pkts++;
+            continue;
+        }
+
+        batch.push_back({net::ipv4_5tuple::from_ipv4_pkt_data(pkt.buf + net::eth::HDR_LEN),
+                         pkt.ts, pkt.frame_len});
+
+        if (batch.size() == BATCH_SIZE) {
+            replay_batch();
+        }
+
+        if ((pcap_in.pkt_count() % 10000000) == 0) {
+            std::cout << "- " << pcap_in.pkt_count() << std::endl;
+        }
+    }
+
+    replay_batch();
+    pcap_in.close();
+
+    if (config.summary_out_file_name) {
+        summary_out << "idx_width,register_cells,register_bytes,fill_ratio,pkts,both,neither,"
+                    << "model_only,tracker_only,agreement,model_p2p_pkts,tracker_p2p_pkts,"
+                    << "model_mpps" << std::endl;
+    }
+
+    std::cout << "- input files: " << pcap_in.file_count() << std::endl;
+    std::cout << "- total pkts: " << non_ipv4_pkts + models[0].all_pkts_count() << " (non-IPv4: "
+              << non_ipv4_pkts << ")" << std::endl;
+    std::cout << "- tracker: zoom pkts: " << flow_tracker.count_zoom_pkts_detected() << std::endl;
+
+    for (std::size_t m = 0; m < models.size(); m++) {
+
+        const auto& model = models[m];
+        const auto& cmp = comparisons[m];
+        auto p2p = (unsigned) zoom::flow_tracker::flow_type::udp_p2p;
+        double mpps = model_time_s[m] > 0 ? (double) model.all_pkts_count() / model_time_s[m] / 1e6
+                                          : 0.0;
+
+        std::cout << "- model[" << model.model_config().idx_width << "]: zoom pkts: "
+                  << model.zoom_pkts_count() << ", p2p pkts: " << cmp.model_types[p2p]
+                  << " (tracker: " << cmp.tracker_types[p2p] << ")" << std::endl;
+        std::cout << "- model[" << model.model_config().idx_width << "]: registers: "
+                  << model.register_cells() << " cells, " << model.register_memory_bytes()
+                  << " B, fill ratio: " << model.register_fill_ratio() << std::endl;
+        std::cout << "- model[" << model.model_config().idx_width << "]: agreement: "
+                  << cmp.agreement() << " (model only: " << cmp.model_only << ", tracker only: "
+                  << cmp.tracker_only << ")" << std::endl;
+        std::cout << "- model[" << model.model_config().idx_width << "]: throughput [Mpps]: "
+                  << mpps << std::endl;
+
+        if (config.summary_out_file_name) {
+            summary_out << model.model_config().idx_width << "," << model.register_cells() << ","
+                        << model.register_memory_bytes() << "," << model.register_fill_ratio()
+                        << "," << cmp.pkts << "," << cmp.both << "," << cmp.neither << ","
+                        << cmp.model_only << "," << cmp.tracker_only << "," << cmp.agreement()
+                        << "," << cmp.model_types[p2p] << "," << cmp.tracker_types[p2p] << ","
+                        << mpps << std::endl;
+        }
+    }
+
+    std::cout << "- runtime [s]: " << std::fixed << std::setw(3) << pcap_in.time_in_loop()
+              << std::endl;
+
+    if (config.summary_out_file_name) {
+        summary_out.close();
+        std::cout << "- wrote summary to " << *config.summary_out_file_name << std::endl;
+    }
+
+    return 0;
+}
@@ -1,16 +1,19 @@
 
+#include <array>
 #include <chrono>
 #include <cstdlib>
 #include <cxxopts/cxxopts.h>
 #include <iomanip>
 #include <iostream>
 
+#include "../lib/checkpoint.h"
 #include "../lib/net.h"
 #include "../lib/pcap_file_reader.h"
 #include "../lib/rtp.h"
 #include "../lib/rtp_stream_analyzer.h"
 #include "../lib/util.h"
 #include "../lib/zoom.h"
+#include "../lib/zoom_analyzer.h"
 #include "../lib/zoom_flow_tracker.h"
 
 namespace zoom_rtp {
@@ -22,6 +25,17 @@ namespace zoom_rtp {
         std::optional<std::string> frames_out_path = std::nullopt;
         std::optional<unsigned long> limit = std::nullopt;
         std::optional<std::string> stats_out_path = std::nullopt;
+        //! paths of the rolled-up stats, by zoom::analyzer::STATS_ROLLUP_RESOLUTIONS
+        std::array<std::optional<std::string>, 3> stats_rollup_out_paths = {};
+        std::optional<std::string> checkpoint_path = std::nullopt;
+        bool resume = false;
+        std::optional<std::size_t> async_queue_len = std::nullopt;
+        bool drop_rows = false;
+        unsigned idle_timeout_s = 0;
+        unsigned jobs = 0; //!< worker threads, 0 analyzes on the reader thread
+        bool quantiles = false;
+        bool rfc3550_jitter = false;
+        zoom::analyzer::log_format log_format = zoom::analyzer::log_format::csv;
     };
 
     void print_help(cxxopts::Options& opts, int exit_code = 0) {
@@ -46,8 +60,31 @@ namespace zoom_rtp {
                 cxxopts::value<std::string>(),"OUT.csv")
             ("t,stats-out", "output path for 1s statistics (optional)",
                 cxxopts::value<std::string>(),"OUT.csv")
+            ("stats10-out", "output path for 10s statistics (optional)",
+                cxxopts::value<std::string>(),"OUT.csv")
+            ("stats60-out", "output path for 60s statistics (optional)",
+                cxxopts::value<std::string>(),"OUT.csv")
+            ("stats300-out", "output path for 300s statistics (optional)",
+                cxxopts::value<std::string>(),"OUT.csv")
             ("l,limit", "limit to L packets (in millions)  (optional)",
                 cxxopts::value<unsigned long>(), "L")
+            ("k,checkpoint", "write state to FILE every 10M packets and at the end (optional)",
+                cxxopts::value<std::string>(), "FILE")
+            ("R,resume", "restore state from the -k checkpoint and continue the input")
+            ("async-logs", "write logs on a background thread, queueing up to N rows (power of two)",
+                cxxopts::value<std::size_t>(), "N")
+            ("D,drop-rows", "with --async-logs, drop rows instead of waiting when the queue is "
+                "full")
+            ("I,idle-timeout", "retire streams idle for S seconds, reporting their last frames "
+                "and stream summary right away (optional)", cxxopts::value<unsigned>(), "S")
+            ("j,jobs", "analyze the streams on N worker threads, the logs stay the same "
+                "(optional, not with -k)", cxxopts::value<unsigned>(), "N")
+            ("format", "log format: csv (default) or arrow (Arrow IPC)",
+                cxxopts::value<std::string>(), "FMT")
+            ("Q,quantiles", "add p50/p95/p99 of jitter, frame size, inter-frame gap and fps to "
+                "the stats and streams logs (optional)")
+            ("J,rfc3550-jitter", "compute the frame jitter in fixed point from microsecond "
+                "arrival times as in RFC 3550, instead of from millisecond timestamps (optional)")
             ("h,help", "print this help message");
 
         return opts;
@@ -81,14 +118,79 @@ namespace zoom_rtp {
             config.stats_out_path = parsed["t"].as<std::string>();
         }
 
+        for (std::size_t i = 0; i < zoom::analyzer::STATS_ROLLUP_RESOLUTIONS.size(); i++) {
+
+            auto opt = "stats" + std::to_string(zoom::analyzer::STATS_ROLLUP_RESOLUTIONS[i]) + "-out";
+
+            if (parsed.count(opt)) {
+                config.stats_rollup_out_paths[i] = parsed[opt].as<std::string>();
+            }
+        }
+
         if (parsed.count(("l"))) {
             config.limit = parsed["l"].as<unsigned long>() * 1000000;
         }
 
+        if (parsed.count("k")) {
+            config.checkpoint_path = parsed["k"].as<std::string>();
+        }
+
         if (parsed.count("h")) {
             print_help(opts);
         }
 
+        config.resume = parsed.count("R");
+
+        if (parsed.count("async-logs")) {
+            config.async_queue_len = parsed["async-logs"].as<std::size_t>();
+        }
+
+        config.drop_rows = parsed.count("D");
+
+        if (config.drop_rows && !config.async_queue_len) {
+            std::cerr << "error: -D requires --async-logs." << std::endl;
+            print_help(opts, 1);
+        }
+
+        if (parsed.count("I")) {
+            config.idle_timeout_s = parsed["I"].as<unsigned>();
+        }
+
+        if (parsed.count("j")) {
+            config.jobs = parsed["j"].as<unsigned>();
+        }
+
+        config.quantiles = parsed.count("Q");
+        config.rfc3550_jitter = parsed.count("J");
+
+        if (parsed.count("format")) {
+
+            auto format = parsed["format"].as<std::string>();
+
+            if (format == "arrow") {
+                config.log_format = zoom::analyzer::log_format::arrow;
+            } else if (format != "csv") {
+                std::cerr << "error: unknown log format " << format << "." << std::endl;
+                print_help(opts, 1);
+            }
+        }
+
+        if (config.log_format == zoom::analyzer::log_format::arrow && config.checkpoint_path) {
+            std::cerr << "error: -k requires CSV logs (Arrow IPC logs cannot be resumed)."
+                      << std::endl;
+            print_help(opts, 1);
+        }
+
+        if (config.jobs && config.checkpoint_path) {
+            std::cerr << "error: -j does not support checkpoints (-k)." << std::endl;
+            print_help(opts, 1);
+        }
+
+        if (config.resume && !config.checkpoint_path) {
+            std::cerr << "error: -R requires -k." << std::endl;
+            print_help(opts, 1);
+        }
+
         return config;
     }
 }
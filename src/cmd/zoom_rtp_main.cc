@@ -1,82 +1,267 @@
+#include <type_traits>
+
 #include "../lib/simple_binary_reader.h"
 #include "../lib/zoom_offline_analyzer.h"
+#include "../lib/zoom_parallel_analyzer.h"
 #include "zoom_rtp.h"
 
-int main(int argc, char** argv) {
+namespace {
 
-    auto config = zoom_rtp::parse_options(zoom_rtp::set_options(), argc, argv);
+    //! enables the logs, analyzes the input and prints a summary
+    //! - log_pos: sizes of the logs at the restored checkpoint, -1 if not resumed
+    template <typename Analyzer>
+    int run(const zoom_rtp::config& config, Analyzer& analyzer,
+            simple_binary_reader<zoom::pkt>& pkt_reader, zoom::analyzer::log_positions log_pos) {
 
-    zoom::pkt pkt;
-    simple_binary_reader<zoom::pkt> pkt_reader(config.input_path);
-    zoom::offline_analyzer analyzer;
-    unsigned long pkt_count = 0;
+        zoom::pkt pkt;
+        unsigned long pkt_count = 0;
 
-    if (config.pkts_out_path) {
-        analyzer.enable_pkt_log(*config.pkts_out_path);
-    }
+        if (config.pkts_out_path) {
+            analyzer.enable_pkt_log(*config.pkts_out_path, log_pos.pkt >= 0, config.log_format);
+        }
 
-    if (config.streams_out_path) {
-        analyzer.enable_streams_log(*config.streams_out_path);
-    }
+        if (config.streams_out_path) {
+            analyzer.enable_streams_log(*config.streams_out_path, log_pos.streams >= 0,
+                                        config.log_format);
+        }
 
-    if (config.frames_out_path) {
-        analyzer.enable_frame_log(*config.frames_out_path);
-    }
+        if (config.frames_out_path) {
+            analyzer.enable_frame_log(*config.frames_out_path, log_pos.frame >= 0,
+                                      config.log_format);
+        }
 
-    if (config.stats_out_path) {
-        analyzer.enable_stats_log(*config.stats_out_path);
-    }
+        if (config.stats_out_path) {
+            analyzer.enable_stats_log(*config.stats_out_path, log_pos.stats >= 0,
+                                      config.log_format);
+        }
+
+        for (std::size_t i = 0; i < config.stats_rollup_out_paths.size(); i++) {
+
+            if (config.stats_rollup_out_paths[i]) {
+                analyzer.enable_stats_log(*config.stats_rollup_out_paths[i],
+                                          log_pos.stats_rollups[i] >= 0, config.log_format,
+                                          zoom::analyzer::STATS_ROLLUP_RESOLUTIONS[i]);
+            }
+        }
+
+        if (config.async_queue_len) {
+
+            try {
+                analyzer.enable_async_logs(*config.async_queue_len, config.drop_rows
+                                           ? zoom::analyzer::overflow_policy::drop
+                                           : zoom::analyzer::overflow_policy::block);
+            } catch (const std::exception& e) {
+                std::cerr << "error: " << e.what() << ", exiting." << std::endl;
+                exit(1);
+            }
+        }
+
+        analyzer.set_idle_timeout(config.idle_timeout_s);
 
-    std::cout << "- " << pkt_reader.size() << " packets in trace" << std::endl;
+        auto write_checkpoint = [&]() {
 
-    while(pkt_reader.next(pkt)) {
+            // checkpoints are rejected with -j by parse_options()
+            if constexpr (std::is_same_v<Analyzer, zoom::offline_analyzer>) {
+                checkpoint::writer checkpoint_out(*config.checkpoint_path, "zoom_rtp");
+                checkpoint_out.write(config.input_path);
+                checkpoint_out.write(pkt_reader.skipped() + pkt_reader.count());
+                checkpoint_out.write(analyzer.flush_logs());
+                analyzer.save(checkpoint_out);
+                checkpoint_out.commit();
+            }
+        };
+
+        std::cout << "- " << pkt_reader.size() << " packets in trace" << std::endl;
+
+        while(pkt_reader.next(pkt)) {
 
-        if (pkt.flags.rtp) {
+            if (pkt.flags.rtp) {
+
+                if (pkt.proto.rtp.pt == 98 || pkt.proto.rtp.pt == 99 || pkt.proto.rtp.pt == 110
+                    || pkt.proto.rtp.pt == 112 || pkt.proto.rtp.pt == 113) {
+
+                    analyzer.add(pkt);
+                }
+            }
 
-            if (pkt.proto.rtp.pt == 98 || pkt.proto.rtp.pt == 99 || pkt.proto.rtp.pt == 110
-                || pkt.proto.rtp.pt == 112 || pkt.proto.rtp.pt == 113) {
+            if ((++pkt_count % 10000000) == 0) { // every 10M packets
+                std::cout << "- " << pkt_count << '/' << pkt_reader.size() << ": "
+                          << (unsigned) (((double) pkt_count / (double) pkt_reader.size()) * 100)
+                          << "%"
+                          << std::endl;
 
-                analyzer.add(pkt);
+                if (config.checkpoint_path) {
+                    write_checkpoint();
+                }
+            }
+
+            if (config.limit && pkt_count == *config.limit) {
+                break;
             }
         }
 
-        if ((++pkt_count % 10000000) == 0) { // every 10M packets
-            std::cout << "- " << pkt_count << '/' << pkt_reader.size() << ": "
-                      << (unsigned) (((double) pkt_count / (double) pkt_reader.size()) * 100) << "%"
-                      << std::endl;
+        if (config.checkpoint_path) {
+            write_checkpoint();
         }
 
-        if (config.limit && pkt_count == *config.limit) {
-            break;
+        // before retiring the streams, allocated memory is kept until the end
+        const auto memory = analyzer.memory_usage();
+
+        // reports the last frames and stats of all streams, after the checkpoint such that
+        // resuming truncates the logs to before the retired streams
+        if (config.idle_timeout_s) {
+            analyzer.retire_streams();
+        } else {
+            // the last second and the open rollup intervals of the streams kept until the end
+            analyzer.flush_stats();
         }
-    }
 
-    if (config.streams_out_path) {
-        analyzer.write_streams_log();
-    }
+        if (config.streams_out_path) {
+            analyzer.write_streams_log();
+        }
+
+        // waits for the async log writer to write all queued rows
+        analyzer.flush_logs();
+
+        std::cout << "- pkts: " << pkt_reader.count() << " packets"
+                  << (config.limit ? " (limited)" : "") << std::endl;
+
+        std::cout << "- runtime [s]: " << pkt_reader.time_in_loop() << std::endl;
+
+        if (config.idle_timeout_s) {
+            std::cout << "- streams: " << analyzer.retired_streams() << " retired" << std::endl;
+        }
 
-    std::cout << "- pkts: " << pkt_reader.count() << " packets"
-              << (config.limit ? " (limited)" : "") << std::endl;
+        const char* media_types[] = {"audio", "video", "screen"};
 
-    std::cout << "- runtime [s]: " << pkt_reader.time_in_loop() << std::endl;
+        for (std::size_t i = 0; i < memory.size(); i++) {
+            std::cout << "- " << media_types[i] << " streams: " << memory[i].streams
+                      << " (ring of " << memory[i].ring_len << " pkts, "
+                      << memory[i].stream_bytes << " Bytes each), " << memory[i].bytes
+                      << " Bytes allocated" << std::endl;
+        }
+
+        if (config.async_queue_len) {
+            auto stats = analyzer.async_stats();
+            std::cout << "- async logs: " << stats.rows << " rows, max. queue depth "
+                      << stats.max_depth << "/" << stats.queue_len << ", " << stats.stalls
+                      << " stalls, " << stats.drops << " drops" << std::endl;
+        }
+
+        if (config.checkpoint_path) {
+            std::cout << "- wrote checkpoint to " << *config.checkpoint_path << std::endl;
+        }
 
-    if (config.pkts_out_path) {
-        std::cout << "- wrote packets to " << *config.pkts_out_path << std::endl;
+        if (config.pkts_out_path) {
+            std::cout << "- wrote packets to " << *config.pkts_out_path << std::endl;
+        }
+
+        if (config.streams_out_path) {
+            std::cout << "- wrote streams to " << *config.streams_out_path << std::endl;
+        }
+
+        if (config.frames_out_path) {
+            std::cout << "- wrote frames to " << *config.frames_out_path << std::endl;
+        }
+
+        if (config.stats_out_path) {
+            std::cout << "- wrote stats to " << *config.stats_out_path << std::endl;
+        }
+
+        for (std::size_t i = 0; i < config.stats_rollup_out_paths.size(); i++) {
+
+            if (config.stats_rollup_out_paths[i]) {
+                std::cout << "- wrote " << zoom::analyzer::STATS_ROLLUP_RESOLUTIONS[i]
+                          << "s stats to " << *config.stats_rollup_out_paths[i] << std::endl;
+            }
+        }
+
+        pkt_reader.close();
+
+        return 0;
     }
+}
 
-    if (config.streams_out_path) {
-        std::cout << "- wrote streams to " << *config.streams_out_path << std::endl;
+int main(int argc, char** argv) {
+
+    auto config = zoom_rtp::parse_options(zoom_rtp::set_options(), argc, argv);
+
+    simple_binary_reader<zoom::pkt> pkt_reader(config.input_path);
+
+    if (config.jobs) {
+        zoom::parallel_analyzer analyzer(config.jobs);
+
+        if (config.rfc3550_jitter) {
+            analyzer.enable_rfc3550_jitter();
+        }
+
+        // adds the quantile columns to the logs enabled in run()
+        if (config.quantiles) {
+            analyzer.enable_quantiles();
+        }
+
+        std::cout << "- analyzing on " << config.jobs << " worker threads" << std::endl;
+        return run(config, analyzer, pkt_reader, {});
     }
 
-    if (config.frames_out_path) {
-        std::cout << "- wrote frames to " << *config.frames_out_path << std::endl;
+    zoom::offline_analyzer analyzer;
+
+    // before restoring, the checkpoint must have been taken with the same jitter calculator
+    // and with quantiles enabled likewise, as they change the columns of the logs
+    if (config.rfc3550_jitter) {
+        analyzer.enable_rfc3550_jitter();
     }
 
-    if (config.stats_out_path) {
-        std::cout << "- wrote stats to " << *config.stats_out_path << std::endl;
+    if (config.quantiles) {
+        analyzer.enable_quantiles();
     }
 
-    pkt_reader.close();
+    // sizes of the logs at the last checkpoint, -1 if disabled
+    zoom::analyzer::log_positions log_pos;
+
+    if (config.resume && std::filesystem::exists(*config.checkpoint_path)) {
+
+        try {
+            checkpoint::reader checkpoint_in(*config.checkpoint_path, "zoom_rtp");
+
+            auto input_path = checkpoint_in.read<std::string>();
+            auto pkts_done = checkpoint_in.read<unsigned long>();
+            checkpoint_in.read(log_pos);
+            analyzer.restore(checkpoint_in);
+
+            // continue within the same input (e.g., a .zpkt file that was appended to),
+            // otherwise continue the streams with the next input from its start
+            if (input_path == config.input_path) {
+                pkt_reader.skip(pkts_done);
+            }
+
+            if (config.pkts_out_path && log_pos.pkt >= 0)
+                checkpoint::truncate_output(*config.pkts_out_path, log_pos.pkt);
+
+            if (config.streams_out_path && log_pos.streams >= 0)
+                checkpoint::truncate_output(*config.streams_out_path, log_pos.streams);
+
+            if (config.frames_out_path && log_pos.frame >= 0)
+                checkpoint::truncate_output(*config.frames_out_path, log_pos.frame);
+
+            if (config.stats_out_path && log_pos.stats >= 0)
+                checkpoint::truncate_output(*config.stats_out_path, log_pos.stats);
+
+            for (std::size_t i = 0; i < config.stats_rollup_out_paths.size(); i++) {
+
+                if (config.stats_rollup_out_paths[i] && log_pos.stats_rollups[i] >= 0)
+                    checkpoint::truncate_output(*config.stats_rollup_out_paths[i],
+                                                log_pos.stats_rollups[i]);
+            }
+
+        } catch (const std::exception& e) {
+            std::cerr << "error: could not resume: " << e.what() << ", exiting." << std::endl;
+            exit(1);
+        }
+
+        std::cout << "- resuming from " << *config.checkpoint_path << " after "
+                  << pkt_reader.skipped() << " packets" << std::endl;
+    }
 
-    return 0;
+    return run(config, analyzer, pkt_reader, log_pos);
 }
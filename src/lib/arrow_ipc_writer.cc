@@ -0,0 +1,471 @@
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <deque>
+#include <stdexcept>
+
+#include "arrow_ipc_writer.h"
+
+namespace {
+
+    //! Arrow format constants (see format/Message.fbs and format/Schema.fbs of Apache Arrow)
+    namespace fbs {
+        const std::int16_t METADATA_V5       = 4;
+        const std::uint8_t HEADER_SCHEMA     = 1;
+        const std::uint8_t HEADER_BATCH      = 3;
+        const std::uint8_t TYPE_INT          = 2;
+        const std::uint8_t TYPE_FLOAT        = 3;
+        const std::uint8_t TYPE_UTF8         = 5;
+        const std::int16_t PRECISION_DOUBLE  = 2;
+    }
+
+    const char MAGIC[] = "ARROW1";
+
+    /*!
+     * Minimal flatbuffer builder
+     *
+     * - like the reference implementation, objects are prepended to the buffer, so children are
+     *   created before their parents and offsets are counted from the end of the buffer
+     * - supports the subset used by the Arrow metadata: tables with scalar and offset fields,
+     *   strings, vectors of offsets and vectors of structs of 64 bit words
+     */
+    class fb_builder {
+    public:
+
+        using offset = std::uint32_t;
+
+        [[nodiscard]] inline std::size_t size() const {
+            return _buf.size();
+        }
+
+        template <typename T>
+        void push(T v) {
+            _align(sizeof(T));
+            unsigned char bytes[sizeof(T)];
+            std::memcpy(bytes, &v, sizeof(T));
+
+            for (auto i = sizeof(T); i > 0; i--)
+                _buf.push_front(bytes[i - 1]);
+        }
+
+        void push_offset(offset off) {
+            _align(4);
+            push<std::uint32_t>((std::uint32_t) (size() + 4 - off));
+        }
+
+        offset string(std::string_view s) {
+            _align(4, s.size() + 1);
+            _buf.push_front(0);
+
+            for (auto it = s.rbegin(); it != s.rend(); it++)
+                _buf.push_front((unsigned char) *it);
+
+            push<std::uint32_t>((std::uint32_t) s.size());
+            return (offset) size();
+        }
+
+        offset vector(const std::vector<offset>& offsets) {
+            _align(4, offsets.size() * 4);
+
+            for (auto it = offsets.rbegin(); it != offsets.rend(); it++)
+                push_offset(*it);
+
+            push<std::uint32_t>((std::uint32_t) offsets.size());
+            return (offset) size();
+        }
+
+        //! vector of n structs that consist of words.size() / n 64 bit words each
+        offset struct_vector(const std::vector<std::int64_t>& words, std::size_t n) {
+            _align(8, words.size() * 8);
+
+            for (auto it = words.rbegin(); it != words.rend(); it++)
+                push(*it);
+
+            push<std::uint32_t>((std::uint32_t) n);
+            return (offset) size();
+        }
+
+        void start_table() {
+            _fields.clear();
+            _table_start = size();
+        }
+
+        template <typename T>
+        void field(unsigned slot, T v) {
+            push(v);
+            _fields.emplace_back(slot, size());
+        }
+
+        void offset_field(unsigned slot, offset off) {
+            push_offset(off);
+            _fields.emplace_back(slot, size());
+        }
+
+        offset end_table() {
+
+            push<std::int32_t>(0); // vtable offset, set below
+            auto table = size();
+
+            unsigned slots = 0;
+
+            for (const auto& [slot, pos]: _fields)
+                slots = std::max(slots, slot + 1);
+
+            std::vector<std::uint16_t> vtable(slots, 0);
+
+            for (const auto& [slot, pos]: _fields)
+                vtable[slot] = (std::uint16_t) (table - pos);
+
+            for (auto it = vtable.rbegin(); it != vtable.rend(); it++)
+                push(*it);
+
+            push<std::uint16_t>((std::uint16_t) (table - _table_start));
+            push<std::uint16_t>((std::uint16_t) (4 + 2 * slots));
+
+            // the vtable precedes the table: table address - vtable address
+            auto vtable_offset = (std::int32_t) (size() - table);
+            std::memcpy(&_patch, &vtable_offset, 4);
+
+            for (unsigned i = 0; i < 4; i++)
+                _buf[size() - table + i] = _patch[i];
+
+            return (offset) table;
+        }
+
+        std::vector<std::uint8_t> finish(offset root) {
+            _align(_min_align, 4);
+            push_offset(root);
+            return {_buf.begin(), _buf.end()};
+        }
+
+    private:
+
+        //! pads, such that the buffer is aligned to alignment after additional Bytes are added
+        void _align(std::size_t alignment, std::size_t additional = 0) {
+
+            _min_align = std::max(_min_align, alignment);
+
+            while ((size() + additional) % alignment)
+                _buf.push_front(0);
+        }
+
+        std::deque<std::uint8_t> _buf;
+        std::vector<std::pair<unsigned, std::size_t>> _fields;
+        std::size_t _table_start = 0, _min_align = 1;
+        unsigned char _patch[4] = {0};
+    };
+
+    std::size_t width(arrow_ipc_writer::type t) {
+
+        switch (t) {
+            case arrow_ipc_writer::type::uint8:   return 1;
+            case arrow_ipc_writer::type::uint16:  return 2;
+            case arrow_ipc_writer::type::uint32:  return 4;
+            default:                              return 8;
+        }
+    }
+
+    fb_builder::offset build_schema(fb_builder& b, const std::vector<arrow_ipc_writer::column>& cols) {
+
+        std::vector<fb_builder::offset> fields;
+
+        for (const auto& c: cols) {
+
+            auto name = b.string(c.name);
+            auto children = b.vector({});
+            std::uint8_t type_type;
+
+            b.start_table();
+
+            if (c.type == arrow_ipc_writer::type::utf8) {
+                type_type = fbs::TYPE_UTF8;
+            } else if (c.type == arrow_ipc_writer::type::float64) {
+                type_type = fbs::TYPE_FLOAT;
+                b.field<std::int16_t>(0, fbs::PRECISION_DOUBLE);
+            } else {
+                type_type = fbs::TYPE_INT;
+                b.field<std::int32_t>(0, (std::int32_t) (8 * width(c.type)));
+                b.field<std::uint8_t>(1, 0); // is_signed
+            }
+
+            auto type = b.end_table();
+
+            b.start_table();
+            b.offset_field(0, name);
+            b.offset_field(3, type);
+            b.offset_field(5, children);
+            b.field<std::uint8_t>(1, c.nullable);
+            b.field<std::uint8_t>(2, type_type);
+            fields.push_back(b.end_table());
+        }
+
+        auto fields_vec = b.vector(fields);
+
+        b.start_table();
+        b.offset_field(1, fields_vec);
+        b.field<std::int16_t>(0, 0); // little-endian
+        return b.end_table();
+    }
+
+    std::vector<std::uint8_t> message(fb_builder& b, std::uint8_t header_type,
+                                      fb_builder::offset header, std::int64_t body_len) {
+        b.start_table();
+        b.field<std::int64_t>(3, body_len);
+        b.offset_field(2, header);
+        b.field<std::int16_t>(0, fbs::METADATA_V5);
+        b.field<std::uint8_t>(1, header_type);
+        return b.finish(b.end_table());
+    }
+
+    void pad(std::ofstream& os, std::size_t len) {
+        static const char zeros[8] = {0};
+        os.write(zeros, (std::streamsize) ((8 - len % 8) % 8));
+    }
+
+    std::size_t padded(std::size_t len) {
+        return (len + 7) & ~(std::size_t) 7;
+    }
+}
+
+arrow_ipc_writer::arrow_ipc_writer(const std::string& file_path, const std::vector<column>& schema,
+                                   std::size_t batch_rows)
+    : _schema(schema), _columns(schema.size()), _batch_rows(batch_rows) {
+
+    _stream.open(file_path, std::ios::out | std::ios::binary);
+
+    if (!_stream.is_open())
+        throw std::runtime_error("arrow_ipc_writer: could not open file at " + file_path);
+
+    _stream.write(MAGIC, 6);
+    pad(_stream, 6);
+
+    fb_builder b;
+    _write_message(message(b, fbs::HEADER_SCHEMA, build_schema(b, _schema), 0), 0);
+}
+
+arrow_ipc_writer::~arrow_ipc_writer() {
+
+    if (_stream.is_open())
+        close();
+}
+
+arrow_ipc_writer::_column_data& arrow_ipc_writer::_next(enum type t) {
+
+    if (_col >= _schema.size())
+        throw std::logic_error("arrow_ipc_writer: row has more values than columns");
+
+    if (_schema[_col].type != t)
+        throw std::logic_error("arrow_ipc_writer: wrong type for column " + _schema[_col].name);
+
+    auto& c = _columns[_col++];
+
+    if (_rows % 8 == 0)
+        c.validity.push_back(0);
+
+    c.validity.back() |= (std::uint8_t) (1u << (_rows % 8));
+    return c;
+}
+
+void arrow_ipc_writer::_put_int(std::uint64_t v) {
+
+    auto t = _col < _schema.size() ? _schema[_col].type : type::uint64;
+
+    if (t == type::float64 || t == type::utf8)
+        t = type::uint64; // _next() reports the wrong type
+
+    auto& c = _next(t);
+    auto w = width(t);
+    unsigned char bytes[8];
+
+    std::memcpy(bytes, &v, 8);
+    c.values.insert(c.values.end(), bytes, bytes + w);
+}
+
+arrow_ipc_writer& arrow_ipc_writer::put(double v) {
+
+    auto& c = _next(type::float64);
+    unsigned char bytes[8];
+
+    std::memcpy(bytes, &v, 8);
+    c.values.insert(c.values.end(), bytes, bytes + 8);
+    return *this;
+}
+
+arrow_ipc_writer& arrow_ipc_writer::put(std::string_view s) {
+
+    auto& c = _next(type::utf8);
+
+    c.values.insert(c.values.end(), s.begin(), s.end());
+    c.offsets.push_back((std::int32_t) c.values.size());
+    return *this;
+}
+
+arrow_ipc_writer& arrow_ipc_writer::put_ipv4(std::uint32_t addr) {
+
+    char buf[16];
+    char* p = buf;
+
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        p = std::to_chars(p, buf + sizeof(buf), addr >> (unsigned) shift & 0xffu).ptr;
+
+        // always in bounds ("255.255.255.255" takes 15 chars), checked for the compiler
+        if (shift && p < buf + sizeof(buf))
+            *p++ = '.';
+    }
+
+    return put(std::string_view(buf, p - buf));
+}
+
+arrow_ipc_writer& arrow_ipc_writer::put_null() {
+
+    if (_col >= _schema.size() || !_schema[_col].nullable)
+        throw std::logic_error("arrow_ipc_writer: column is not nullable");
+
+    auto t = _schema[_col].type;
+    auto& c = _columns[_col++];
+
+    if (_rows % 8 == 0)
+        c.validity.push_back(0);
+
+    if (t == type::utf8) {
+        c.offsets.push_back((std::int32_t) c.values.size());
+    } else {
+        c.values.resize(c.values.size() + width(t), 0);
+    }
+
+    c.null_count++;
+    return *this;
+}
+
+void arrow_ipc_writer::end_row() {
+
+    if (_col != _schema.size())
+        throw std::logic_error("arrow_ipc_writer: row has " + std::to_string(_col) + " of "
+                               + std::to_string(_schema.size()) + " columns");
+    _col = 0;
+    _rows++;
+    _total_rows++;
+
+    if (_rows == _batch_rows)
+        _write_batch();
+}
+
+void arrow_ipc_writer::flush() {
+
+    _write_batch();
+    _stream.flush();
+}
+
+void arrow_ipc_writer::close() {
+
+    if (!_stream.is_open())
+        throw std::logic_error("arrow_ipc_writer: could not close file: file is not open");
+
+    _write_batch();
+
+    // end-of-stream marker
+    const std::uint32_t eos[2] = {0xffffffff, 0};
+    _stream.write((const char*) eos, 8);
+
+    fb_builder b;
+    std::vector<std::int64_t> blocks;
+
+    for (const auto& blk: _batches) {
+        blocks.push_back(blk.offset);
+        blocks.push_back((std::int64_t) (std::uint32_t) blk.metadata_len);
+        blocks.push_back(blk.body_len);
+    }
+
+    auto batches = b.struct_vector(blocks, _batches.size());
+    auto dictionaries = b.struct_vector({}, 0);
+    auto schema = build_schema(b, _schema);
+
+    b.start_table();
+    b.offset_field(1, schema);
+    b.offset_field(2, dictionaries);
+    b.offset_field(3, batches);
+    b.field<std::int16_t>(0, fbs::METADATA_V5);
+    auto footer = b.finish(b.end_table());
+
+    auto footer_len = (std::int32_t) footer.size();
+    _stream.write((const char*) footer.data(), (std::streamsize) footer.size());
+    _stream.write((const char*) &footer_len, 4);
+    _stream.write(MAGIC, 6);
+    _stream.close();
+}
+
+void arrow_ipc_writer::_write_batch() {
+
+    if (_rows == 0)
+        return;
+
+    // buffers of each column: validity (empty without nulls), offsets (utf8 only), values
+    std::vector<std::int64_t> nodes, buffers;
+    std::vector<std::pair<const void*, std::size_t>> data;
+    std::int64_t body_len = 0;
+
+    auto add_buffer = [&](const void* p, std::size_t len) {
+        buffers.push_back(body_len);
+        buffers.push_back((std::int64_t) len);
+        data.emplace_back(p, len);
+        body_len += (std::int64_t) padded(len);
+    };
+
+    for (std::size_t i = 0; i < _schema.size(); i++) {
+
+        const auto& c = _columns[i];
+
+        nodes.push_back((std::int64_t) _rows);
+        nodes.push_back((std::int64_t) c.null_count);
+
+        add_buffer(c.validity.data(), c.null_count ? c.validity.size() : 0);
+
+        if (_schema[i].type == type::utf8)
+            add_buffer(c.offsets.data(), c.offsets.size() * sizeof(std::int32_t));
+
+        add_buffer(c.values.data(), c.values.size());
+    }
+
+    fb_builder b;
+    auto buffers_vec = b.struct_vector(buffers, buffers.size() / 2);
+    auto nodes_vec = b.struct_vector(nodes, nodes.size() / 2);
+
+    b.start_table();
+    b.field<std::int64_t>(0, (std::int64_t) _rows);
+    b.offset_field(1, nodes_vec);
+    b.offset_field(2, buffers_vec);
+    auto batch = b.end_table();
+
+    _batches.push_back(_write_message(message(b, fbs::HEADER_BATCH, batch, body_len), body_len));
+
+    for (const auto& [p, len]: data) {
+        _stream.write((const char*) p, (std::streamsize) len);
+        pad(_stream, len);
+    }
+
+    for (auto& c: _columns) {
+        c.values.clear();
+        c.offsets.assign(1, 0);
+        c.validity.clear();
+        c.null_count = 0;
+    }
+
+    _rows = 0;
+}
+
+arrow_ipc_writer::_block arrow_ipc_writer::_write_message(const std::vector<std::uint8_t>& metadata,
+                                                          std::int64_t body_len) {
+
+    // continuation marker and metadata length, the body starts 8 Byte aligned
+    auto offset = (std::int64_t) _stream.tellp();
+    auto metadata_len = (std::int32_t) padded(metadata.size());
+    const std::uint32_t continuation = 0xffffffff;
+
+    _stream.write((const char*) &continuation, 4);
+    _stream.write((const char*) &metadata_len, 4);
+    _stream.write((const char*) metadata.data(), (std::streamsize) metadata.size());
+    pad(_stream, metadata.size());
+
+    return {offset, 8 + metadata_len, body_len};
+}
@@ -0,0 +1,111 @@
+
+#ifndef ZOOM_ANALYSIS_ARROW_IPC_WRITER_H
+#define ZOOM_ANALYSIS_ARROW_IPC_WRITER_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/*!
+ * Writes tables as Arrow IPC files (Feather V2), e.g., for R's arrow::read_ipc_file()
+ *
+ * - dependency-free: the few flatbuffers the format needs (schema, record batch and footer
+ *   messages) are encoded by hand, column data is written in the Arrow columnar layout
+ * - rows are added one column value at a time and buffered per column, every batch_rows rows
+ *   are written as one record batch (uncompressed, little-endian)
+ * - supported column types: unsigned integers of 8 to 64 bits, doubles and UTF-8 strings,
+ *   nullable columns accept put_null()
+ * - the file is only readable once close() (or the destructor) has written the footer
+ */
+class arrow_ipc_writer {
+public:
+
+    enum class type : std::uint8_t {
+        uint8, uint16, uint32, uint64, float64, utf8
+    };
+
+    struct column {
+        std::string name;
+        enum type type;
+        bool nullable = false;
+    };
+
+    //! default number of rows per record batch
+    static constexpr std::size_t BATCH_ROWS = 1 << 16;
+
+    arrow_ipc_writer(const std::string& file_path, const std::vector<column>& schema,
+                     std::size_t batch_rows = BATCH_ROWS);
+
+    arrow_ipc_writer(const arrow_ipc_writer&) = delete;
+    arrow_ipc_writer& operator=(const arrow_ipc_writer&) = delete;
+
+    ~arrow_ipc_writer();
+
+    //! sets the next column of the current row to an integer (for unsigned integer columns)
+    template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+    inline arrow_ipc_writer& put(T v) {
+        _put_int((std::uint64_t) v);
+        return *this;
+    }
+
+    //! sets the next column of the current row to a double (for float64 columns)
+    arrow_ipc_writer& put(double v);
+
+    //! sets the next column of the current row to a string (for utf8 columns)
+    arrow_ipc_writer& put(std::string_view s);
+
+    //! sets the next column of the current row to an IPv4 address in dotted-decimal notation
+    arrow_ipc_writer& put_ipv4(std::uint32_t addr);
+
+    //! sets the next column of the current row to null (for nullable columns)
+    arrow_ipc_writer& put_null();
+
+    //! completes the current row, writes a record batch every batch_rows rows
+    //! - throws std::logic_error if not all columns were set
+    void end_row();
+
+    //! writes all buffered rows as a record batch
+    void flush();
+
+    //! writes the remaining rows and the footer and closes the file
+    void close();
+
+    //! number of completed rows
+    [[nodiscard]] inline std::uint64_t rows() const {
+        return _total_rows;
+    }
+
+private:
+
+    struct _column_data {
+        std::vector<std::uint8_t> values;
+        std::vector<std::int32_t> offsets = {0}; // utf8 only
+        std::vector<std::uint8_t> validity;
+        std::size_t null_count = 0;
+    };
+
+    //! location of a message in the file, as listed in the footer
+    struct _block {
+        std::int64_t offset;
+        std::int32_t metadata_len;
+        std::int64_t body_len;
+    };
+
+    _column_data& _next(enum type t);
+    void _put_int(std::uint64_t v);
+    void _write_batch();
+    _block _write_message(const std::vector<std::uint8_t>& metadata, std::int64_t body_len);
+
+    std::ofstream _stream;
+    std::vector<column> _schema;
+    std::vector<_column_data> _columns;
+    std::vector<_block> _batches;
+    std::size_t _batch_rows;
+    std::size_t _rows = 0, _col = 0;
+    std::uint64_t _total_rows = 0;
+};
+
+#endif
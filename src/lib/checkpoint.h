@@ -0,0 +1,151 @@
+
+#ifndef ZOOM_ANALYSIS_CHECKPOINT_H
+#define ZOOM_ANALYSIS_CHECKPOINT_H
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "file_stream.h"
+
+/*!
+ * Binary snapshot of the state of long-running analyses
+ *
+ * - a checkpoint starts with a magic number, a format version and the name of the program that
+ *   wrote it; readers reject files written by other programs or versions
+ * - values are stored in host byte order and memory layout (like .zpkt files), snapshots are
+ *   only meant to be restored by the same build on the same machine
+ * - the writer writes to FILE.tmp and only replaces FILE upon commit(), so that an interrupted
+ *   run never leaves a partial checkpoint behind
+ */
+namespace checkpoint {
+
+    static const std::uint32_t MAGIC   = 0x5a434b50; // "ZCKP"
+    static const std::uint32_t VERSION = 13;
+
+    class writer : public file_stream {
+    public:
+
+        writer(const std::string& file_name, const std::string& kind)
+            : file_stream(file_name + ".tmp", std::ios::binary | std::ios::out | std::ios::trunc),
+              _file_name(file_name) {
+
+            write(MAGIC);
+            write(VERSION);
+            write(kind);
+        }
+
+        //! writes the memory representation of a trivially copyable value
+        template <typename T>
+        void write(const T& t) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            _stream.write((const char*) &t, sizeof(T));
+        }
+
+        void write(const std::string& s) {
+            write((std::uint64_t) s.size());
+            _stream.write(s.data(), (std::streamsize) s.size());
+        }
+
+        template <typename T>
+        void write(const std::vector<T>& v) {
+            write((std::uint64_t) v.size());
+
+            for (const auto& t: v)
+                write(t);
+        }
+
+        //! flushes the checkpoint and atomically replaces the previous one
+        void commit() {
+
+            _stream.flush();
+
+            if (!_stream.good())
+                throw std::runtime_error("checkpoint::writer: failed writing " + _file_name);
+
+            _stream.close();
+            std::filesystem::rename(_file_name + ".tmp", _file_name);
+        }
+
+    private:
+        std::string _file_name;
+    };
+
+    class reader : public file_stream {
+    public:
+
+        //! opens a checkpoint, throws std::runtime_error if it was not written by kind
+        reader(const std::string& file_name, const std::string& kind)
+            : file_stream(file_name, std::ios::binary | std::ios::in), _file_name(file_name) {
+
+            std::string file_kind;
+
+            if (read<std::uint32_t>() != MAGIC)
+                throw std::runtime_error("checkpoint::reader: " + file_name + " is no checkpoint");
+
+            if (read<std::uint32_t>() != VERSION)
+                throw std::runtime_error("checkpoint::reader: unsupported version in " + file_name);
+
+            if ((file_kind = read<std::string>()) != kind) {
+                throw std::runtime_error("checkpoint::reader: " + file_name + " was written by "
+                                         + file_kind + ", not by " + kind);
+            }
+        }
+
+        template <typename T>
+        void read(T& t) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            _stream.read((char*) &t, sizeof(T));
+            _check();
+        }
+
+        void read(std::string& s) {
+            s.resize(read<std::uint64_t>());
+            _stream.read(s.data(), (std::streamsize) s.size());
+            _check();
+        }
+
+        template <typename T>
+        void read(std::vector<T>& v) {
+            v.resize(read<std::uint64_t>());
+
+            for (auto& t: v)
+                read(t);
+        }
+
+        template <typename T>
+        T read() {
+            T t{};
+            read(t);
+            return t;
+        }
+
+    private:
+
+        void _check() {
+            if (!_stream.good())
+                throw std::runtime_error("checkpoint::reader: " + _file_name + " is truncated");
+        }
+
+        std::string _file_name;
+    };
+
+    //! truncates an output file to the size it had when a checkpoint was taken
+    //! - discards output written after the checkpoint, throws std::runtime_error if the file is
+    //!   shorter than size
+    inline void truncate_output(const std::string& file_name, std::uintmax_t size) {
+
+        if (!std::filesystem::exists(file_name) || std::filesystem::file_size(file_name) < size) {
+            throw std::runtime_error("checkpoint: " + file_name
+                                     + " is missing or shorter than at the checkpoint");
+        }
+
+        std::filesystem::resize_file(file_name, size);
+    }
+}
+
+#endif
@@ -0,0 +1,106 @@
+
+#ifndef ZOOM_ANALYSIS_CSV_BUFFER_H
+#define ZOOM_ANALYSIS_CSV_BUFFER_H
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/*!
+ * Reusable buffer that formats CSV rows without going through std::ostream
+ *
+ * - integers, IPv4 addresses and hex bytes are written with std::to_chars directly into the
+ *   buffer, floating point values like std::ostream with the given precision (i.e., %.*g)
+ * - rows are collected until full(), write_to() then hands them to a stream in a single write
+ */
+class csv_buffer {
+public:
+
+    //! number of buffered Bytes after which full() returns true
+    static constexpr std::size_t FLUSH_LEN = 1 << 16;
+
+    csv_buffer() : _buf(FLUSH_LEN + 1024) { }
+
+    csv_buffer(const csv_buffer&) = default;
+    csv_buffer& operator=(const csv_buffer&) = default;
+    csv_buffer(csv_buffer&&) = default;
+    csv_buffer& operator=(csv_buffer&&) = default;
+
+    inline csv_buffer& put(char c) {
+        _reserve(1);
+        _buf[_len++] = c;
+        return *this;
+    }
+
+    inline csv_buffer& put(std::string_view s) {
+        _reserve(s.size());
+        std::memcpy(_buf.data() + _len, s.data(), s.size());
+        _len += s.size();
+        return *this;
+    }
+
+    //! writes an integer in decimal notation
+    template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+    inline csv_buffer& put(T v) {
+        _reserve(20);
+        _len = std::to_chars(_buf.data() + _len, _buf.data() + _buf.size(), v).ptr - _buf.data();
+        return *this;
+    }
+
+    //! writes a floating point value like std::ostream with std::setprecision(precision)
+    inline csv_buffer& put(double v, int precision) {
+        _reserve(32);
+        _len = std::to_chars(_buf.data() + _len, _buf.data() + _buf.size(), v,
+                             std::chars_format::general, precision).ptr - _buf.data();
+        return *this;
+    }
+
+    //! writes an IPv4 address in host byte order in dotted-decimal notation
+    inline csv_buffer& put_ipv4(std::uint32_t addr) {
+        return put(addr >> 24u & 0xffu).put('.').put(addr >> 16u & 0xffu).put('.')
+                .put(addr >> 8u & 0xffu).put('.').put(addr & 0xffu);
+    }
+
+    //! writes a byte as two lower-case hex digits
+    inline csv_buffer& put_hex(std::uint8_t b) {
+        static const char digits[] = "0123456789abcdef";
+        _reserve(2);
+        _buf[_len++] = digits[b >> 4u];
+        _buf[_len++] = digits[b & 0x0fu];
+        return *this;
+    }
+
+    [[nodiscard]] inline bool full() const {
+        return _len >= FLUSH_LEN;
+    }
+
+    [[nodiscard]] inline std::size_t size() const {
+        return _len;
+    }
+
+    [[nodiscard]] inline std::string_view view() const {
+        return {_buf.data(), _len};
+    }
+
+    //! writes all buffered rows to os and clears the buffer
+    void write_to(std::ostream& os) {
+        os.write(_buf.data(), (std::streamsize) _len);
+        _len = 0;
+    }
+
+private:
+
+    inline void _reserve(std::size_t n) {
+        if (_len + n > _buf.size())
+            _buf.resize(2 * (_len + n));
+    }
+
+    std::vector<char> _buf;
+    std::size_t _len = 0;
+};
+
+#endif
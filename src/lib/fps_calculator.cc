@@ -1,21 +1,107 @@
 
 #include "fps_calculator.h"
 
+#include <algorithm>
 #include <stdexcept>
-#include "pcap_util.h"
 
-fps_calculator::fps_calculator(std::size_t ring_len)
-    : _frames(ring_len) { }
+namespace {
+
+    //! slot of a bucket number, also for negative ones
+    inline std::size_t slot(std::int64_t bucket, std::size_t slots) {
+        auto i = bucket % (std::int64_t) slots;
+        return (std::size_t) (i < 0 ? i + (std::int64_t) slots : i);
+    }
+}
+
+fps_calculator::fps_calculator(unsigned window_s)
+    : _window_s(window_s ? window_s : 1),
+      _bucket_us((std::int64_t) _window_s * 1000000 / BUCKETS) { }
 
 unsigned fps_calculator::add_frame(const timeval& ts) {
+    return add_frame((std::int64_t) ts.tv_sec * 1000000 + ts.tv_usec);
+}
+
+unsigned fps_calculator::add_frame(std::int64_t ts_us) {
+
+    auto bucket = _bucket(ts_us);
+
+    if (_last_us == _NONE || bucket - _bucket(_last_us) > (std::int64_t) BUCKETS) {
 
-    if (!_frames.push(ts)) {
-        throw std::runtime_error("too many frames");
+        // all buckets expired
+        _buckets = {};
+        _frames = 0;
+        _last_us = ts_us;
+
+    } else if (auto last_bucket = _bucket(_last_us); bucket > last_bucket) {
+
+        // expires the buckets after the last frame up to this one, at most BUCKETS + 1
+        for (auto b = last_bucket + 1; b <= bucket; b++) {
+            auto& expired = _buckets[slot(b - (std::int64_t) BUCKETS - 1, _buckets.size())];
+            _frames -= expired.frames;
+            expired = {};
+        }
+
+        _last_us = ts_us;
+
+    } else if (last_bucket - bucket > (std::int64_t) BUCKETS) {
+
+        // reordered frame older than the window
+        return fps();
+
+    } else if (ts_us > _last_us) {
+        _last_us = ts_us;
     }
 
-    while (!_frames.empty() && (ts - _frames.peek()) >= timeval{1, 0}) {
-        _frames.pop();
+    auto& b = _buckets[slot(bucket, _buckets.size())];
+    auto offset = (std::uint16_t) ((ts_us - bucket * _bucket_us) / _window_s);
+
+    if (b.frames == 0 || offset > b.last_offset)
+        b.last_offset = offset;
+
+    if (b.frames < std::numeric_limits<std::uint16_t>::max()) {
+        b.frames++;
+        _frames++;
     }
 
-    return _frames.count();
+    return fps();
+}
+
+unsigned fps_calculator::frames() const {
+
+    if (_last_us == _NONE)
+        return 0;
+
+    // the window starts within the oldest bucket, at the offset of the last frame in its bucket
+    auto bucket = _bucket(_last_us);
+    const auto& oldest = _buckets[slot(bucket - (std::int64_t) BUCKETS, _buckets.size())];
+    auto start_offset = (_last_us - bucket * _bucket_us) / _window_s;
+
+    if (oldest.frames == 0 || oldest.last_offset <= start_offset)
+        return _frames - oldest.frames;
+
+    if (oldest.frames == 1)
+        return _frames;
+
+    // several frames, assumes that they are spread evenly within the bucket
+    auto bucket_len = _bucket_us / _window_s;
+    auto in_window = (oldest.frames * (bucket_len - start_offset) + bucket_len / 2) / bucket_len;
+
+    return _frames - oldest.frames + std::max(1u, (unsigned) in_window);
+}
+
+unsigned fps_calculator::fps() const {
+    return frames() / _window_s;
+}
+
+void fps_calculator::save(checkpoint::writer& w) const {
+    w.write(_window_s), w.write(_bucket_us), w.write(_last_us), w.write(_frames);
+    w.write(_buckets);
+}
+
+void fps_calculator::restore(checkpoint::reader& r) {
+    r.read(_window_s), r.read(_bucket_us), r.read(_last_us), r.read(_frames);
+    r.read(_buckets);
+
+    if (_window_s == 0 || _bucket_us <= 0)
+        throw std::runtime_error("fps_calculator::restore(): invalid checkpoint");
 }
@@ -1,25 +1,74 @@
 #ifndef ZOOM_ANALYSIS_FPS_CALCULATOR_H
 #define ZOOM_ANALYSIS_FPS_CALCULATOR_H
 
+#include <array>
 #include <cstddef>
+#include <cstdint>
 #include <cstdlib>
+#include <limits>
 
-#include "ring_buffer.h"
+#include "checkpoint.h"
 
+/*!
+ * Counts frames in a sliding window in fixed memory and at constant cost per frame
+ *
+ * - the window is split into BUCKETS buckets of frame counts, plus the bucket before them that
+ *   the window starts in, each bucket also keeps the offset of its latest frame
+ * - the frames of the oldest bucket are counted if its latest frame is within the window: all of
+ *   them if it has a single frame (exact unless frames are less than a bucket apart, i.e., up to
+ *   64 fps), otherwise in proportion to the part of the bucket within the window
+ * - frames older than the window are ignored, bursts saturate the counters instead of throwing
+ * - timestamps are integer microseconds
+ */
 class fps_calculator {
 
 public:
 
+    static constexpr unsigned BUCKETS = 64;
+
+    //! - window_s: length of the window in seconds (e.g., 1 or 5), at least 1
+    explicit fps_calculator(unsigned window_s = 1);
+
     fps_calculator(const fps_calculator& copy_from) = default;
     fps_calculator& operator=(const fps_calculator& copy_from) = default;
 
-    explicit fps_calculator(std::size_t ring_len = 64);
+    //! adds a frame and returns the frames per second in the window up to it
     [[nodiscard]] unsigned add_frame(const timeval& ts);
+    [[nodiscard]] unsigned add_frame(std::int64_t ts_us);
+
+    //! frames per second in the window up to the last frame (rounded down)
+    [[nodiscard]] unsigned fps() const;
+
+    //! frames in the window up to the last frame
+    [[nodiscard]] unsigned frames() const;
+
+    [[nodiscard]] unsigned window_s() const {
+        return _window_s;
+    }
 
-    virtual ~fps_calculator() = default;
+    void save(checkpoint::writer& w) const;
+    void restore(checkpoint::reader& r);
 
 private:
-    ring_buffer<timeval> _frames;
+
+    static constexpr std::int64_t _NONE = std::numeric_limits<std::int64_t>::min();
+
+    //! rounds towards negative infinity, such that timestamps before 1970 still work
+    [[nodiscard]] inline std::int64_t _bucket(std::int64_t ts_us) const {
+        return ts_us / _bucket_us - (ts_us % _bucket_us < 0);
+    }
+
+    unsigned _window_s = 1;
+    std::int64_t _bucket_us = 0;
+    std::int64_t _last_us = _NONE; // latest frame
+    unsigned _frames = 0;          // sum of the buckets
+
+    struct _bucket_state {
+        std::uint16_t frames = 0;
+        std::uint16_t last_offset = 0; // of the latest frame in the bucket, in units of window_s µs
+    };
+
+    std::array<_bucket_state, BUCKETS + 1> _buckets = {};
 };
 
 #endif
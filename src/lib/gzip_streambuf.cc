@@ -0,0 +1,215 @@
+
+#include <filesystem>
+#include <stdexcept>
+#include <zlib.h>
+
+#include "gzip_streambuf.h"
+
+gzip_streambuf::gzip_streambuf(const std::string& file_path, bool append, int level)
+    : _z(std::make_unique<z_stream_s>()), _buf(CHUNK_LEN), _out(CHUNK_LEN) {
+
+    _file.open(file_path, std::ios::out | std::ios::binary
+                          | (append ? std::ios::app : std::ios::trunc));
+
+    if (!_file.is_open())
+        return;
+
+    if (append)
+        _file_len = (std::int64_t) std::filesystem::file_size(file_path);
+
+    // window bits + 16: gzip header and trailer instead of zlib's
+    if (deflateInit2(_z.get(), level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        throw std::runtime_error("gzip_streambuf: could not initialize zlib");
+
+    setp(_buf.data(), _buf.data() + _buf.size());
+    _thread = std::thread([this]() { _run(); });
+}
+
+gzip_streambuf::~gzip_streambuf() {
+
+    if (!_file.is_open())
+        return;
+
+    // like std::ofstream, errors are only reported by an explicit close()
+    try {
+        close();
+    } catch (const std::runtime_error&) { }
+}
+
+std::int64_t gzip_streambuf::end_member() {
+
+    _submit(true);
+
+    std::unique_lock lock(_mutex);
+    _cv.wait(lock, [this]() { return _pending.empty() && !_busy; });
+
+    if (_error)
+        std::rethrow_exception(_error);
+
+    return _file_len;
+}
+
+void gzip_streambuf::close() {
+
+    if (!_file.is_open())
+        throw std::logic_error("gzip_streambuf: could not close file: file is not open");
+
+    std::exception_ptr error;
+
+    try {
+        end_member();
+    } catch (const std::runtime_error&) {
+        error = std::current_exception();
+    }
+
+    {
+        std::lock_guard lock(_mutex);
+        _stop = true;
+    }
+
+    _cv.notify_all();
+    _thread.join();
+
+    deflateEnd(_z.get());
+    _file.close();
+
+    if (error)
+        std::rethrow_exception(error);
+
+    if (_file.fail())
+        throw std::runtime_error("gzip_streambuf: could not close file");
+}
+
+gzip_streambuf::int_type gzip_streambuf::overflow(int_type c) {
+
+    try {
+        _submit(false);
+    } catch (const std::runtime_error&) {
+        return traits_type::eof();
+    }
+
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+
+    return traits_type::not_eof(c);
+}
+
+int gzip_streambuf::sync() {
+
+    std::lock_guard lock(_mutex);
+    return _error ? -1 : 0;
+}
+
+void gzip_streambuf::_submit(bool end_member) {
+
+    auto len = (std::size_t) (pptr() - pbase());
+    _bytes_in += len;
+
+    std::unique_lock lock(_mutex);
+    _cv.wait(lock, [this]() { return _pending.size() < MAX_PENDING; });
+
+    if (_error)
+        std::rethrow_exception(_error);
+
+    _chunk c;
+    c.data = std::move(_buf);
+    c.len = len;
+    c.end_member = end_member;
+    _pending.push_back(std::move(c));
+
+    if (_free.empty()) {
+        _buf = std::vector<char>(CHUNK_LEN);
+    } else {
+        _buf = std::move(_free.back());
+        _free.pop_back();
+    }
+
+    lock.unlock();
+    _cv.notify_all();
+
+    setp(_buf.data(), _buf.data() + _buf.size());
+}
+
+void gzip_streambuf::_run() {
+
+    std::unique_lock lock(_mutex);
+
+    while (true) {
+
+        _cv.wait(lock, [this]() { return _stop || !_pending.empty(); });
+
+        if (_pending.empty())
+            break;
+
+        auto c = std::move(_pending.front());
+        _pending.pop_front();
+        _busy = true;
+
+        auto failed = (bool) _error;
+
+        lock.unlock();
+        _cv.notify_all();
+
+        std::exception_ptr error;
+
+        // after an error, chunks are dropped so that writers do not block
+        try {
+            if (!failed) {
+                _deflate(c.data.data(), c.len, false);
+
+                if (c.end_member && _member_len > 0) {
+                    _deflate(nullptr, 0, true);
+                    deflateReset(_z.get());
+                    _member_len = 0;
+                }
+
+                if (c.end_member && !_file.flush())
+                    throw std::runtime_error("gzip_streambuf: could not flush file");
+            }
+        } catch (const std::runtime_error&) {
+            error = std::current_exception();
+        }
+
+        lock.lock();
+
+        if (error && !_error)
+            _error = error;
+
+        _free.push_back(std::move(c.data));
+        _busy = false;
+        _cv.notify_all();
+    }
+}
+
+void gzip_streambuf::_deflate(const char* data, std::size_t len, bool finish) {
+
+    if (len == 0 && !finish)
+        return;
+
+    _z->next_in = (Bytef*) data;
+    _z->avail_in = (uInt) len;
+    _member_len += len;
+
+    int ret;
+
+    do {
+        _z->next_out = (Bytef*) _out.data();
+        _z->avail_out = (uInt) _out.size();
+
+        ret = deflate(_z.get(), finish ? Z_FINISH : Z_NO_FLUSH);
+
+        // Z_BUF_ERROR only means that no progress was possible
+        if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR)
+            throw std::runtime_error("gzip_streambuf: zlib error " + std::to_string(ret));
+
+        auto n = _out.size() - _z->avail_out;
+
+        if (!_file.write(_out.data(), (std::streamsize) n))
+            throw std::runtime_error("gzip_streambuf: could not write file");
+
+        _file_len += (std::int64_t) n;
+
+    } while (_z->avail_out == 0 || (finish && ret != Z_STREAM_END));
+}
@@ -0,0 +1,101 @@
+
+#ifndef ZOOM_ANALYSIS_GZIP_STREAMBUF_H
+#define ZOOM_ANALYSIS_GZIP_STREAMBUF_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct z_stream_s;
+
+/*!
+ * Stream buffer that writes a gzip file, compressing on a background thread
+ *
+ * - written data is collected in chunks of CHUNK_LEN Bytes, full chunks are handed to the
+ *   compression thread; up to MAX_PENDING chunks are queued before the writer has to wait
+ * - sync() (e.g., std::endl or std::flush) does not hand over partial chunks, end_member()
+ *   compresses all data written so far and ends the current gzip member instead
+ * - the file is a sequence of gzip members, which gzip and zlib decompress as one stream; since a
+ *   member ends at each end_member(), the file can be truncated to its returned size and
+ *   appended to later (e.g., when resuming from a checkpoint)
+ * - write and zlib errors on the compression thread are rethrown as std::runtime_error by
+ *   end_member() and close(), the stream goes bad on the next write or flush
+ */
+class gzip_streambuf : public std::streambuf {
+public:
+
+    static constexpr std::size_t CHUNK_LEN = 1 << 20;
+    static constexpr std::size_t MAX_PENDING = 4;
+
+    //! opens the file (see is_open()) and starts the compression thread
+    //! - append: adds new gzip members to an existing file
+    //! - level: zlib compression level, 1 compresses CSV logs about 5x at ~3x the speed of 6
+    explicit gzip_streambuf(const std::string& file_path, bool append = false, int level = 1);
+
+    gzip_streambuf(const gzip_streambuf&) = delete;
+    gzip_streambuf& operator=(const gzip_streambuf&) = delete;
+
+    ~gzip_streambuf() override;
+
+    [[nodiscard]] bool is_open() const {
+        return _file.is_open();
+    }
+
+    //! compresses all data written so far, ends the gzip member and flushes the file
+    //! - returns the size of the file in Bytes
+    //! - throws std::runtime_error if data could not be compressed or written
+    std::int64_t end_member();
+
+    //! ends the last member, stops the compression thread and closes the file
+    //! - throws std::runtime_error if data could not be compressed or written
+    void close();
+
+    //! number of Bytes written to the stream buffer
+    [[nodiscard]] std::uint64_t bytes_in() const {
+        return _bytes_in + (pptr() - pbase());
+    }
+
+protected:
+
+    int_type overflow(int_type c) override;
+    int sync() override;
+
+private:
+
+    struct _chunk {
+        std::vector<char> data;
+        std::size_t len = 0;
+        bool end_member = false;
+    };
+
+    void _submit(bool end_member);
+    void _run();
+    void _deflate(const char* data, std::size_t len, bool finish);
+
+    std::ofstream _file;
+    std::unique_ptr<z_stream_s> _z;
+    std::vector<char> _buf;
+    std::vector<char> _out;
+
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    std::deque<_chunk> _pending;
+    std::vector<std::vector<char>> _free;
+    bool _busy = false, _stop = false;
+    std::exception_ptr _error;  // first error of the compression thread
+    std::thread _thread;
+
+    std::uint64_t _bytes_in = 0;
+    std::uint64_t _member_len = 0;  // uncompressed Bytes in the current member
+    std::int64_t _file_len = 0;
+};
+
+#endif
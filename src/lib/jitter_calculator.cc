@@ -1,7 +1,9 @@
 
 #include "jitter_calculator.h"
 
+#include <algorithm>
 #include <cmath>
+#include <stdexcept>
 
 
 jitter_calculator::jitter_calculator(unsigned sampling_rate)
@@ -24,4 +26,50 @@ double jitter_calculator::add_frame(const timeval& ts, std::uint32_t rtp_ts) {
     _r = r, _s = s, _i++;
 
     return (double) _j;
-}
\ No newline at end of file
+}
+
+void jitter_calculator::save(checkpoint::writer& w) const {
+    w.write(_i), w.write(_sampling_rate), w.write(_r), w.write(_s), w.write(_d), w.write(_j);
+}
+
+void jitter_calculator::restore(checkpoint::reader& r) {
+    r.read(_i), r.read(_sampling_rate), r.read(_r), r.read(_s), r.read(_d), r.read(_j);
+}
+
+rfc3550_jitter_calculator::rfc3550_jitter_calculator(unsigned sampling_rate)
+        : _sampling_rate(sampling_rate) {
+
+    // rates above 2^17 overflow D(i-1, i) in add_frame_rtp()
+    if (_sampling_rate == 0 || _sampling_rate > (1u << 17))
+        throw std::invalid_argument(
+            "rfc3550_jitter_calculator: sampling rate must be in [1, 2^17]");
+}
+
+void rfc3550_jitter_calculator::add_frame_rtp(std::int64_t ts_us, std::uint32_t rtp_ts) {
+
+    if (!_initialized) {
+        _r_us = ts_us, _s = rtp_ts;
+        _initialized = true;
+        return;
+    }
+
+    auto dr_us = std::clamp(ts_us - _r_us, -_MAX_ARRIVAL_DIFF_US, _MAX_ARRIVAL_DIFF_US);
+    auto ds = (std::int64_t) (std::int32_t) (rtp_ts - _s);
+
+    // D(i-1, i) = (R_i - R_i-1) - (S_i - S_i-1) in RTP units, at most 2^(31 + 17 + FRAC_BITS)
+    auto d = dr_us * _sampling_rate * (1 << FRAC_BITS) / 1000000 - ds * (1 << FRAC_BITS);
+
+    _j += (d < 0 ? -d : d) - ((_j + 8) >> 4);
+    _r_us = ts_us, _s = rtp_ts;
+}
+
+void rfc3550_jitter_calculator::save(checkpoint::writer& w) const {
+    w.write(_initialized), w.write(_sampling_rate), w.write(_r_us), w.write(_s), w.write(_j);
+}
+
+void rfc3550_jitter_calculator::restore(checkpoint::reader& r) {
+    r.read(_initialized), r.read(_sampling_rate), r.read(_r_us), r.read(_s), r.read(_j);
+
+    if (_sampling_rate == 0 || _sampling_rate > (1u << 17))
+        throw std::runtime_error("rfc3550_jitter_calculator::restore(): invalid checkpoint");
+}
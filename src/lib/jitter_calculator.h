@@ -4,6 +4,10 @@
 #include <cstdint>
 #include <cstdlib>
 
+#include "checkpoint.h"
+
+//! interarrival jitter of frames by their last packets, in wallclock milliseconds converted
+//! through double
 class jitter_calculator {
 
 public:
@@ -13,6 +17,9 @@ public:
     //! returns RTP jitter in milliseconds
     [[nodiscard]] double add_frame(const timeval& ts, std::uint32_t rtp_ts);
 
+    void save(checkpoint::writer& w) const;
+    void restore(checkpoint::reader& r);
+
     //! converts a RTP timestamp to wallclock time in milliseconds
     static inline unsigned long long rtp_ts_to_wallclock_ms(std::uint32_t rtp_ts,
                                                             unsigned sampling_rate_khz) {
@@ -35,4 +42,59 @@ private:
     long double _j = 0.0;
 };
 
+/*!
+ * RFC 3550 interarrival jitter (section 6.4.1 and appendix A.8) in integer fixed point
+ *
+ * - the transit time difference D of consecutive frames is computed in RTP timestamp units with
+ *   FRAC_BITS fractional bits from microsecond arrival times, the estimate J += (|D| - J) / 16
+ *   keeps 4 more fractional bits, such that no precision is lost to rounding
+ * - RTP timestamps wrap around modulo 2^32, consecutive frames may be up to 2^31 units apart
+ *   (e.g., 6.6 hours at 90 kHz), arrival times up to 2^31 µs (35 min), longer gaps are clamped
+ * - same interface as jitter_calculator, add_frame() returns the jitter in milliseconds
+ */
+class rfc3550_jitter_calculator {
+
+public:
+
+    static constexpr unsigned FRAC_BITS = 8;
+
+    //! - sampling_rate: RTP clock rate in Hz, at most 2^17, throws std::invalid_argument otherwise
+    explicit rfc3550_jitter_calculator(unsigned sampling_rate = 90000);
+
+    //! returns RTP jitter in milliseconds
+    [[nodiscard]] inline double add_frame(const timeval& ts, std::uint32_t rtp_ts) {
+        return add_frame((std::int64_t) ts.tv_sec * 1000000 + ts.tv_usec, rtp_ts);
+    }
+
+    [[nodiscard]] inline double add_frame(std::int64_t ts_us, std::uint32_t rtp_ts) {
+        add_frame_rtp(ts_us, rtp_ts);
+        return jitter_ms();
+    }
+
+    //! updates the jitter without converting it to milliseconds
+    void add_frame_rtp(std::int64_t ts_us, std::uint32_t rtp_ts);
+
+    //! in RTP timestamp units, rounded down as in RTCP receiver reports
+    [[nodiscard]] inline std::uint32_t jitter_rtp() const {
+        return (std::uint32_t) (_j >> (FRAC_BITS + 4));
+    }
+
+    [[nodiscard]] inline double jitter_ms() const {
+        return (double) _j * 1000.0 / ((double) _sampling_rate * (1u << (FRAC_BITS + 4)));
+    }
+
+    void save(checkpoint::writer& w) const;
+    void restore(checkpoint::reader& r);
+
+private:
+
+    static constexpr std::int64_t _MAX_ARRIVAL_DIFF_US = (std::int64_t) 1 << 31;
+
+    bool _initialized = false;
+    unsigned _sampling_rate = 90000;
+    std::int64_t _r_us = 0;  // arrival time of the previous frame
+    std::uint32_t _s = 0;    // RTP timestamp of the previous frame
+    std::int64_t _j = 0;     // in RTP units << (FRAC_BITS + 4)
+};
+
 #endif
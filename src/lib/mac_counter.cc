@@ -23,3 +23,13 @@ void mac_counter::add(const net::eth::addr& a) {
         _discard_count++;
     }
 }
+
+void mac_counter::save(checkpoint::writer& w) const {
+    w.write(_curr_count), w.write(_total_count), w.write(_wraparound_count);
+    w.write(_discard_count), w.write(_wraparound_tolerance);
+}
+
+void mac_counter::restore(checkpoint::reader& r) {
+    r.read(_curr_count), r.read(_total_count), r.read(_wraparound_count);
+    r.read(_discard_count), r.read(_wraparound_tolerance);
+}
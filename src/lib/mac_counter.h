@@ -3,6 +3,7 @@
 
 #include <arpa/inet.h>
 
+#include "checkpoint.h"
 #include "net.h"
 
 class mac_counter {
@@ -15,6 +16,9 @@ public:
 
     void add(const net::eth::addr& a);
 
+    void save(checkpoint::writer& w) const;
+    void restore(checkpoint::reader& r);
+
     [[nodiscard]] inline std::uint64_t count() const {
         return _total_count + _curr_count;
     }
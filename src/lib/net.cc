@@ -18,3 +18,21 @@ net::ipv4_5tuple net::ipv4_5tuple::from_ipv4_pkt_data(const unsigned char* pkt_d
 
     return ip4_5_tuple;
 }
+
+net::ipv6_5tuple net::ipv6_5tuple::from_ipv6_pkt_data(const unsigned char* pkt_data) {
+
+    ipv6_5tuple ip6_5_tuple{};
+
+    auto ipv6 = (net::ipv6::hdr*) pkt_data;
+    ip6_5_tuple.ip_src   = ipv6->src_addr;
+    ip6_5_tuple.ip_dst   = ipv6->dst_addr;
+    ip6_5_tuple.ip_proto = ipv6->next_header;
+
+    if (ipv6->next_header == 6 || ipv6->next_header == 17) {
+        auto tp_hdr = (net::tcp_or_udp_hdr*) (pkt_data + net::ipv6::HDR_LEN);
+        ip6_5_tuple.tp_src = ntohs(tp_hdr->src_port);
+        ip6_5_tuple.tp_dst = ntohs(tp_hdr->dst_port);
+    }
+
+    return ip6_5_tuple;
+}
@@ -5,12 +5,14 @@
 #include <arpa/inet.h> // for ntohs, ntohl, etc.
 
 #include <cstdint>
+#include <cstring>
 #include <iomanip>
 #include <ostream>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <tuple>
+#include <type_traits>
 
 namespace net {
 
@@ -49,9 +51,12 @@ namespace net {
 
         const unsigned ADDR_LEN = 6;
         const unsigned HDR_LEN = 14;
+        const unsigned VLAN_TAG_LEN = 4;
 
         enum class type : std::uint16_t {
-            ipv4 = 0x0800
+            ipv4 = 0x0800,
+            vlan = 0x8100,
+            ipv6 = 0x86dd
         };
 
         struct addr {
@@ -146,6 +151,145 @@ namespace net {
         }
     }
 
+    namespace ipv6 {
+
+        const unsigned HDR_LEN = 40;
+
+        struct addr {
+            std::uint8_t bytes[16] = {0};
+
+            inline bool operator==(const addr& other) const {
+                return std::memcmp(bytes, other.bytes, sizeof(bytes)) == 0;
+            }
+
+            inline bool operator!=(const addr& other) const {
+                return !(*this == other);
+            }
+
+            inline bool operator<(const addr& other) const {
+                return std::memcmp(bytes, other.bytes, sizeof(bytes)) < 0;
+            }
+
+            inline bool operator<=(const addr& other) const {
+                return std::memcmp(bytes, other.bytes, sizeof(bytes)) <= 0;
+            }
+
+            //! returns the upper (hi = true) or lower 64 bits in host byte order
+            [[nodiscard]] inline std::uint64_t half(bool hi) const {
+                std::uint64_t h = 0;
+
+                for (unsigned i = hi ? 0 : 8; i < (hi ? 8u : 16u); i++)
+                    h = (h << 8u) | bytes[i];
+
+                return h;
+            }
+
+            //! folds the address into 32 bits, e.g., to fit it into an IPv4 address field
+            [[nodiscard]] inline std::uint32_t fold32() const {
+                std::uint64_t h = half(true) ^ half(false);
+                return (std::uint32_t) (h >> 32u) ^ (std::uint32_t) h;
+            }
+        };
+
+        struct hdr { // 40
+            std::uint32_t version_class_label = 0; // 4
+            std::uint16_t payload_length = 0; // 2
+            std::uint8_t next_header = 0; // 1
+            std::uint8_t hop_limit = 0; // 1 // 8
+            addr src_addr; // 16
+            addr dst_addr; // 16
+        };
+
+        //! converts an IPv6 address to its textual representation (RFC 5952)
+        inline std::string addr_to_str(const addr& a) {
+            char buf[INET6_ADDRSTRLEN] = {0};
+            inet_ntop(AF_INET6, a.bytes, buf, sizeof(buf));
+            return buf;
+        }
+
+        //! converts an IPv6 address in textual representation to an addr struct
+        static addr str_to_addr(const std::string& s) {
+            addr a;
+
+            if (inet_pton(AF_INET6, s.c_str(), a.bytes) != 1)
+                throw std::invalid_argument("invalid ipv6 address");
+
+            return a;
+        }
+    }
+
+    /*!
+     * Framing of captured packets in front of the IP header
+     *
+     * - eth: Ethernet, eth_vlan: Ethernet with a single 802.1Q tag, raw: no link layer header,
+     *   loop: 4-byte BSD loopback header holding the address family
+     * - used as template argument so that header offsets are resolved at compile time
+     */
+    enum class link_layer {
+        eth,
+        eth_vlan,
+        raw,
+        loop
+    };
+
+    template <link_layer L>
+    using link_layer_tag = std::integral_constant<link_layer, L>;
+
+    //! returns the length of the link layer header preceding the IP header
+    template <link_layer L>
+    constexpr unsigned link_hdr_len() {
+        switch (L) {
+            case link_layer::eth:      return eth::HDR_LEN;
+            case link_layer::eth_vlan: return eth::HDR_LEN + eth::VLAN_TAG_LEN;
+            case link_layer::raw:      return 0;
+            case link_layer::loop:     return 4;
+        }
+
+        return 0;
+    }
+
+    //! checks whether the link layer header announces an IPv4 packet
+    template <link_layer L>
+    inline bool is_ipv4(const unsigned char* buf) {
+
+        if constexpr (L == link_layer::eth) {
+            return eth::type_from_buf(buf) == eth::type::ipv4;
+        } else if constexpr (L == link_layer::eth_vlan) {
+            return eth::type_from_buf(buf + eth::VLAN_TAG_LEN) == eth::type::ipv4;
+        } else if constexpr (L == link_layer::raw) {
+            return (buf[0] >> 4) == 4;
+        } else {
+            // address family in the byte order of the capturing host (AF_INET == 2 everywhere)
+            return (buf[0] == 2 && buf[1] == 0 && buf[2] == 0 && buf[3] == 0)
+                   || (buf[0] == 0 && buf[1] == 0 && buf[2] == 0 && buf[3] == 2);
+        }
+    }
+
+    //! checks whether the link layer header announces an IPv6 packet
+    template <link_layer L>
+    inline bool is_ipv6(const unsigned char* buf) {
+
+        if constexpr (L == link_layer::eth) {
+            return eth::type_from_buf(buf) == eth::type::ipv6;
+        } else if constexpr (L == link_layer::eth_vlan) {
+            return eth::type_from_buf(buf + eth::VLAN_TAG_LEN) == eth::type::ipv6;
+        } else if constexpr (L == link_layer::raw) {
+            return (buf[0] >> 4) == 6;
+        } else {
+            // AF_INET6 differs between systems: 10 (Linux), 24 (NetBSD, OpenBSD),
+            // 28 (FreeBSD), 30 (macOS), in the byte order of the capturing host
+            auto af = (buf[0] | buf[1] | buf[2] | buf[3]);
+            bool single_byte = (buf[0] == 0 && buf[1] == 0 && buf[2] == 0)
+                               || (buf[1] == 0 && buf[2] == 0 && buf[3] == 0);
+            return single_byte && (af == 10 || af == 24 || af == 28 || af == 30);
+        }
+    }
+
+    //! checks whether an Ethernet frame carries an 802.1Q tag
+    inline bool is_vlan_tagged(const unsigned char* buf) {
+        return eth::type_from_buf(buf) == eth::type::vlan;
+    }
+
     namespace udp {
 
         const unsigned HDR_LEN = 8;
@@ -198,6 +342,78 @@ namespace net {
             return std::tie(ip_src, ip_dst, tp_src, tp_dst, ip_proto)
                    < std::tie(other.ip_src, other.ip_dst, other.tp_src, other.tp_dst, other.ip_proto);
         }
+
+        //! returns the 5-tuple with source and destination endpoints swapped
+        [[nodiscard]] inline ipv4_5tuple reversed() const {
+            return {ip_dst, ip_src, tp_dst, tp_src, ip_proto};
+        }
+
+        //! returns true if the (ip_src, tp_src) endpoint orders before (ip_dst, tp_dst)
+        [[nodiscard]] inline bool is_canonical() const {
+            return std::tie(ip_src, tp_src) <= std::tie(ip_dst, tp_dst);
+        }
+
+        //! returns the direction-independent form of the 5-tuple
+        //! - both directions of a conversation map to the same canonical 5-tuple
+        [[nodiscard]] inline ipv4_5tuple canonical() const {
+            return is_canonical() ? *this : reversed();
+        }
+    };
+
+    /*!
+     * IPv6 counterpart of ipv4_5tuple
+     *
+     * - only parses TCP and UDP headers that directly follow the fixed IPv6 header, packets with
+     *   extension headers keep tp_src = 0, tp_dst = 0 and the next header type as ip_proto
+     */
+    struct ipv6_5tuple {
+
+        //! returns an ipv6_5tuple struct from raw packet buffer starting at the IPv6 header
+        //! - reverses the byte order of the tp_src, tp_dst fields, addresses keep network order
+        static ipv6_5tuple from_ipv6_pkt_data(const unsigned char* pkt_data);
+
+        ipv6_5tuple() = default;
+        ipv6_5tuple(const ipv6::addr& ip_src, const ipv6::addr& ip_dst, std::uint16_t tp_src,
+                    std::uint16_t tp_dst, std::uint8_t ip_proto)
+            : ip_src(ip_src), ip_dst(ip_dst), tp_src(tp_src), tp_dst(tp_dst), ip_proto(ip_proto) { }
+
+        ipv6_5tuple(const ipv6_5tuple&) = default;
+        ipv6_5tuple& operator=(const ipv6_5tuple&) = default;
+
+        ipv6::addr ip_src      = {};
+        ipv6::addr ip_dst      = {};
+        std::uint16_t tp_src   = 0;
+        std::uint16_t tp_dst   = 0;
+        std::uint8_t  ip_proto = 0;
+
+        inline bool operator==(const ipv6_5tuple& other) const {
+            return std::tie(ip_src, ip_dst, tp_src, tp_dst, ip_proto)
+                   == std::tie(other.ip_src, other.ip_dst, other.tp_src, other.tp_dst, other.ip_proto);
+        }
+
+        inline bool operator!=(const ipv6_5tuple& other) const {
+            return !(*this == other);
+        }
+
+        inline bool operator<(const ipv6_5tuple& other) const {
+            return std::tie(ip_src, ip_dst, tp_src, tp_dst, ip_proto)
+                   < std::tie(other.ip_src, other.ip_dst, other.tp_src, other.tp_dst, other.ip_proto);
+        }
+
+        //! returns the 5-tuple with source and destination endpoints swapped
+        [[nodiscard]] inline ipv6_5tuple reversed() const {
+            return {ip_dst, ip_src, tp_dst, tp_src, ip_proto};
+        }
+
+        //! returns true if the (ip_src, tp_src) endpoint orders before (ip_dst, tp_dst)
+        [[nodiscard]] inline bool is_canonical() const {
+            return std::tie(ip_src, tp_src) <= std::tie(ip_dst, tp_dst);
+        }
+
+        //! returns the direction-independent form of the 5-tuple
+        [[nodiscard]] inline ipv6_5tuple canonical() const {
+            return is_canonical() ? *this : reversed();
+        }
     };
 
     struct ipv4_port {
@@ -213,6 +429,19 @@ namespace net {
         }
     };
 
+    struct ipv6_port {
+        ipv6::addr ip      = {};
+        std::uint16_t port = 0;
+
+        inline bool operator<(const ipv6_port& other) const {
+            return std::tie(ip, port) < std::tie(other.ip, other.port);
+        }
+
+        inline bool operator==(const ipv6_port& other) const {
+            return std::tie(ip, port) == std::tie(other.ip, other.port);
+        }
+    };
+
     struct ipv4_mask {
         std::uint32_t ip   = 0;
         std::uint32_t mask = 0;
@@ -229,6 +458,41 @@ namespace net {
             return std::tie(ip, mask) == std::tie(other.ip, other.mask);
         }
     };
+
+    struct ipv6_mask {
+        ipv6::addr ip            = {};
+        unsigned prefix_len      = 0;
+
+        //! parses a prefix in CIDR notation, e.g., 2001:db8::/32
+        static ipv6_mask from_str(const std::string& s) {
+
+            auto slash = s.find('/');
+
+            if (slash == std::string::npos)
+                return {ipv6::str_to_addr(s), 128};
+
+            auto prefix_len = (unsigned) std::stoul(s.substr(slash + 1));
+
+            if (prefix_len > 128)
+                throw std::invalid_argument("invalid ipv6 prefix length");
+
+            return {ipv6::str_to_addr(s.substr(0, slash)), prefix_len};
+        }
+
+        inline bool match(const ipv6::addr& test_ip) const {
+
+            unsigned full_bytes = prefix_len / 8, rest_bits = prefix_len % 8;
+
+            if (std::memcmp(test_ip.bytes, ip.bytes, full_bytes) != 0)
+                return false;
+
+            if (rest_bits == 0)
+                return true;
+
+            std::uint8_t mask = 0xff << (8 - rest_bits);
+            return (test_ip.bytes[full_bytes] & mask) == (ip.bytes[full_bytes] & mask);
+        }
+    };
 }
 
 static std::ostream& operator<<(std::ostream& os, const net::ipv4_5tuple& ip_5t) {
@@ -236,6 +500,11 @@ static std::ostream& operator<<(std::ostream& os, const net::ipv4_5tuple& ip_5t)
               << ip_5t.tp_src << "," << net::ipv4::addr_to_str(ip_5t.ip_dst) << "," << ip_5t.tp_dst;
 }
 
+inline std::ostream& operator<<(std::ostream& os, const net::ipv6_5tuple& ip_5t) {
+    return os << (unsigned) ip_5t.ip_proto << "," << net::ipv6::addr_to_str(ip_5t.ip_src) << ","
+              << ip_5t.tp_src << "," << net::ipv6::addr_to_str(ip_5t.ip_dst) << "," << ip_5t.tp_dst;
+}
+
 namespace std {
     template<> struct hash<net::ipv4_5tuple> {
         //! computes a rudimentary std::size_t-length hash over a ipv4_5tuple
@@ -260,6 +529,36 @@ namespace std {
             return h;
         }
     };
+
+    template<> struct hash<net::ipv6::addr> {
+        //! mixes both 64-bit halves of the address with multiply-xorshift rounds
+        //! - IPv6 addresses share long prefixes, so all bits must influence the result
+        std::size_t operator()(const net::ipv6::addr& a) const noexcept {
+            std::uint64_t hi = 0, lo = 0;
+            std::memcpy(&hi, a.bytes, 8);
+            std::memcpy(&lo, a.bytes + 8, 8);
+            std::uint64_t h = (hi ^ (lo * 0x9e3779b97f4a7c15u)) * 0xbf58476d1ce4e5b9u;
+            return (std::size_t) (h ^ (h >> 31u));
+        }
+    };
+
+    template<> struct hash<net::ipv6_5tuple> {
+        std::size_t operator()(const net::ipv6_5tuple& d) const noexcept {
+            std::uint64_t h = hash<net::ipv6::addr>{}(d.ip_src);
+            h = (h ^ hash<net::ipv6::addr>{}(d.ip_dst) ^ (h >> 29u)) * 0x94d049bb133111ebu;
+            h ^= ((std::uint64_t) d.tp_src << 24u) | ((std::uint64_t) d.tp_dst << 8u) | d.ip_proto;
+            h *= 0x9e3779b97f4a7c15u;
+            return (std::size_t) (h ^ (h >> 32u));
+        }
+    };
+
+    template<> struct hash<net::ipv6_port> {
+        std::size_t operator()(const net::ipv6_port& d) const noexcept {
+            std::uint64_t h = hash<net::ipv6::addr>{}(d.ip) ^ ((std::uint64_t) d.port << 48u);
+            h *= 0x9e3779b97f4a7c15u;
+            return (std::size_t) (h ^ (h >> 32u));
+        }
+    };
 }
 
 #endif
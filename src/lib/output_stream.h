@@ -0,0 +1,110 @@
+
+#ifndef ZOOM_ANALYSIS_OUTPUT_STREAM_H
+#define ZOOM_ANALYSIS_OUTPUT_STREAM_H
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <ostream>
+#include <string>
+
+#include "gzip_streambuf.h"
+
+/*!
+ * Output file stream that is gzip-compressed (on a background thread) if its path ends in ".gz"
+ *
+ * - used like std::ofstream, check is_open() after open()
+ * - flush_position() replaces flush() and tellp() when the file size is needed, e.g., for a
+ *   checkpoint: a compressed file can be truncated to the returned size and appended to
+ */
+class output_stream : public std::ostream {
+public:
+
+    output_stream() : std::ostream(nullptr) { }
+
+    explicit output_stream(const std::string& file_path, bool append = false)
+        : std::ostream(nullptr) {
+
+        open(file_path, append);
+    }
+
+    output_stream(const output_stream&) = delete;
+    output_stream& operator=(const output_stream&) = delete;
+
+    output_stream(output_stream&& other) noexcept
+        : std::ostream(std::move(other)), _file(std::move(other._file)), _gz(std::move(other._gz)) {
+
+        _set_rdbuf();
+    }
+
+    output_stream& operator=(output_stream&& other) noexcept {
+
+        std::ostream::operator=(std::move(other));
+        _file = std::move(other._file);
+        _gz = std::move(other._gz);
+        _set_rdbuf();
+        other._set_rdbuf();
+        return *this;
+    }
+
+    [[nodiscard]] static bool is_gzip_path(const std::string& file_path) {
+        return file_path.size() > 3 && file_path.compare(file_path.size() - 3, 3, ".gz") == 0;
+    }
+
+    void open(const std::string& file_path, bool append = false) {
+
+        auto mode = append ? std::ios::out | std::ios::app : std::ios::out;
+
+        if (is_gzip_path(file_path)) {
+            _gz = std::make_unique<gzip_streambuf>(file_path, append);
+            rdbuf(_gz.get());
+        } else {
+            _gz.reset();
+            _file.open(file_path, mode);
+            rdbuf(&_file);
+        }
+
+        clear(is_open() ? std::ios::goodbit : std::ios::failbit);
+    }
+
+    [[nodiscard]] bool is_open() const {
+        return _gz ? _gz->is_open() : _file.is_open();
+    }
+
+    [[nodiscard]] bool compressed() const {
+        return _gz != nullptr;
+    }
+
+    //! writes all data to the file and returns its size in Bytes (ends the gzip member)
+    std::int64_t flush_position() {
+
+        if (_gz)
+            return _gz->end_member();
+
+        flush();
+        return (std::int64_t) tellp();
+    }
+
+    void close() {
+
+        if (_gz) {
+            _gz->close();
+            _gz.reset();
+        } else {
+            _file.close();
+        }
+
+        rdbuf(nullptr);
+    }
+
+private:
+
+    void _set_rdbuf() {
+        set_rdbuf(_gz ? (std::streambuf*) _gz.get() : &_file);
+    }
+
+    std::filebuf _file;
+    std::unique_ptr<gzip_streambuf> _gz;
+};
+
+#endif
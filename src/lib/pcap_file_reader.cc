@@ -92,6 +92,11 @@ unsigned pcap_file_reader::file_count() const {
     return _file_count;
 }
 
+unsigned pcap_file_reader::current_file() const {
+
+    return _current_file;
+}
+
 unsigned long pcap_file_reader::pkt_count() const {
 
     return _pkt_count;
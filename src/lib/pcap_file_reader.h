@@ -18,6 +18,8 @@ public:
     bool next(const unsigned char** buf, timeval& ts, unsigned short& frame_len,
               unsigned short& cap_len);
     [[nodiscard]] unsigned file_count() const;
+    //! returns the index of the file the last packet was read from
+    [[nodiscard]] unsigned current_file() const;
     [[nodiscard]] unsigned long pkt_count() const;
     [[nodiscard]] double time_in_loop() const;
     void close();
@@ -1,17 +1,22 @@
 
 #include "pcap_file_writer.h"
 
-pcap_file_writer::pcap_file_writer(const std::string& file_name, pcap_link_type link_type) {
+pcap_file_writer::pcap_file_writer(const std::string& file_name, pcap_link_type link_type,
+                                   bool append) {
 
-    open(file_name, link_type);
+    open(file_name, link_type, append);
 }
 
-void pcap_file_writer::open(const std::string& file_name, pcap_link_type link_type) {
+void pcap_file_writer::open(const std::string& file_name, pcap_link_type link_type,
+                            bool append) {
 
     if (!(_pcap = pcap_open_dead((int) link_type, 65535)))
         throw std::runtime_error("pcap_file_writer: could not initialize pcap_t");
 
-    if (!(_pcap_dumper = pcap_dump_open(_pcap, file_name.c_str())))
+    _pcap_dumper = append ? pcap_dump_open_append(_pcap, file_name.c_str())
+                          : pcap_dump_open(_pcap, file_name.c_str());
+
+    if (!_pcap_dumper)
         throw std::runtime_error("pcap_file_writer: could not open pcap dump for" + file_name);
 }
 
@@ -44,6 +49,14 @@ unsigned long pcap_file_writer::count() const {
     return _count;
 }
 
+long pcap_file_writer::flush() {
+
+    if (pcap_dump_flush(_pcap_dumper) != 0)
+        throw std::runtime_error("pcap_file_writer: could not flush pcap dump");
+
+    return pcap_dump_ftell(_pcap_dumper);
+}
+
 void pcap_file_writer::close() {
 
     pcap_close(_pcap);
@@ -10,12 +10,16 @@
 class pcap_file_writer {
 public:
     pcap_file_writer() = default;
-    explicit pcap_file_writer(const std::string& file_name, pcap_link_type link_type);
-    void open(const std::string& file_name, pcap_link_type link_type);
+    explicit pcap_file_writer(const std::string& file_name, pcap_link_type link_type,
+                              bool append = false);
+    //! opens a pcap dump, appends to an existing file of the same link type if append is set
+    void open(const std::string& file_name, pcap_link_type link_type, bool append = false);
     void write(const pcap_pkt& pkt);
     void write(const unsigned char** buf, const timeval& timestamp,
                unsigned short frame_len, unsigned short cap_len);
     [[nodiscard]] unsigned long count() const;
+    //! flushes buffered packets and returns the size of the file
+    long flush();
     void close();
 private:
     pcap_t* _pcap = nullptr;
@@ -17,7 +17,9 @@ enum class pcap_link_type : int {
     null           = 0,
     eth            = 1,
     raw            = 101,
-    loop           = 108
+    loop           = 108,
+    ipv4           = 228,
+    ipv6           = 229
 };
 
 static bool operator<(const timeval& a, const timeval& b) {
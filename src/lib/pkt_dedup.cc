@@ -0,0 +1,85 @@
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include "pkt_dedup.h"
+#include "sketches.h"
+
+pkt_dedup::pkt_dedup(std::uint32_t window_us, std::size_t buckets)
+    : _buckets(buckets), _window_us(window_us) {
+
+    if (!sketch::is_power_of_two(buckets))
+        throw std::invalid_argument("pkt_dedup: buckets must be power of two");
+}
+
+std::uint64_t pkt_dedup::fingerprint(const net::ipv4::hdr* ip, const net::ipv4_5tuple& ip_5t,
+                                     std::size_t ip_len) {
+
+    auto ihl = ip->ihl_bytes();
+    auto l4_len = std::min<std::size_t>(ip_len, ntohs(ip->total_length));
+    l4_len = l4_len > ihl ? std::min<std::size_t>(l4_len - ihl, PREFIX_LEN) : 0;
+
+    std::uint64_t h = sketch::mix(((std::uint64_t) ntohs(ip->id) << 48u)
+                                  | ((std::uint64_t) ip_5t.ip_proto << 32u)
+                                  | ((std::uint64_t) ip_5t.tp_src << 16u) | ip_5t.tp_dst);
+
+    h = sketch::mix(h ^ (((std::uint64_t) ip_5t.ip_src << 32u) | ip_5t.ip_dst));
+
+    // the prefix is zero-padded to PREFIX_LEN, its length is part of the first word
+    unsigned char prefix[PREFIX_LEN] = {0};
+    std::memcpy(prefix, (const unsigned char*) ip + ihl, l4_len);
+
+    for (unsigned i = 0; i < PREFIX_LEN; i += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, prefix + i, 8);
+        h = sketch::mix(h ^ word ^ (i == 0 ? l4_len : 0));
+    }
+
+    // the non-zero marker is the top bit, buckets are indexed from the low bits
+    return h | (1ull << 63u);
+}
+
+bool pkt_dedup::is_duplicate(const net::ipv4::hdr* ip, const net::ipv4_5tuple& ip_5t,
+                             std::size_t ip_len, const timeval& ts) {
+
+    auto fp = fingerprint(ip, ip_5t, ip_len);
+    auto ts_us = (std::int64_t) ts.tv_sec * 1000000 + ts.tv_usec;
+    auto& b = _buckets[fp & (_buckets.size() - 1)];
+    slot* oldest = &b.slots[0];
+
+    _checked_count++;
+
+    for (auto& s: b.slots) {
+
+        if (s.fingerprint == fp && std::abs(ts_us - s.ts_us) <= (std::int64_t) _window_us) {
+            _dropped_count++;
+            return true;
+        }
+
+        if (s.fingerprint == 0 || s.ts_us < oldest->ts_us) {
+            oldest = &s;
+        }
+
+        if (s.fingerprint == 0) break;
+    }
+
+    *oldest = {fp, ts_us};
+    return false;
+}
+
+void pkt_dedup::save(checkpoint::writer& w) const {
+    w.write((std::uint64_t) _buckets.size()), w.write(_window_us);
+    w.write(_checked_count), w.write(_dropped_count);
+    w.write(_buckets);
+}
+
+void pkt_dedup::restore(checkpoint::reader& r) {
+
+    if (r.read<std::uint64_t>() != _buckets.size() || r.read<std::uint32_t>() != _window_us)
+        throw std::runtime_error("pkt_dedup: checkpoint was taken with other settings");
+
+    r.read(_checked_count), r.read(_dropped_count);
+    r.read(_buckets);
+}
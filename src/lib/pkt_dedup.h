@@ -0,0 +1,84 @@
+
+#ifndef ZOOM_ANALYSIS_PKT_DEDUP_H
+#define ZOOM_ANALYSIS_PKT_DEDUP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "checkpoint.h"
+#include "net.h"
+
+/*!
+ * Drops copies of IPv4 packets captured more than once, e.g., by several mirrored switch ports
+ *
+ * - a packet is identified by a 64 bit fingerprint of its IP ID, 5-tuple and the first
+ *   PREFIX_LEN bytes following the IP header (transport header and start of the payload);
+ *   fields that change between hops (TTL, IP checksum) are left out
+ * - a packet is a duplicate if a packet with the same fingerprint was seen within window_us
+ *   microseconds (in either direction, since merged captures may be slightly out of order)
+ * - fingerprints are kept in a fixed-size table of buckets with WAYS slots, each bucket fills
+ *   exactly one cache line; when a bucket is full, the oldest fingerprint is replaced
+ * - fixed memory: buckets * 64 Bytes, 256 KB by default to stay cache-resident
+ */
+class pkt_dedup {
+public:
+
+    static const unsigned PREFIX_LEN = 24;
+    static const unsigned WAYS = 4;
+
+    explicit pkt_dedup(std::uint32_t window_us = 1000, std::size_t buckets = 1 << 12);
+
+    pkt_dedup(const pkt_dedup&) = default;
+    pkt_dedup& operator=(const pkt_dedup&) = default;
+
+    //! returns true if the packet is a duplicate and counts it as dropped, otherwise remembers it
+    //! - ip_len is the number of captured bytes starting at the IP header
+    bool is_duplicate(const net::ipv4::hdr* ip, const net::ipv4_5tuple& ip_5t, std::size_t ip_len,
+                      const timeval& ts);
+
+    //! returns the fingerprint is_duplicate() uses for a packet (never 0)
+    [[nodiscard]] static std::uint64_t fingerprint(const net::ipv4::hdr* ip,
+            const net::ipv4_5tuple& ip_5t, std::size_t ip_len);
+
+    void save(checkpoint::writer& w) const;
+
+    //! replaces the state with a checkpoint written by save()
+    //! - throws std::runtime_error if the checkpoint was taken with another table size or window
+    void restore(checkpoint::reader& r);
+
+    [[nodiscard]] inline std::uint64_t checked_count() const {
+        return _checked_count;
+    }
+
+    [[nodiscard]] inline std::uint64_t dropped_count() const {
+        return _dropped_count;
+    }
+
+    [[nodiscard]] inline std::uint32_t window_us() const {
+        return _window_us;
+    }
+
+    [[nodiscard]] inline std::size_t memory_bytes() const {
+        return _buckets.size() * sizeof(bucket);
+    }
+
+private:
+
+    struct slot {
+        std::uint64_t fingerprint = 0; // 0: empty
+        std::int64_t ts_us = 0;
+    };
+
+    struct alignas(64) bucket {
+        slot slots[WAYS] = {};
+    };
+
+    static_assert(sizeof(bucket) == 64);
+
+    std::vector<bucket> _buckets;
+    std::uint32_t _window_us = 1000;
+    std::uint64_t _checked_count = 0, _dropped_count = 0;
+};
+
+#endif
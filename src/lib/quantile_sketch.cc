@@ -0,0 +1,124 @@
+
+#include "quantile_sketch.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+    //! bins added beyond the range of a new value, such that a slowly widening range does not
+    //! reallocate the bins for every new bin
+    const int EXTEND_SLACK = 16;
+}
+
+ddsketch::ddsketch(double rel_accuracy, unsigned max_bins)
+    : _rel_accuracy(rel_accuracy),
+      _gamma((1 + rel_accuracy) / (1 - rel_accuracy)),
+      _inv_log_gamma(1 / std::log(_gamma)),
+      _max_bins(std::max(max_bins, 1u)) {
+
+    if (!(rel_accuracy > 0 && rel_accuracy < 1))
+        throw std::invalid_argument("ddsketch: relative accuracy must be between 0 and 1");
+}
+
+void ddsketch::merge(const ddsketch& other) {
+
+    if (other._rel_accuracy != _rel_accuracy)
+        throw std::invalid_argument("ddsketch::merge(): different relative accuracies");
+
+    if (other._bins.empty()) {
+        _count += other._count, _zero_count += other._zero_count;
+        return;
+    }
+
+    // extends to the range of the other sketch once
+    _add_to_bin(other._offset, 0);
+    _add_to_bin(other._offset + (int) other._bins.size() - 1, 0);
+
+    for (std::size_t i = 0; i < other._bins.size(); i++) {
+        if (other._bins[i])
+            _add_to_bin(other._offset + (int) i, other._bins[i]);
+    }
+
+    _count += other._count, _zero_count += other._zero_count;
+}
+
+double ddsketch::quantile(double q) const {
+
+    if (_count == 0)
+        return -1;
+
+    auto rank = (std::uint64_t) (std::clamp(q, 0.0, 1.0) * (double) (_count - 1));
+
+    if (rank < _zero_count)
+        return 0;
+
+    auto seen = _zero_count;
+    std::size_t i = 0;
+
+    for (; i + 1 < _bins.size(); i++) {
+
+        seen += _bins[i];
+
+        if (seen > rank)
+            break;
+    }
+
+    return 2 * std::pow(_gamma, _offset + (int) i) / (_gamma + 1);
+}
+
+void ddsketch::clear() {
+
+    std::fill(_bins.begin(), _bins.end(), 0);
+    _count = 0, _zero_count = 0;
+}
+
+void ddsketch::save(checkpoint::writer& w) const {
+    w.write(_rel_accuracy), w.write(_max_bins), w.write(_count), w.write(_zero_count);
+    w.write(_offset), w.write(_bins);
+}
+
+void ddsketch::restore(checkpoint::reader& r) {
+
+    r.read(_rel_accuracy), r.read(_max_bins), r.read(_count), r.read(_zero_count);
+    r.read(_offset), r.read(_bins);
+
+    if (!(_rel_accuracy > 0 && _rel_accuracy < 1) || _max_bins == 0
+        || _bins.size() > _max_bins || _zero_count > _count)
+        throw std::runtime_error("ddsketch::restore(): invalid checkpoint");
+
+    _gamma = (1 + _rel_accuracy) / (1 - _rel_accuracy);
+    _inv_log_gamma = 1 / std::log(_gamma);
+}
+
+void ddsketch::_add_to_bin(int i, std::uint64_t n) {
+
+    if (_bins.empty() || i < _offset || i >= _offset + (int) _bins.size())
+        _extend(i);
+
+    // bins below the lowest one were collapsed into it
+    _bins[(std::size_t) std::max(i - _offset, 0)] += n;
+}
+
+void ddsketch::_extend(int i) {
+
+    int lo = i, hi = i;
+
+    if (!_bins.empty()) {
+        auto slack = std::min(EXTEND_SLACK, (int) _max_bins / 8);
+        auto old_hi = _offset + (int) _bins.size() - 1;
+        lo = i < _offset ? i - slack : _offset;
+        hi = i > old_hi ? i + slack : old_hi;
+    }
+
+    if (hi - lo + 1 > (int) _max_bins)
+        lo = hi - (int) _max_bins + 1;
+
+    std::vector<std::uint64_t> bins((std::size_t) (hi - lo + 1), 0);
+
+    for (std::size_t j = 0; j < _bins.size(); j++)
+        bins[(std::size_t) std::max(_offset + (int) j - lo, 0)] += _bins[j];
+
+    _bins = std::move(bins);
+    _offset = lo;
+}
@@ -0,0 +1,81 @@
+#ifndef ZOOM_ANALYSIS_QUANTILE_SKETCH_H
+#define ZOOM_ANALYSIS_QUANTILE_SKETCH_H
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "checkpoint.h"
+
+/*!
+ * DDSketch of non-negative values: quantiles within a relative error, fully mergeable
+ *
+ * - values are counted in logarithmic bins, bin i covers (g^(i-1), g^i] with
+ *   g = (1 + rel_accuracy) / (1 - rel_accuracy), a quantile is reported as 2 g^i / (g + 1), which
+ *   is within rel_accuracy of every value of its bin
+ * - the bins are a dense array over the range of bins seen so far, beyond max_bins the lowest bins
+ *   are collapsed into one, such that only low quantiles lose their accuracy
+ * - values below MIN_VALUE (including 0 and negative values) are counted as 0
+ * - see Masson et al., "DDSketch: A Fast and Fully-Mergeable Quantile Sketch with Relative-Error
+ *   Guarantees", VLDB 2019
+ */
+class ddsketch {
+
+public:
+
+    static constexpr double MIN_VALUE = 1e-6;
+
+    explicit ddsketch(double rel_accuracy = 0.01, unsigned max_bins = 2048);
+
+    inline void add(double x) {
+
+        _count++;
+
+        if (x < MIN_VALUE) {
+            _zero_count++;
+        } else {
+            _add_to_bin((int) std::ceil(std::log(x) * _inv_log_gamma), 1);
+        }
+    }
+
+    //! adds the values of a sketch of the same relative accuracy, throws std::invalid_argument
+    //! otherwise
+    void merge(const ddsketch& other);
+
+    //! value at quantile q (0 to 1), -1 if empty
+    [[nodiscard]] double quantile(double q) const;
+
+    [[nodiscard]] std::uint64_t count() const {
+        return _count;
+    }
+
+    [[nodiscard]] bool empty() const {
+        return _count == 0;
+    }
+
+    [[nodiscard]] double rel_accuracy() const {
+        return _rel_accuracy;
+    }
+
+    //! removes all values, keeps the memory of the bins
+    void clear();
+
+    void save(checkpoint::writer& w) const;
+    void restore(checkpoint::reader& r);
+
+private:
+
+    void _add_to_bin(int i, std::uint64_t n);
+
+    //! extends the bins to cover bin i, collapses the lowest bins beyond max_bins
+    void _extend(int i);
+
+    double _rel_accuracy = 0.01, _gamma = 1, _inv_log_gamma = 1;
+    unsigned _max_bins = 2048;
+
+    std::uint64_t _count = 0, _zero_count = 0;
+    int _offset = 0; // bin of _bins[0]
+    std::vector<std::uint64_t> _bins;
+};
+
+#endif
@@ -7,6 +7,8 @@
 #include <stdexcept>
 #include <vector>
 
+#include "checkpoint.h"
+
 template<typename Type>
 class ring_buffer {
 public:
@@ -74,6 +76,24 @@ public:
         return _head == _tail;
     }
 
+    //! writes the contents of the ring to a checkpoint
+    void save(checkpoint::writer& w) const {
+        w.write(_ring);
+        w.write(_head);
+        w.write(_tail);
+    }
+
+    //! restores the contents of the ring from a checkpoint
+    void restore(checkpoint::reader& r) {
+        r.read(_ring);
+        r.read(_head);
+        r.read(_tail);
+        _size = _ring.size();
+
+        if (!_is_power_of_two(_size) || _head >= _size || _tail >= _size)
+            throw std::runtime_error("ring_buffer::restore(): invalid checkpoint");
+    }
+
     ~ring_buffer() = default;
 
 private:
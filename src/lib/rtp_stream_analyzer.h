@@ -1,8 +1,13 @@
 #ifndef ZOOM_ANALYSIS_RTP_STREAM_ANALYZER_H
 #define ZOOM_ANALYSIS_RTP_STREAM_ANALYZER_H
 
+#include <algorithm>
+#include <array>
 #include <cstdint>
 #include <functional>
+#include <limits>
+#include <memory>
+#include <type_traits>
 
 #include <string>
 #include <sstream>
@@ -10,20 +15,39 @@
 #include <iomanip>
 #include <cassert>
 
+#include "checkpoint.h"
 #include "fps_calculator.h"
 #include "jitter_calculator.h"
 #include "pcap_util.h"
+#include "quantile_sketch.h"
 
 struct rtp_stream_analyzer_empty_meta { };
 
+/*!
+ * Analyzes an RTP stream, reports evicted frames, 1s stats and rolled-up stats to a sink
+ *
+ * - Sink = void (default): the handlers are std::function objects passed to the constructor
+ * - otherwise, Sink is stored by value and its member functions are called directly (and can be
+ *   inlined), it must provide
+ *     void frame(const Analyzer& a, const Analyzer::frame& f);
+ *     void stats(const Analyzer& a, unsigned report_count, unsigned ts, const Analyzer::stats& c);
+ *     void rollup(const Analyzer& a, unsigned resolution_s, unsigned report_count, unsigned ts,
+ *                 const Analyzer::stats& c);
+ * - Jitter computes the jitter of the evicted frames: jitter_calculator (default, through
+ *   wallclock milliseconds) or rfc3550_jitter_calculator (fixed point, in RTP units)
+ */
 template <
     typename StreamMeta = rtp_stream_analyzer_empty_meta,
     typename PacketMeta = rtp_stream_analyzer_empty_meta,
-    unsigned Len = 32>
+    unsigned Len = 32,
+    typename Sink = void,
+    typename Jitter = jitter_calculator>
 class rtp_stream_analyzer {
 
 public:
 
+    //! packet of the ring (see frame::pkt_at())
+    //! - the ring stores its fields in packed per-field arrays, see _packed_ring
     struct pkt {
         bool empty            = true;
         bool seen             = false;
@@ -34,6 +58,119 @@ public:
         PacketMeta meta       = {};
     };
 
+private:
+
+    static constexpr std::int32_t _TS_NONE = std::numeric_limits<std::int32_t>::min();
+
+    /*!
+     * Packets of the ring as packed per-field arrays, indexed by slot
+     *
+     * - timestamps are 32-bit microseconds relative to ts_base_us, _TS_NONE stands for {0, 0}
+     *   (skipped packets and empty slots), which keeps it the smallest timestamp
+     * - the base is moved once a timestamp is more than INT32_MAX us (~35.8 min) ahead of or
+     *   behind it, such that the timestamp is 2^30 us (~17.9 min) from the new base; timestamps
+     *   more than ~53.7 min before the newest packet are then clamped
+     * - the empty and seen flags are bit sets
+     */
+    struct _packed_ring {
+        static constexpr unsigned WORDS = (Len + 63) / 64;
+
+        std::array<std::uint16_t, Len> rtp_seq = {};
+        std::array<std::uint32_t, Len> rtp_ts  = {};
+        std::array<std::int32_t, Len> ts       = {};
+        std::array<std::uint16_t, Len> pl_len  = {}; // UDP payload, < 65536 Bytes
+        std::array<PacketMeta, Len> meta       = {};
+        std::array<std::uint64_t, WORDS> empty = {};
+        std::array<std::uint64_t, WORDS> seen  = {};
+        std::int64_t ts_base_us                = 0;
+
+        _packed_ring() {
+            clear();
+        }
+
+        [[nodiscard]] inline bool is_empty(unsigned i) const {
+            return (empty[i / 64] >> (i % 64)) & 1u;
+        }
+
+        [[nodiscard]] inline bool is_seen(unsigned i) const {
+            return (seen[i / 64] >> (i % 64)) & 1u;
+        }
+
+        inline void set_flags(unsigned i, bool is_empty, bool is_seen) {
+            auto bit = (std::uint64_t) 1 << (i % 64);
+            empty[i / 64] = is_empty ? empty[i / 64] | bit : empty[i / 64] & ~bit;
+            seen[i / 64] = is_seen ? seen[i / 64] | bit : seen[i / 64] & ~bit;
+        }
+
+        [[nodiscard]] inline timeval to_timeval(std::int32_t rel_us) const {
+
+            if (rel_us == _TS_NONE)
+                return {0, 0};
+
+            auto us = ts_base_us + rel_us;
+            return {(decltype(timeval::tv_sec)) (us / 1000000),
+                    (decltype(timeval::tv_usec)) (us % 1000000)};
+        }
+
+        //! the timestamp relative to the base, moves the base if it is out of range
+        [[nodiscard]] inline std::int32_t to_rel(const timeval& tv) {
+
+            if (tv.tv_sec == 0 && tv.tv_usec == 0)
+                return _TS_NONE;
+
+            auto us = (std::int64_t) tv.tv_sec * 1000000 + tv.tv_usec;
+
+            if (us - ts_base_us <= _TS_NONE || us - ts_base_us > INT32_MAX_US)
+                _rebase(us < ts_base_us ? us + (1 << 30) : us - (1 << 30));
+
+            return (std::int32_t) (us - ts_base_us);
+        }
+
+        [[nodiscard]] struct pkt pkt(unsigned i) const {
+            return {
+                .empty = is_empty(i), .seen = is_seen(i), .rtp_seq = rtp_seq[i],
+                .rtp_ts = rtp_ts[i], .ts = to_timeval(ts[i]), .pl_len = pl_len[i],
+                .meta = meta[i]
+            };
+        }
+
+        //! stores a packet in slot i, the timestamp is converted after other slots are read
+        inline void set(unsigned i, std::uint16_t seq, std::uint32_t rtp_timestamp,
+                        const timeval& tv, unsigned len, bool is_seen, const PacketMeta& m) {
+            set_flags(i, false, is_seen);
+            rtp_seq[i] = seq, rtp_ts[i] = rtp_timestamp, ts[i] = to_rel(tv);
+            pl_len[i] = (std::uint16_t) len, meta[i] = m;
+        }
+
+        void clear() {
+            rtp_seq = {}, rtp_ts = {}, pl_len = {}, meta = {}, seen = {};
+            ts.fill(_TS_NONE);
+            empty.fill(~(std::uint64_t) 0);
+        }
+
+    private:
+
+        static constexpr std::int64_t INT32_MAX_US = std::numeric_limits<std::int32_t>::max();
+
+        void _rebase(std::int64_t base_us) {
+
+            for (auto& t: ts) {
+
+                if (t != _TS_NONE) {
+                    auto us = std::max(std::min(t + ts_base_us - base_us, INT32_MAX_US),
+                                       (std::int64_t) _TS_NONE + 1);
+                    t = (std::int32_t) us;
+                }
+            }
+
+            ts_base_us = base_us;
+        }
+    };
+
+public:
+
+    //! frame evicted from the ring, its packets are not copied but referenced in the ring
+    //! - only valid during the call of the frame handler
     struct frame {
         std::uint32_t rtp_ts  = 0;
         unsigned pkts_seen    = 0;
@@ -42,7 +179,41 @@ public:
         unsigned total_pl_len = 0;
         unsigned fps          = 0;
         double jitter         = 0.0;
-        struct pkt pkts[Len]  = {};
+
+        //! the i-th seen packet of the frame (in order of sequence numbers), i < pkts_seen
+        [[nodiscard]] inline struct pkt pkt_at(unsigned i) const {
+            return _ring->pkt(_slots[i]);
+        }
+
+    private:
+        friend class rtp_stream_analyzer;
+
+        using slot = std::conditional_t<Len <= 256, std::uint8_t, std::uint16_t>;
+
+        //! starts an empty frame at a ring slot, _slots stays uninitialized
+        inline void _init(const _packed_ring& ring, unsigned idx) {
+            _ring = &ring;
+            rtp_ts = ring.rtp_ts[idx], _ts_min = ring.ts[idx], _ts_max = ring.ts[idx];
+        }
+
+        inline void _add(unsigned idx) {
+
+            auto ts = _ring->ts[idx];
+            _slots[pkts_seen++] = (slot) idx;
+            total_pl_len += _ring->pl_len[idx];
+
+            _ts_min = ts < _ts_min ? ts : _ts_min;
+            _ts_max = ts > _ts_max ? ts : _ts_max;
+        }
+
+        //! sets ts_min and ts_max once all packets are added
+        inline void _finish() {
+            ts_min = _ring->to_timeval(_ts_min), ts_max = _ring->to_timeval(_ts_max);
+        }
+
+        const _packed_ring* _ring = nullptr;
+        std::int32_t _ts_min = 0, _ts_max = 0;
+        slot _slots[Len];
     };
 
     struct timestamps {
@@ -84,6 +255,18 @@ public:
             return total_frames ? (jitter_sum / (double) total_frames) : -1;
         }
 
+        struct stats& operator+=(const struct stats& other) {
+            total_pkts        += other.total_pkts;
+            total_bytes       += other.total_bytes;
+            out_of_order_pkts += other.out_of_order_pkts;
+            duplicate_pkts    += other.duplicate_pkts;
+            lost_pkts         += other.lost_pkts;
+            total_frames      += other.total_frames;
+            frame_size_sum    += other.frame_size_sum;
+            jitter_sum        += other.jitter_sum;
+            return *this;
+        }
+
         struct stats operator-(const struct stats& other) {
 
             if (total_pkts < other.total_pkts
@@ -107,21 +290,83 @@ public:
         }
     };
 
+    //! resolutions of the rolled-up stats in seconds, the 1s stats are reported separately
+    static constexpr std::array<unsigned, 3> ROLLUP_RESOLUTIONS = {10, 60, 300};
+
+    //! quantile sketches of the evicted frames of an interval or stream (see enable_quantiles())
+    struct frame_sketches {
+        ddsketch jitter_ms, frame_size, frame_gap_ms, fps;
+
+        explicit frame_sketches(double rel_accuracy = 0.01)
+            : jitter_ms(rel_accuracy), frame_size(rel_accuracy), frame_gap_ms(rel_accuracy),
+              fps(rel_accuracy) { }
+
+        void merge(const frame_sketches& other) {
+            jitter_ms.merge(other.jitter_ms), frame_size.merge(other.frame_size);
+            frame_gap_ms.merge(other.frame_gap_ms), fps.merge(other.fps);
+        }
+
+        void clear() {
+            jitter_ms.clear(), frame_size.clear(), frame_gap_ms.clear(), fps.clear();
+        }
+
+        void save(checkpoint::writer& w) const {
+            jitter_ms.save(w), frame_size.save(w), frame_gap_ms.save(w), fps.save(w);
+        }
+
+        void restore(checkpoint::reader& r) {
+            jitter_ms.restore(r), frame_size.restore(r), frame_gap_ms.restore(r), fps.restore(r);
+        }
+    };
+
     using FrameHandlerFx = std::function<void (const rtp_stream_analyzer& a, const frame&)>;
     using StatsHandlerFx = std::function<void (const rtp_stream_analyzer& a, unsigned report_count,
                                                unsigned ts, const stats&)>;
+    using RollupHandlerFx = std::function<void (const rtp_stream_analyzer& a, unsigned resolution_s,
+                                                unsigned report_count, unsigned ts, const stats&)>;
+
+    //! sink of the std::function handlers (Sink = void), the stats handlers are optional
+    struct function_sink {
+        FrameHandlerFx frame_handler;
+        StatsHandlerFx stats_handler;
+        RollupHandlerFx rollup_handler;
+
+        inline void frame(const rtp_stream_analyzer& a, const struct frame& f) {
+            frame_handler(a, f);
+        }
+
+        inline void stats(const rtp_stream_analyzer& a, unsigned report_count, unsigned ts,
+                          const struct stats& c) {
+            if (stats_handler)
+                stats_handler(a, report_count, ts, c);
+        }
+
+        inline void rollup(const rtp_stream_analyzer& a, unsigned resolution_s,
+                           unsigned report_count, unsigned ts, const struct stats& c) {
+            if (rollup_handler)
+                rollup_handler(a, resolution_s, report_count, ts, c);
+        }
+    };
+
+    using sink_type = std::conditional_t<std::is_void_v<Sink>, function_sink, Sink>;
 
     rtp_stream_analyzer() = delete;
 
+    template <typename S = Sink, typename = std::enable_if_t<std::is_void_v<S>>>
     explicit rtp_stream_analyzer(
             FrameHandlerFx&& frame_handler,
             StatsHandlerFx&& stats_handler,
             unsigned sampling_rate_khz = 90000,
             const StreamMeta& meta = {})
-        : _frame_handler(std::move(frame_handler)),
-          _stats_handler(std::move(stats_handler)),
+        : rtp_stream_analyzer(function_sink{std::move(frame_handler), std::move(stats_handler), {}},
+                              sampling_rate_khz, meta) { }
+
+    explicit rtp_stream_analyzer(
+            sink_type sink,
+            unsigned sampling_rate_khz = 90000,
+            const StreamMeta& meta = {})
+        : _sink(std::move(sink)),
           _meta(meta),
-          _fps_calc(512),
           _jitter_calc(sampling_rate_khz) {
 
         static_assert(Len >= 8 && _is_power_of_two(Len));
@@ -138,16 +383,13 @@ public:
         _timestamps.update(rtp_ts, ts);
 
         if (_counters.total_pkts == 0) { // initial entry
-            _ring[0] = {
-                .empty = false, .seen = true, .rtp_seq = rtp_seq, .rtp_ts = rtp_ts, .ts = ts,
-                .pl_len = pl_len
-            };
+            _ring.set(0, rtp_seq, rtp_ts, ts, pl_len, true, {});
 
             _current_ts_s = ts.tv_sec;
 
         } else {
 
-            auto head_seq = _ring[_head].rtp_seq;
+            auto head_seq = _ring.rtp_seq[_head];
 
             if (rtp_seq > head_seq) { // seq # larger than highest seen seq #
 
@@ -188,10 +430,15 @@ public:
             }
 
             if (ts.tv_sec > _current_ts_s) {
-                _stats_handler(*this, _stats_report_count++, _current_ts_s, _current_ts_counters);
+
+                _sink.stats(*this, _stats_report_count, _current_ts_s, _current_ts_counters);
+
+                _stats_report_count++;
+                _roll_up(_current_ts_s, _current_ts_counters);
 
                 _current_ts_counters = {};
                 _current_ts_s = ts.tv_sec;
+                _end_second_sketches();
             }
 
         }
@@ -204,39 +451,77 @@ public:
         return _counters;
     }
 
+    //! reports the stats of each ROLLUP_RESOLUTIONS interval (aligned to multiples of the
+    //! resolution) to handler once a later interval starts
+    //! - rollups are summed up from the 1s stats, whether or not a stats handler is set
+    //! - with a Sink, its rollup() is called instead
+    template <typename S = Sink, typename = std::enable_if_t<std::is_void_v<S>>>
+    void set_rollup_handler(RollupHandlerFx&& handler) {
+        _sink.rollup_handler = std::move(handler);
+    }
+
     const struct timestamps& timestamps() const {
         return _timestamps;
     }
 
+    //! sketches the jitter, size, gap to the previous frame (by ts_max) and fps of the evicted
+    //! frames per 1s interval, rollup interval and for the whole stream
+    //! - the sketches are reported along with the stats, see reported_sketches()
+    //! - costs a few hundred Bytes to a few KB of heap memory per stream
+    void enable_quantiles(double rel_accuracy = 0.01) {
+        _quantiles.reset(new _quantile_state(rel_accuracy));
+    }
+
+    [[nodiscard]] bool quantiles_enabled() const {
+        return (bool) _quantiles;
+    }
+
+    //! the sketches of the interval reported to stats() (resolution_s = 1) or rollup() at
+    //! resolution_s, only valid during the call, nullptr if quantiles are not enabled
+    [[nodiscard]] const frame_sketches* reported_sketches(unsigned resolution_s) const {
+
+        if (!_quantiles)
+            return nullptr;
+
+        for (unsigned i = 0; i < ROLLUP_RESOLUTIONS.size(); i++) {
+            if (ROLLUP_RESOLUTIONS[i] == resolution_s)
+                return &_quantiles->rollups[i];
+        }
+
+        return &_quantiles->second;
+    }
+
+    //! the sketches of all frames of the stream so far, empty if quantiles are not enabled
+    [[nodiscard]] frame_sketches stream_sketches() const {
+
+        if (!_quantiles)
+            return frame_sketches{};
+
+        auto sketches = _quantiles->stream;
+        sketches.merge(_quantiles->second);
+        return sketches;
+    }
+
     void flush() {
 
         for (unsigned i = 0; i < Len;) {
             unsigned idx = _idx(_head+i+1);
 
-            if (_ring[idx].empty) {
+            if (_ring.is_empty(idx)) {
                 i++;
             } else {
                 unsigned j = 0;
-                struct frame evict_frame{};
-                evict_frame.rtp_ts = _ring[idx].rtp_ts;
-                evict_frame.ts_min = _ring[idx].ts;
-                evict_frame.ts_max = _ring[idx].ts;
-
-                for (; j < Len && (_ring[_idx(idx+j)].rtp_ts == _ring[idx].rtp_ts
-                        || (_ring[_idx(idx+j)].rtp_ts == 0 && !_ring[_idx(idx+j)].empty)); j++) {
+                struct frame evict_frame;
+                evict_frame._init(_ring, idx);
 
-                    if (_ring[_idx(idx+j)].rtp_ts != 0) {
-                        evict_frame.pkts[evict_frame.pkts_seen++] = _ring[_idx(idx + j)];
-                        evict_frame.total_pl_len += _ring[_idx(idx + j)].pl_len;
+                for (; j < Len && (_ring.rtp_ts[_idx(idx+j)] == _ring.rtp_ts[idx]
+                        || (_ring.rtp_ts[_idx(idx+j)] == 0 && !_ring.is_empty(_idx(idx+j)))); j++) {
 
-                        evict_frame.ts_min = _ring[_idx(idx + j)].ts < evict_frame.ts_min ?
-                                             _ring[_idx(idx + j)].ts : evict_frame.ts_min;
-
-                        evict_frame.ts_max = _ring[_idx(idx + j)].ts > evict_frame.ts_max ?
-                                             _ring[_idx(idx + j)].ts : evict_frame.ts_max;
+                    if (_ring.rtp_ts[_idx(idx+j)] != 0) {
+                        evict_frame._add(_idx(idx + j));
                     }
 
-                    if (!_ring[_idx(idx+j)].empty && !_ring[_idx(idx+j)].seen) {
+                    if (!_ring.is_empty(_idx(idx+j)) && !_ring.is_seen(_idx(idx+j))) {
                         _counters.lost_pkts += 1, _current_ts_counters.lost_pkts += 1;
                     }
                 }
@@ -250,28 +535,103 @@ public:
         }
     }
 
-    void reset() {
+    //! reports the frames left in the ring, the stats of the current second and of the current
+    //! rollup intervals, e.g., once the stream ended
+    //! - empties the ring, stats() and timestamps() still cover the whole stream
+    void finish() {
+
+        flush();
+        _ring.clear();
+        flush_stats();
+    }
+
+    //! reports the stats of the current second and of the current rollup intervals without the
+    //! frames left in the ring, e.g., at the end of the input if the stream is not finished
+    //! - like finish(), only once after the last add()
+    void flush_stats() {
+
+        if (_counters.total_pkts == 0)
+            return;
+
+        _sink.stats(*this, _stats_report_count++, _current_ts_s, _current_ts_counters);
+        _roll_up(_current_ts_s, _current_ts_counters);
+        _current_ts_counters = {};
+        _end_second_sketches();
 
-        for (unsigned i = 0; i < Len; i++) {
-            _ring[i] = { };
+        for (unsigned i = 0; i < ROLLUP_RESOLUTIONS.size(); i++) {
+
+            auto& r = _rollups[i];
+
+            if (r.active) {
+                _sink.rollup(*this, ROLLUP_RESOLUTIONS[i], r.report_count++, r.start_ts,
+                             r.counters);
+
+                r.active = false;
+                r.counters = {};
+
+                if (_quantiles)
+                    _quantiles->rollups[i].clear();
+            }
         }
+    }
 
-        _head = 0, _counters = {}, _current_ts_counters = {};
+    void reset() {
+
+        _ring.clear();
+
+        _head = 0, _counters = {}, _current_ts_counters = {}, _rollups = {};
+
+        if (_quantiles)
+            enable_quantiles(_quantiles->stream.fps.rel_accuracy());
     }
 
     inline const StreamMeta& meta() const {
         return _meta;
     }
 
+    //! writes the ring, counters and calculators to a checkpoint (handlers are not saved)
+    void save(checkpoint::writer& w) const {
+        w.write(_head), w.write(_counters), w.write(_ring), w.write(_meta);
+        _fps_calc.save(w);
+        _jitter_calc.save(w);
+        w.write(_current_ts_s), w.write(_stats_report_count), w.write(_current_ts_counters);
+        w.write(_timestamps);
+        w.write(_rollups);
+        w.write(quantiles_enabled());
+
+        if (_quantiles)
+            _quantiles->save(w);
+    }
+
+    //! restores the state written by save() while keeping the handlers of this analyzer
+    void restore(checkpoint::reader& r) {
+        r.read(_head), r.read(_counters), r.read(_ring), r.read(_meta);
+        _fps_calc.restore(r);
+        _jitter_calc.restore(r);
+        r.read(_current_ts_s), r.read(_stats_report_count), r.read(_current_ts_counters);
+        r.read(_timestamps);
+        r.read(_rollups);
+
+        if (r.read<bool>()) {
+            _quantiles.reset(new _quantile_state());
+            _quantiles->restore(r);
+        } else {
+            _quantiles.reset();
+        }
+
+        if (_head >= Len)
+            throw std::runtime_error("rtp_stream_analyzer: invalid checkpoint");
+    }
+
     virtual ~rtp_stream_analyzer() = default;
 
     /*
     std::string _debug_string() const {
         std::stringstream ss;
         for (auto i = 0; i < Len; i++) {
-            ss << "[" << (i == (_head % Len) ? "H" : "-") << "," << (_ring[i].empty ? "E" : "-")
-                << "," << (_ring[i].seen ? "S" : "-") << "," << _ring[i].rtp_seq << ","
-                << _ring[i].rtp_ts << "]";
+            ss << "[" << (i == (_head % Len) ? "H" : "-") << "," << (_ring.is_empty(i) ? "E" : "-")
+                << "," << (_ring.is_seen(i) ? "S" : "-") << "," << _ring.rtp_seq[i] << ","
+                << _ring.rtp_ts[i] << "]";
         }
         return ss.str();
     }
@@ -290,35 +650,27 @@ private:
     void _set(unsigned idx, std::uint16_t rtp_seq, std::uint32_t rtp_ts, const timeval& ts,
               unsigned pl_len, bool seen, const PacketMeta& meta) {
 
-        if (_ring[idx].seen && _ring[idx].rtp_seq == rtp_seq) {
+        if (_ring.is_seen(idx) && _ring.rtp_seq[idx] == rtp_seq) {
             _counters.duplicate_pkts += 1, _current_ts_counters.duplicate_pkts += 1;
         }
 
-        if (!_ring[idx].empty && _ring[idx].seen && _ring[idx].rtp_seq != rtp_seq) {
+        if (!_ring.is_empty(idx) && _ring.is_seen(idx) && _ring.rtp_seq[idx] != rtp_seq) {
 
-            struct frame evict_frame{};
-            evict_frame.rtp_ts = _ring[idx].rtp_ts;
-            evict_frame.ts_min = _ring[idx].ts;
-            evict_frame.ts_max = _ring[idx].ts;
+            // the evicted slots keep their packets until slot idx is replaced below
+            struct frame evict_frame;
+            evict_frame._init(_ring, idx);
 
-            for (unsigned i = idx, j = 0; j < Len && ((!_ring[i].empty && _ring[i].rtp_ts == 0)
-                    || _ring[i].rtp_ts == _ring[idx].rtp_ts); i = _idx(i + 1), j++) {
+            for (unsigned i = idx, j = 0; j < Len && ((!_ring.is_empty(i) && _ring.rtp_ts[i] == 0)
+                    || _ring.rtp_ts[i] == _ring.rtp_ts[idx]); i = _idx(i + 1), j++) {
 
-                if (!_ring[i].empty && !_ring[i].seen) {
+                if (!_ring.is_empty(i) && !_ring.is_seen(i)) {
                     _counters.lost_pkts += 1, _current_ts_counters.lost_pkts += 1;
                 }
 
-                _ring[i].seen = false, _ring[i].empty = true;
-
-                if (_ring[i].rtp_ts == _ring[idx].rtp_ts) {
-                    evict_frame.pkts[evict_frame.pkts_seen++] = _ring[i];
-                    evict_frame.total_pl_len += _ring[i].pl_len;
-
-                    evict_frame.ts_min = _ring[i].ts < evict_frame.ts_min ?
-                            _ring[i].ts : evict_frame.ts_min;
+                _ring.set_flags(i, true, false);
 
-                    evict_frame.ts_max = _ring[i].ts > evict_frame.ts_max ?
-                                         _ring[i].ts : evict_frame.ts_max;
+                if (_ring.rtp_ts[i] == _ring.rtp_ts[idx]) {
+                    evict_frame._add(i);
                 }
             }
 
@@ -329,11 +681,49 @@ private:
 
         assert(idx >= 0 && idx < Len);
 
-        _ring[idx] = { .empty = false, .seen = seen, .rtp_seq = rtp_seq, .rtp_ts = rtp_ts, .ts = ts,
-                       .pl_len = pl_len, .meta = meta };
+        _ring.set(idx, rtp_seq, rtp_ts, ts, pl_len, seen, meta);
+    }
+
+    //! adds the stats of the second ts_s to the rollups, reports rollups whose interval ended
+    void _roll_up(unsigned ts_s, const struct stats& c) {
+
+        for (unsigned i = 0; i < ROLLUP_RESOLUTIONS.size(); i++) {
+
+            auto& r = _rollups[i];
+            auto start_ts = ts_s - ts_s % ROLLUP_RESOLUTIONS[i];
+
+            if (r.active && r.start_ts != start_ts) {
+
+                _sink.rollup(*this, ROLLUP_RESOLUTIONS[i], r.report_count, r.start_ts,
+                             r.counters);
+
+                r.report_count++;
+                r.counters = {};
+
+                if (_quantiles)
+                    _quantiles->rollups[i].clear();
+            }
+
+            r.active = true;
+            r.start_ts = start_ts;
+            r.counters += c;
+
+            if (_quantiles)
+                _quantiles->rollups[i].merge(_quantiles->second);
+        }
+    }
+
+    //! moves the sketches of the reported second to the stream, after _roll_up()
+    void _end_second_sketches() {
+
+        if (_quantiles) {
+            _quantiles->stream.merge(_quantiles->second);
+            _quantiles->second.clear();
+        }
     }
 
     void _evict_frame(frame& f) {
+        f._finish();
         f.fps = _fps_calc.add_frame(f.ts_max);
         f.jitter = _jitter_calc.add_frame(f.ts_max, f.rtp_ts);
         _counters.total_frames += 1, _current_ts_counters.total_frames += 1;
@@ -341,21 +731,95 @@ private:
         _current_ts_counters.frame_size_sum += f.total_pl_len;
         _current_ts_counters.jitter_sum += f.jitter;
 
-        _frame_handler(*this, f);
+        if (_quantiles) {
+
+            auto& q = *_quantiles;
+            auto ts_us = (std::int64_t) f.ts_max.tv_sec * 1000000 + f.ts_max.tv_usec;
+
+            q.second.jitter_ms.add(f.jitter);
+            q.second.frame_size.add(f.total_pl_len);
+            q.second.fps.add(f.fps);
+
+            // frames are evicted by sequence number, a reordered frame has a gap of 0
+            if (q.last_frame_us != _quantile_state::NO_FRAME) {
+                auto gap_us = std::max<std::int64_t>(ts_us - q.last_frame_us, 0);
+                q.second.frame_gap_ms.add((double) gap_us / 1000);
+            }
+
+            q.last_frame_us = std::max(ts_us, q.last_frame_us);
+        }
+
+        _sink.frame(*this, f);
     }
 
     unsigned _head             = 0;
     struct stats _counters  = {};
-    std::array<pkt, Len> _ring = {};
-    FrameHandlerFx _frame_handler;
-    StatsHandlerFx _stats_handler;
+    _packed_ring _ring;
+    sink_type _sink;
     StreamMeta _meta;
     fps_calculator _fps_calc;
-    jitter_calculator _jitter_calc;
+    Jitter _jitter_calc;
     unsigned _current_ts_s = 0;
     unsigned _stats_report_count = 0;
     struct stats _current_ts_counters = {};
     struct timestamps _timestamps;
+
+    struct rollup {
+        bool active           = false;
+        unsigned start_ts     = 0;
+        unsigned report_count = 0;
+        struct stats counters = {};
+    };
+
+    std::array<rollup, ROLLUP_RESOLUTIONS.size()> _rollups = {};
+
+    struct _quantile_state {
+        static constexpr std::int64_t NO_FRAME = std::numeric_limits<std::int64_t>::min();
+
+        explicit _quantile_state(double rel_accuracy = 0.01)
+            : stream(rel_accuracy), second(rel_accuracy),
+              rollups{frame_sketches(rel_accuracy), frame_sketches(rel_accuracy),
+                      frame_sketches(rel_accuracy)} { }
+
+        frame_sketches stream, second; // the stream up to and the current second
+        std::array<frame_sketches, ROLLUP_RESOLUTIONS.size()> rollups;
+        std::int64_t last_frame_us = NO_FRAME;
+
+        void save(checkpoint::writer& w) const {
+            stream.save(w), second.save(w);
+
+            for (const auto& r: rollups)
+                r.save(w);
+
+            w.write(last_frame_us);
+        }
+
+        void restore(checkpoint::reader& r) {
+            stream.restore(r), second.restore(r);
+
+            for (auto& rollup: rollups)
+                rollup.restore(r);
+
+            r.read(last_frame_us);
+        }
+    };
+
+    //! the quantile state is copied along with the analyzer, null unless enabled
+    struct _quantile_ptr : std::unique_ptr<_quantile_state> {
+        _quantile_ptr() = default;
+        _quantile_ptr(_quantile_ptr&&) noexcept = default;
+        _quantile_ptr& operator=(_quantile_ptr&&) noexcept = default;
+
+        _quantile_ptr(const _quantile_ptr& p)
+            : std::unique_ptr<_quantile_state>(p ? new _quantile_state(*p) : nullptr) { }
+
+        _quantile_ptr& operator=(const _quantile_ptr& p) {
+            reset(p ? new _quantile_state(*p) : nullptr);
+            return *this;
+        }
+    };
+
+    _quantile_ptr _quantiles;
 };
 
 #endif
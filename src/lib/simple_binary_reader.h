@@ -44,6 +44,21 @@ public:
         return true;
     }
 
+    //! skips the first n entries of an unbuffered reader, e.g., when resuming from a checkpoint
+    void skip(unsigned long n) {
+
+        if (_use_buffer)
+            throw std::logic_error("simple_binary_reader: skip() requires an unbuffered reader");
+
+        _stream.seekg((std::streamoff) (n * sizeof(T)), std::ios::beg);
+        _skipped = n;
+    }
+
+    //! returns the number of entries skipped by skip()
+    [[nodiscard]] unsigned long skipped() const {
+        return _skipped;
+    }
+
     [[nodiscard]] unsigned long size() const {
         return (unsigned long)
             std::filesystem::file_size(std::filesystem::path(_file_name)) / sizeof(T);
@@ -96,7 +111,7 @@ private:
     bool _use_buffer;
     std::vector<T> _data;
     typename std::vector<T>::const_iterator _iter;
-    unsigned long _count = 0;
+    unsigned long _count = 0, _skipped = 0;
     std::chrono::high_resolution_clock::time_point _start, _end;
 };
 
@@ -1,6 +1,8 @@
 #ifndef ZOOM_ANALYSIS_SIMPLE_BINARY_WRITER_H
 #define ZOOM_ANALYSIS_SIMPLE_BINARY_WRITER_H
 
+#include <cstdint>
+
 #include "file_stream.h"
 
 template <typename T>
@@ -9,11 +11,12 @@ public:
 
     simple_binary_writer() = default;
 
-    explicit simple_binary_writer(const std::string& file_name)
-        : file_stream(file_name, std::ios::binary | std::ios::out) { }
+    explicit simple_binary_writer(const std::string& file_name, bool append = false)
+        : file_stream(file_name, _open_mode(append)) { }
 
-    void open(const std::string& file_name) {
-        file_stream::open(file_name, std::ios::binary | std::ios::out);
+    //! opens the file, appends to an existing file if append is set
+    void open(const std::string& file_name, bool append = false) {
+        file_stream::open(file_name, _open_mode(append));
     }
 
     //! writes t to the file
@@ -27,7 +30,18 @@ public:
         return _count;
     }
 
+    //! flushes buffered entries and returns the size of the file
+    std::int64_t flush() {
+        _stream.flush();
+        return (std::int64_t) _stream.tellp();
+    }
+
 private:
+
+    static std::ios::openmode _open_mode(bool append) {
+        return std::ios::binary | std::ios::out | (append ? std::ios::app : std::ios::trunc);
+    }
+
     unsigned long _count = 0;
 };
 
@@ -0,0 +1,241 @@
+
+#ifndef ZOOM_ANALYSIS_SKETCHES_H
+#define ZOOM_ANALYSIS_SKETCHES_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace sketch {
+
+    //! finalizes a (possibly weak) std::hash value into a well-mixed 64 bit value (splitmix64)
+    inline std::uint64_t mix(std::uint64_t h) {
+        h += 0x9e3779b97f4a7c15ull;
+        h = (h ^ (h >> 30u)) * 0xbf58476d1ce4e5b9ull;
+        h = (h ^ (h >> 27u)) * 0x94d049bb133111ebull;
+        return h ^ (h >> 31u);
+    }
+
+    inline bool is_power_of_two(std::size_t x) {
+        return (x != 0) && ((x & (x - 1)) == 0);
+    }
+
+    //! returns the largest power of two less than or equal to x (at least 1)
+    inline std::size_t floor_power_of_two(std::size_t x) {
+        std::size_t p = 1;
+        while (p <= x / 2) p <<= 1u;
+        return p;
+    }
+}
+
+/*!
+ * Bloom filter storing a last-seen timestamp per cell
+ *
+ * - mirrors the P2P peer registers in p4/src/zoom_capture.p4: a key is present if all of its
+ *   cells are set and none of them is older than the expiration
+ * - fixed memory: cells * sizeof(std::uint32_t) Bytes
+ */
+template <typename Key, typename Hash = std::hash<Key>>
+class aging_bloom_filter {
+public:
+
+    explicit aging_bloom_filter(std::size_t cells = 1 << 16, unsigned hashes = 3)
+        : _cells(cells, 0), _hashes(hashes) {
+
+        if (!sketch::is_power_of_two(cells))
+            throw std::invalid_argument("aging_bloom_filter: cells must be power of two");
+
+        if (hashes == 0)
+            throw std::invalid_argument("aging_bloom_filter: at least one hash function required");
+    }
+
+    aging_bloom_filter(const aging_bloom_filter&) = default;
+    aging_bloom_filter& operator=(const aging_bloom_filter&) = default;
+
+    //! sets all cells of key to ts (ts == 0 is stored as 1)
+    void insert(const Key& key, std::uint32_t ts) {
+
+        auto [h1, h2] = _hash(key);
+
+        for (unsigned i = 0; i < _hashes; i++) {
+            auto& cell = _cells[_idx(h1, h2, i)];
+            _set_count += (cell == 0);
+            cell = ts > 0 ? ts : 1;
+        }
+    }
+
+    //! returns true if all cells of key are set and were updated within expiration of ts
+    //! - refreshes the cells of a present key to ts
+    bool contains_and_refresh(const Key& key, std::uint32_t ts, std::uint32_t expiration) {
+
+        auto [h1, h2] = _hash(key);
+        bool present = true;
+
+        for (unsigned i = 0; i < _hashes; i++) {
+            const auto cell = _cells[_idx(h1, h2, i)];
+            present = present && cell != 0 && !_expired(cell, ts, expiration);
+        }
+
+        if (present) {
+            for (unsigned i = 0; i < _hashes; i++) {
+                _cells[_idx(h1, h2, i)] = ts > 0 ? ts : 1;
+            }
+        }
+
+        return present;
+    }
+
+    //! resets all cells that were not updated within expiration of ts
+    void expire(std::uint32_t ts, std::uint32_t expiration) {
+
+        for (auto& cell : _cells) {
+            if (cell != 0 && _expired(cell, ts, expiration)) {
+                cell = 0, _set_count--;
+            }
+        }
+    }
+
+    //! returns the fraction of non-zero cells
+    [[nodiscard]] double fill_ratio() const {
+        return (double) _set_count / (double) _cells.size();
+    }
+
+    //! returns the expected false positive rate given the current fill ratio
+    [[nodiscard]] double false_positive_rate() const {
+        return std::pow(fill_ratio(), _hashes);
+    }
+
+    [[nodiscard]] std::size_t cells() const {
+        return _cells.size();
+    }
+
+    [[nodiscard]] unsigned hashes() const {
+        return _hashes;
+    }
+
+    [[nodiscard]] std::size_t memory_bytes() const {
+        return _cells.size() * sizeof(std::uint32_t);
+    }
+
+private:
+
+    [[nodiscard]] inline static bool _expired(std::uint32_t cell, std::uint32_t ts,
+                                              std::uint32_t expiration) {
+        return ts > cell && ts - cell > expiration;
+    }
+
+    [[nodiscard]] inline std::pair<std::uint64_t, std::uint64_t> _hash(const Key& key) const {
+        auto h = sketch::mix(Hash{}(key));
+        return {h, sketch::mix(h) | 1u};
+    }
+
+    [[nodiscard]] inline std::size_t _idx(std::uint64_t h1, std::uint64_t h2, unsigned i) const {
+        return (h1 + i * h2) & (_cells.size() - 1);
+    }
+
+    std::vector<std::uint32_t> _cells;
+    unsigned _hashes = 3;
+    std::size_t _set_count = 0;
+};
+
+/*!
+ * Count-min sketch
+ *
+ * - estimates never under-count; with probability confidence() the over-count of an estimate is
+ *   at most error_bound()
+ * - fixed memory: width * depth * sizeof(Counter) Bytes
+ */
+template <typename Key, typename Hash = std::hash<Key>, typename Counter = std::uint64_t>
+class count_min_sketch {
+public:
+
+    explicit count_min_sketch(std::size_t width = 1 << 14, unsigned depth = 4)
+        : _counters(width * depth, 0), _width(width), _depth(depth) {
+
+        if (!sketch::is_power_of_two(width))
+            throw std::invalid_argument("count_min_sketch: width must be power of two");
+
+        if (depth == 0)
+            throw std::invalid_argument("count_min_sketch: depth must be larger than 0");
+    }
+
+    count_min_sketch(const count_min_sketch&) = default;
+    count_min_sketch& operator=(const count_min_sketch&) = default;
+
+    //! adds inc to the counters of key and returns the updated estimate
+    Counter add(const Key& key, Counter inc = 1) {
+
+        auto h = sketch::mix(Hash{}(key));
+        auto estimate = std::numeric_limits<Counter>::max();
+
+        for (unsigned row = 0; row < _depth; row++) {
+            auto& counter = _counters[_idx(h, row)];
+            counter += inc;
+            estimate = counter < estimate ? counter : estimate;
+        }
+
+        _total += inc;
+        return estimate;
+    }
+
+    //! returns the estimated count of key
+    [[nodiscard]] Counter estimate(const Key& key) const {
+
+        auto h = sketch::mix(Hash{}(key));
+        auto estimate = std::numeric_limits<Counter>::max();
+
+        for (unsigned row = 0; row < _depth; row++) {
+            auto counter = _counters[_idx(h, row)];
+            estimate = counter < estimate ? counter : estimate;
+        }
+
+        return estimate;
+    }
+
+    //! returns the sum over all added increments
+    [[nodiscard]] std::uint64_t total() const {
+        return _total;
+    }
+
+    //! returns the additive error bound (e / width * total) of estimates
+    [[nodiscard]] double error_bound() const {
+        return M_E / (double) _width * (double) _total;
+    }
+
+    //! returns the probability with which an estimate stays within error_bound()
+    [[nodiscard]] double confidence() const {
+        return 1.0 - std::exp(-(double) _depth);
+    }
+
+    [[nodiscard]] std::size_t width() const {
+        return _width;
+    }
+
+    [[nodiscard]] unsigned depth() const {
+        return _depth;
+    }
+
+    [[nodiscard]] std::size_t memory_bytes() const {
+        return _counters.size() * sizeof(Counter);
+    }
+
+private:
+
+    [[nodiscard]] inline std::size_t _idx(std::uint64_t h, unsigned row) const {
+        // derive an independent index per row by re-mixing with the row number
+        auto rh = sketch::mix(h + row);
+        return row * _width + (rh & (_width - 1));
+    }
+
+    std::vector<Counter> _counters;
+    std::size_t _width = 0;
+    unsigned _depth = 0;
+    std::uint64_t _total = 0;
+};
+
+#endif
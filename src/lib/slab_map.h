@@ -0,0 +1,219 @@
+
+#ifndef ZOOM_ANALYSIS_SLAB_MAP_H
+#define ZOOM_ANALYSIS_SLAB_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+/*!
+ * Hash map of large values that are addressed by stable handles
+ *
+ * - values are allocated in chunks of ChunkLen entries and never move, a handle is the index of
+ *   an entry in the chunks and stays valid until the entry is erased
+ * - erased entries are destroyed and their slots reused by later insertions, such that memory is
+ *   bounded by the maximum number of entries present at the same time
+ * - the index is a flat, linearly probed table of handles and hash tags (power of two, at most
+ *   half full), such that a lookup touches a single entry in the common case
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>, std::size_t ChunkLen = 64>
+class slab_map {
+public:
+
+    using handle = std::uint32_t;
+
+    static constexpr handle NONE = ~(handle) 0;
+    static constexpr std::size_t MIN_INDEX_LEN = 16;
+
+    slab_map() : _index(MIN_INDEX_LEN) { }
+
+    //! returns the handle of key or NONE
+    [[nodiscard]] handle find(const Key& key) const {
+
+        auto hash = _hash(key);
+        auto tag = (std::uint32_t) hash;
+
+        for (auto i = hash & (_index.size() - 1);; i = (i + 1) & (_index.size() - 1)) {
+
+            const auto& slot = _index[i];
+
+            if (slot.h == NONE)
+                return NONE;
+
+            if (slot.tag == tag && _key(slot.h) == key)
+                return slot.h;
+        }
+    }
+
+    //! constructs the value of key from args unless key is present
+    //! - returns the handle of key and whether it was inserted
+    template <typename... Args>
+    std::pair<handle, bool> emplace(const Key& key, Args&&... args) {
+
+        if (auto h = find(key); h != NONE)
+            return {h, false};
+
+        if ((_size + 1) * 2 > _index.size())
+            _rehash(_index.size() * 2);
+
+        handle h;
+
+        if (!_free.empty()) {
+            h = _free.back();
+            _free.pop_back();
+            _entry(h).emplace(std::piecewise_construct, std::forward_as_tuple(key),
+                              std::forward_as_tuple(std::forward<Args>(args)...));
+        } else {
+
+            if (_slots == NONE)
+                throw std::length_error("slab_map: too many entries");
+
+            if (_slots % ChunkLen == 0) {
+                _chunks.emplace_back();
+                _chunks.back().reserve(ChunkLen);
+            }
+
+            // the chunk does not reallocate within its capacity, entries stay in place
+            _chunks.back().emplace_back(std::in_place, std::piecewise_construct,
+                                        std::forward_as_tuple(key),
+                                        std::forward_as_tuple(std::forward<Args>(args)...));
+            h = (handle) _slots++;
+        }
+
+        _size++;
+        _insert(h, _hash(key));
+        return {h, true};
+    }
+
+    //! destroys the entry of a valid handle, its slot is reused by a later emplace()
+    void erase(handle h) {
+
+        auto mask = _index.size() - 1;
+        auto i = _hash(_key(h)) & mask;
+
+        while (_index[i].h != h)
+            i = (i + 1) & mask;
+
+        // shifts back later entries of the probe sequence instead of leaving a tombstone
+        for (auto j = (i + 1) & mask; _index[j].h != NONE; j = (j + 1) & mask) {
+
+            auto home = _hash(_key(_index[j].h)) & mask;
+
+            // move j into the hole at i unless its home slot lies cyclically in (i, j]
+            if (((j - home) & mask) >= ((j - i) & mask)) {
+                _index[i] = _index[j];
+                i = j;
+            }
+        }
+
+        _index[i] = {};
+        _entry(h).reset();
+        _free.push_back(h);
+        _size--;
+    }
+
+    //! handles of all entries in ascending order
+    [[nodiscard]] std::vector<handle> handles() const {
+
+        std::vector<handle> handles;
+        handles.reserve(_size);
+
+        for (handle h = 0; h < _slots; h++) {
+            if (_entry(h))
+                handles.push_back(h);
+        }
+
+        return handles;
+    }
+
+    [[nodiscard]] const Key& key(handle h) const {
+        return _key(h);
+    }
+
+    [[nodiscard]] Value& operator[](handle h) {
+        return _entry(h)->second;
+    }
+
+    [[nodiscard]] const Value& operator[](handle h) const {
+        return _entry(h)->second;
+    }
+
+    [[nodiscard]] std::size_t size() const {
+        return _size;
+    }
+
+    [[nodiscard]] bool empty() const {
+        return _size == 0;
+    }
+
+    //! memory allocated for entries, the index and free handles in Bytes, excluding heap memory
+    //! owned by keys and values
+    //! - entries are allocated by chunk and kept after erase(), until clear()
+    [[nodiscard]] std::size_t bytes() const {
+        return _chunks.size() * ChunkLen * sizeof(_entry_type)
+            + _chunks.capacity() * sizeof(std::vector<_entry_type>)
+            + _index.capacity() * sizeof(_slot) + _free.capacity() * sizeof(handle);
+    }
+
+    void clear() {
+        _chunks.clear();
+        _free.clear();
+        _index.assign(MIN_INDEX_LEN, {});
+        _size = 0, _slots = 0;
+    }
+
+private:
+
+    struct _slot {
+        handle h = NONE;
+        std::uint32_t tag = 0; // lower bits of the hash, compared before the key
+    };
+
+    using _entry_type = std::optional<std::pair<Key, Value>>;
+
+    [[nodiscard]] _entry_type& _entry(handle h) {
+        return _chunks[h / ChunkLen][h % ChunkLen];
+    }
+
+    [[nodiscard]] const _entry_type& _entry(handle h) const {
+        return _chunks[h / ChunkLen][h % ChunkLen];
+    }
+
+    [[nodiscard]] const Key& _key(handle h) const {
+        return _entry(h)->first;
+    }
+
+    void _insert(handle h, std::size_t hash) {
+
+        auto i = hash & (_index.size() - 1);
+
+        while (_index[i].h != NONE)
+            i = (i + 1) & (_index.size() - 1);
+
+        _index[i] = {h, (std::uint32_t) hash};
+    }
+
+    void _rehash(std::size_t len) {
+
+        _index.assign(len, {});
+
+        for (handle h = 0; h < _slots; h++) {
+            if (_entry(h))
+                _insert(h, _hash(_key(h)));
+        }
+    }
+
+    std::vector<std::vector<_entry_type>> _chunks;
+    std::vector<handle> _free;
+    std::vector<_slot> _index;
+    std::size_t _size = 0;  // entries
+    std::size_t _slots = 0; // allocated entries, including erased ones
+    Hash _hash;
+};
+
+#endif
@@ -0,0 +1,90 @@
+
+#ifndef ZOOM_ANALYSIS_SPSC_QUEUE_H
+#define ZOOM_ANALYSIS_SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+/*!
+ * Bounded lock-free queue for exactly one producer and one consumer thread
+ *
+ * - items are copied into a ring of fixed size (power of two) and popped in FIFO order
+ * - head and tail live on separate cache lines; each side keeps a cached copy of the other
+ *   side's index and only reloads it when the ring looks full (producer) or empty (consumer)
+ */
+template <typename Type>
+class spsc_queue {
+public:
+
+    explicit spsc_queue(std::size_t size)
+        : _ring(size), _mask(size - 1) {
+
+        if (size == 0 || (size & (size - 1)) != 0)
+            throw std::invalid_argument("spsc_queue: size must be power of two");
+    }
+
+    spsc_queue(const spsc_queue&) = delete;
+    spsc_queue& operator=(const spsc_queue&) = delete;
+
+    //! producer: appends item, returns false if the queue is full
+    bool try_push(const Type& item) {
+
+        auto tail = _tail.load(std::memory_order_relaxed);
+
+        if (tail - _head_cache == _ring.size()) {
+            _head_cache = _head.load(std::memory_order_acquire);
+
+            if (tail - _head_cache == _ring.size())
+                return false;
+        }
+
+        _ring[tail & _mask] = item;
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! consumer: removes the oldest item, returns false if the queue is empty
+    bool try_pop(Type& item) {
+
+        auto head = _head.load(std::memory_order_relaxed);
+
+        if (head == _tail_cache) {
+            _tail_cache = _tail.load(std::memory_order_acquire);
+
+            if (head == _tail_cache)
+                return false;
+        }
+
+        item = _ring[head & _mask];
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! number of queued items (a snapshot if called while the other side is active)
+    [[nodiscard]] std::size_t size() const {
+        return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire);
+    }
+
+    [[nodiscard]] bool empty() const {
+        return size() == 0;
+    }
+
+    [[nodiscard]] std::size_t capacity() const {
+        return _ring.size();
+    }
+
+private:
+
+    std::vector<Type> _ring;
+    std::size_t _mask;
+
+    alignas(64) std::atomic<std::size_t> _tail{0};
+    std::size_t _head_cache = 0;
+
+    alignas(64) std::atomic<std::size_t> _head{0};
+    std::size_t _tail_cache = 0;
+};
+
+#endif
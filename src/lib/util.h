@@ -90,10 +90,11 @@ namespace util {
      * returns list of non-hidden file paths inside a directory
      *
      * - returns list with single path entry if file name provided
-     * - optionally filters by beginning of extension string (e.g., "pcap" matches "pcapX")
+     * - optionally filters by extensions, each of which may be followed by a sequence number
+     *   (e.g., {"pcap", "pcapng"} matches ".pcap", ".pcap12" and ".pcapng", but not ".csv")
      */
     static std::vector<std::string> files_in_directory(const std::string& file_or_directory,
-                                                const std::string& limit_ext_start = "") {
+                                                const std::vector<std::string>& limit_exts = {}) {
 
         const std::filesystem::path in_path{file_or_directory};
 
@@ -111,8 +112,16 @@ namespace util {
 
                 // checks if path is regular file (no dir, links, ., .., etc.) and non-hidden
                 if (dir_entry.is_regular_file() && name_str[0] != '.') {
-                    if (!limit_ext_start.empty()) {
-                        if (extension_str.find_first_of(limit_ext_start) != std::string::npos) {
+                    if (!limit_exts.empty()) {
+
+                        auto matches = [&](const std::string& ext) {
+                            const auto seq_pos = ext.size() + 1;
+                            return extension_str.compare(0, seq_pos, "." + ext) == 0
+                                   && extension_str.find_first_not_of("0123456789", seq_pos)
+                                      == std::string::npos;
+                        };
+
+                        if (std::any_of(limit_exts.begin(), limit_exts.end(), matches)) {
                             files.push_back(path_str);
                         }
                     } else {
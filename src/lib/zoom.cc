@@ -1,3 +1,5 @@
+#include <array>
+
 #include "zoom.h"
 
 char zoom::media_type_to_char(zoom::media_type t) {
@@ -39,20 +41,21 @@ zoom::media_stream_key zoom::media_stream_key::from_pkt(const pkt& pkt) {
         .ip_5t       = pkt.ip_5t,
         .rtp_ssrc    = pkt.proto.rtp.ssrc,
         .media_type  = media_type,
-        .stream_type = pkt.proto.rtp.pt == 110 ? stream_type::fec : stream_type::media
+        .stream_type = pkt.proto.rtp.pt == 110 ? stream_type::fec : stream_type::media,
+        .ipv6        = pkt.flags.ipv6 == 1
     };
 }
 
 bool zoom::media_stream_key::operator<(const struct media_stream_key& a) const {
 
-    return std::tie(ip_5t, rtp_ssrc, media_type, stream_type)
-        < std::tie(a.ip_5t, a.rtp_ssrc, a.media_type, a.stream_type);
+    return std::tie(ipv6, ip_5t, rtp_ssrc, media_type, stream_type)
+        < std::tie(a.ipv6, a.ip_5t, a.rtp_ssrc, a.media_type, a.stream_type);
 }
 
 bool zoom::media_stream_key::operator==(const struct media_stream_key& a) const {
 
-    return std::tie(ip_5t, rtp_ssrc, media_type, stream_type)
-        == std::tie(a.ip_5t, a.rtp_ssrc, a.media_type, a.stream_type);
+    return std::tie(ipv6, ip_5t, rtp_ssrc, media_type, stream_type)
+        == std::tie(a.ipv6, a.ip_5t, a.rtp_ssrc, a.media_type, a.stream_type);
 }
 
 /*
@@ -93,7 +96,15 @@ zoom::pkt::pkt()
     flags.from_srv = 0;
 }
 
-zoom::pkt::pkt(const struct zoom::headers& hdr, timeval tv, std::size_t pcap_frame_len, bool is_p2p) {
+zoom::pkt::pkt(const struct zoom::headers& hdr, timeval tv, std::size_t pcap_frame_len, bool is_p2p)
+    : pkt(net_headers{
+              net::ipv4_5tuple::from_ipv4_pkt_data((const unsigned char*) hdr.ip),
+              hdr.ip, hdr.udp, hdr.udp_pl_offset,
+              (std::uint16_t) (hdr.udp ? ntohs(hdr.udp->dgram_len) : 0)
+          }, hdr, tv, pcap_frame_len, is_p2p) { }
+
+zoom::pkt::pkt(const net_headers& net_hdr, const struct zoom::headers& hdr, timeval tv,
+               std::size_t pcap_frame_len, bool is_p2p) {
 
     ts.s = tv.tv_sec;
     ts.us = tv.tv_usec;
@@ -101,16 +112,16 @@ zoom::pkt::pkt(const struct zoom::headers& hdr, timeval tv, std::size_t pcap_fra
     flags.p2p = is_p2p ? 1 : 0;
     flags.srv = is_p2p ? 0 : 1;
 
-    ip_5t.ip_src = ntohl(hdr.ip->src_addr);
-    ip_5t.ip_dst = ntohl(hdr.ip->dst_addr);
-    ip_5t.ip_proto = hdr.ip->next_proto_id;
+    ip_5t.ip_src = net_hdr.ip_5t.ip_src;
+    ip_5t.ip_dst = net_hdr.ip_5t.ip_dst;
+    ip_5t.ip_proto = net_hdr.ip_5t.ip_proto;
 
     this->pcap_frame_len = pcap_frame_len;
 
     if (ip_5t.ip_proto == 17) {
-        ip_5t.tp_src = ntohs(hdr.udp->src_port);
-        ip_5t.tp_dst = ntohs(hdr.udp->dst_port);
-        udp_pl_len = ntohs(hdr.udp->dgram_len);
+        ip_5t.tp_src = net_hdr.ip_5t.tp_src;
+        ip_5t.tp_dst = net_hdr.ip_5t.tp_dst;
+        udp_pl_len = net_hdr.udp_dgram_len;
     }
 
     if (!is_p2p) {
@@ -149,6 +160,19 @@ zoom::pkt::pkt(const struct zoom::headers& hdr, timeval tv, std::size_t pcap_fra
 
     std::memcpy(rtp_ext1, hdr.rtp_ext1, 3);
 }
+
+zoom::pkt::pkt(const net6_headers& net_hdr, const struct zoom::headers& hdr, timeval tv,
+               std::size_t pcap_frame_len, bool is_p2p)
+    : pkt(net_headers{
+              {
+                  net_hdr.ip_5t.ip_src.fold32(), net_hdr.ip_5t.ip_dst.fold32(),
+                  net_hdr.ip_5t.tp_src, net_hdr.ip_5t.tp_dst, net_hdr.ip_5t.ip_proto
+              },
+              nullptr, net_hdr.udp, net_hdr.udp_pl_offset, net_hdr.udp_dgram_len
+          }, hdr, tv, pcap_frame_len, is_p2p) {
+
+    flags.ipv6 = 1;
+}
 /*
 zoom::media_stream_meta zoom::media_stream_meta::from_pkt(const zoom::pkt& pkt) {
 
@@ -172,93 +196,282 @@ zoom::media_stream_meta zoom::media_stream_meta::from_pkt(const zoom::pkt& pkt)
     };
 }
 */
-struct zoom::headers zoom::parse_zoom_pkt_buf(const unsigned char* buf, bool includes_eth, bool is_p2p) {
+namespace {
 
-    struct headers hdr;
-    unsigned eth_offset = includes_eth ? net::eth::HDR_LEN : 0;
+    //! copies the payload of the RTP extension header with type == 1 to hdr.rtp_ext1
+    void parse_rtp_ext1(const unsigned char* buf, struct zoom::headers& hdr) {
 
-    hdr.ip = (net::ipv4::hdr*) (buf + eth_offset);
+        auto* rtp_ext_ptr = buf + hdr.rtp_rtcp_offset + rtp::HDR_LEN;
+        auto ext_bytes =  (rtp_ext_ptr[2] << 8) + (rtp_ext_ptr[3]) * 4;
 
-    if (hdr.ip->next_proto_id == 17) {
+        for (auto ext_byte_i = 4; ext_byte_i < 4 + ext_bytes;) {
+            if (rtp_ext_ptr[ext_byte_i] != 0) { // 0 -> padding byte
 
-        hdr.udp = (net::udp::hdr*) (buf + eth_offset + hdr.ip->ihl_bytes());
-        hdr.udp_pl_offset = eth_offset + hdr.ip->ihl_bytes() + net::udp::HDR_LEN;
-        auto* udp_pl = buf + hdr.udp_pl_offset;
+                auto type = (rtp_ext_ptr[ext_byte_i] >> 4) & 0x0f;
+                auto len = (rtp_ext_ptr[ext_byte_i] & 0x0f) + 1;
+
+                if (type == 1 && len == 3) {
+                    std::memcpy(hdr.rtp_ext1, rtp_ext_ptr + ext_byte_i + 1, 3);
+                    break;
+                }
+
+                ext_byte_i += (len + 1);
+            } else {
+                ext_byte_i++;
+            }
+        }
+    }
+
+    //! how to find the RTP/RTCP header of a packet given the type of its Zoom media header
+    struct media_class {
+        std::uint8_t rtp         = 0; // RTP header follows
+        std::uint8_t rtcp        = 0; // RTCP header follows
+        std::uint8_t offset      = 0; // offset of the header from the UDP payload
+        std::uint8_t video       = 0; // header is 4 bytes further back if zoom_inner[20] == 0x02
+        std::uint8_t srv_screen  = 0; // only valid if zoom_inner[7] == P2P_SCREEN_SHARE_TYPE
+    };
+
+    //! lookup table from zoom_inner[0] to media_class, mirrors the branches in parse_zoom_hdrs()
+    constexpr std::array<media_class, 256> media_class_table(bool is_p2p) {
+
+        std::array<media_class, 256> t{};
+        std::uint8_t inner_offset = is_p2p ? 0 : 8;
+
+        t[zoom::AUDIO_TYPE] = {1, 0, (std::uint8_t) (inner_offset + 19), 0, 0};
+        t[zoom::VIDEO_TYPE] = {1, 0, (std::uint8_t) (inner_offset + 20), 1, 0};
+        t[zoom::RTCP_SR_TYPE] = {0, 1, (std::uint8_t) (inner_offset + 16), 0, 0};
+        t[zoom::RTCP_SR_SD_TYPE] = {0, 1, (std::uint8_t) (inner_offset + 16), 0, 0};
 
         if (is_p2p) {
+            t[zoom::P2P_SCREEN_SHARE_TYPE] = {1, 0, 20, 0, 0};
+        } else {
+            t[zoom::SRV_SCREEN_SHARE_TYPE] = {1, 0, 35, 0, 1};
+        }
+
+        return t;
+    }
+
+    constexpr auto SRV_MEDIA_CLASSES = media_class_table(false);
+    constexpr auto P2P_MEDIA_CLASSES = media_class_table(true);
+
+    //! classifies the Zoom headers in the UDP payload at hdr.udp_pl_offset
+    //! - shared by the IPv4 and IPv6 variants of parse_zoom_hdrs()
+    template <bool IsP2P>
+    inline void parse_udp_pl(const unsigned char* buf, zoom::headers& hdr) {
+
+        auto* udp_pl = buf + hdr.udp_pl_offset;
+
+        if constexpr (IsP2P) {
             hdr.zoom_inner = udp_pl;
         } else {
             hdr.zoom_outer = udp_pl;
+            hdr.zoom_inner = udp_pl[0] == zoom::SRV_MEDIA_TYPE ? udp_pl + 8 : udp_pl;
+        }
 
-            if (hdr.zoom_outer[0] == SRV_MEDIA_TYPE) {
-                hdr.zoom_inner = udp_pl + 8;
-            }
+        // offset of the Zoom media header in buf
+        unsigned inner_offset = hdr.udp_pl_offset + (IsP2P ? 0 : 8);
+
+        if (hdr.zoom_inner[0] == zoom::AUDIO_TYPE) {
+            hdr.rtp_rtcp_offset = inner_offset + 19;
+            hdr.rtp = (rtp::hdr*) (buf + hdr.rtp_rtcp_offset);
+        } else if (hdr.zoom_inner[0] == zoom::VIDEO_TYPE) {
+            hdr.rtp_rtcp_offset = inner_offset + (hdr.zoom_inner[20] == 0x02 ? 24 : 20);
+            hdr.rtp = (rtp::hdr*) (buf + hdr.rtp_rtcp_offset);
+        } else if (IsP2P && hdr.zoom_inner[0] == zoom::P2P_SCREEN_SHARE_TYPE) {
+            hdr.rtp_rtcp_offset = hdr.udp_pl_offset + 20;
+            hdr.rtp = (rtp::hdr*) (buf + hdr.rtp_rtcp_offset);
+        } else if (!IsP2P && hdr.zoom_inner[0] == zoom::SRV_SCREEN_SHARE_TYPE
+            && hdr.zoom_inner[7] == zoom::P2P_SCREEN_SHARE_TYPE) {
+            hdr.rtp_rtcp_offset = hdr.udp_pl_offset + 35;
+            hdr.rtp = (rtp::hdr*) (buf + hdr.rtp_rtcp_offset);
+        } else if (hdr.zoom_inner[0] == zoom::RTCP_SR_TYPE || hdr.zoom_inner[0] == zoom::RTCP_SR_SD_TYPE) {
+            hdr.rtp_rtcp_offset = inner_offset + 16;
+            hdr.rtcp = (rtcp::hdr*) (buf + hdr.rtp_rtcp_offset);
         }
 
-        if (!is_p2p && udp_pl[0] == SRV_MEDIA_TYPE) {
-            hdr.zoom_outer = udp_pl;
-            hdr.zoom_inner = udp_pl + 8;
-        } else {
-            hdr.zoom_inner = udp_pl;
+        if (hdr.rtp && hdr.rtp->extension()) {
+            parse_rtp_ext1(buf, hdr);
         }
+    }
+}
 
-        if (hdr.zoom_inner && (hdr.zoom_inner[0] == AUDIO_TYPE
-            || hdr.zoom_inner[0] == VIDEO_TYPE
-            || (is_p2p && hdr.zoom_inner[0] == P2P_SCREEN_SHARE_TYPE))
-            || (!is_p2p && hdr.zoom_inner[0] == SRV_SCREEN_SHARE_TYPE
-                && hdr.zoom_inner[7] == P2P_SCREEN_SHARE_TYPE)
-            || (hdr.zoom_inner[0] == RTCP_SR_TYPE
-                || hdr.zoom_inner[0] == RTCP_SR_SD_TYPE)) {
-
-            if (hdr.zoom_inner[0] == AUDIO_TYPE) {
-                hdr.rtp_rtcp_offset = hdr.udp_pl_offset + (is_p2p ? 0 : 8) + 19;
-                hdr.rtp = (rtp::hdr*) (buf + hdr.rtp_rtcp_offset);
-            } else if (hdr.zoom_inner[0] == VIDEO_TYPE) {
-
-                if (hdr.zoom_inner[20] == 0x02) {
-                    hdr.rtp_rtcp_offset = hdr.udp_pl_offset + (is_p2p ? 0 : 8) + 24;
-                    hdr.rtp = (rtp::hdr*) (buf + hdr.rtp_rtcp_offset);
-                } else {
-                    hdr.rtp_rtcp_offset = hdr.udp_pl_offset + (is_p2p ? 0 : 8) + 20;
-                    hdr.rtp = (rtp::hdr*) (buf + hdr.rtp_rtcp_offset);
-                }
+struct zoom::headers zoom::parse_zoom_pkt_buf(const unsigned char* buf, bool includes_eth, bool is_p2p) {
 
-            } else if (is_p2p && hdr.zoom_inner[0] == P2P_SCREEN_SHARE_TYPE) {
-                hdr.rtp_rtcp_offset = hdr.udp_pl_offset + 20;
-                hdr.rtp = (rtp::hdr*) (buf + hdr.rtp_rtcp_offset);
-            } else if (!is_p2p && hdr.zoom_inner[0] == SRV_SCREEN_SHARE_TYPE
-                && hdr.zoom_inner[7] == P2P_SCREEN_SHARE_TYPE) {
-                hdr.rtp_rtcp_offset = hdr.udp_pl_offset + 35;
-                hdr.rtp = (rtp::hdr*) (buf + hdr.rtp_rtcp_offset);
-            } else if (hdr.zoom_inner[0] == RTCP_SR_TYPE || hdr.zoom_inner[0] == RTCP_SR_SD_TYPE) {
-                hdr.rtp_rtcp_offset = hdr.udp_pl_offset + (is_p2p ? 0 : 8) + 16;
-                hdr.rtcp = (rtcp::hdr*) (buf + hdr.rtp_rtcp_offset);
-            }
+    return parse_zoom_hdrs(buf, parse_net_hdrs(buf, includes_eth), is_p2p);
+}
 
-            if (hdr.rtp && hdr.rtp->extension()) { // get rtp extension header with type == 1
+zoom::net_headers zoom::parse_net_hdrs(const unsigned char* buf, bool includes_eth) {
 
-                auto* rtp_ext_ptr = buf + hdr.rtp_rtcp_offset + rtp::HDR_LEN;
-                auto ext_bytes =  (rtp_ext_ptr[2] << 8) + (rtp_ext_ptr[3]) * 4;
+    return includes_eth ? parse_net_hdrs<net::link_layer::eth>(buf)
+                        : parse_net_hdrs<net::link_layer::raw>(buf);
+}
 
-                for (auto ext_byte_i = 4; ext_byte_i < 4 + ext_bytes;) {
-                    if (rtp_ext_ptr[ext_byte_i] != 0) { // 0 -> padding byte
+struct zoom::headers zoom::parse_zoom_hdrs(const unsigned char* buf, const net_headers& net_hdr,
+                                           bool is_p2p) {
 
-                        auto type = (rtp_ext_ptr[ext_byte_i] >> 4) & 0x0f;
-                        auto len = (rtp_ext_ptr[ext_byte_i] & 0x0f) + 1;
+    return is_p2p ? parse_zoom_hdrs<true>(buf, net_hdr) : parse_zoom_hdrs<false>(buf, net_hdr);
+}
 
-                        if (type == 1 && len == 3) {
-                            std::memcpy(hdr.rtp_ext1, rtp_ext_ptr + ext_byte_i + 1, 3);
-                            break;
-                        }
+template <net::link_layer L>
+zoom::net_headers zoom::parse_net_hdrs(const unsigned char* buf) {
 
-                        ext_byte_i += (len + 1);
-                    } else {
-                        ext_byte_i++;
-                    }
-                }
-            }
+    net_headers net_hdr;
+    constexpr unsigned ip_offset = net::link_hdr_len<L>();
+
+    net_hdr.ip = (net::ipv4::hdr*) (buf + ip_offset);
+    net_hdr.ip_5t.ip_src = ntohl(net_hdr.ip->src_addr);
+    net_hdr.ip_5t.ip_dst = ntohl(net_hdr.ip->dst_addr);
+    net_hdr.ip_5t.ip_proto = net_hdr.ip->next_proto_id;
+
+    if (net_hdr.ip_5t.ip_proto == 6 || net_hdr.ip_5t.ip_proto == 17) {
+
+        auto tp_offset = ip_offset + net_hdr.ip->ihl_bytes();
+        auto tp_hdr = (net::tcp_or_udp_hdr*) (buf + tp_offset);
+
+        net_hdr.ip_5t.tp_src = ntohs(tp_hdr->src_port);
+        net_hdr.ip_5t.tp_dst = ntohs(tp_hdr->dst_port);
+
+        if (net_hdr.ip_5t.ip_proto == 17) {
+            net_hdr.udp = (net::udp::hdr*) (buf + tp_offset);
+            net_hdr.udp_pl_offset = tp_offset + net::udp::HDR_LEN;
+            net_hdr.udp_dgram_len = ntohs(net_hdr.udp->dgram_len);
         }
     }
 
+    return net_hdr;
+}
+
+template <net::link_layer L>
+zoom::net6_headers zoom::parse_net6_hdrs(const unsigned char* buf) {
+
+    net6_headers net_hdr;
+    constexpr unsigned ip_offset = net::link_hdr_len<L>();
+
+    net_hdr.ip = (net::ipv6::hdr*) (buf + ip_offset);
+    net_hdr.ip_5t.ip_src = net_hdr.ip->src_addr;
+    net_hdr.ip_5t.ip_dst = net_hdr.ip->dst_addr;
+    net_hdr.ip_5t.ip_proto = net_hdr.ip->next_header;
+
+    if (net_hdr.ip_5t.ip_proto == 6 || net_hdr.ip_5t.ip_proto == 17) {
+
+        constexpr auto tp_offset = ip_offset + net::ipv6::HDR_LEN;
+        auto tp_hdr = (net::tcp_or_udp_hdr*) (buf + tp_offset);
+
+        net_hdr.ip_5t.tp_src = ntohs(tp_hdr->src_port);
+        net_hdr.ip_5t.tp_dst = ntohs(tp_hdr->dst_port);
+
+        if (net_hdr.ip_5t.ip_proto == 17) {
+            net_hdr.udp = (net::udp::hdr*) (buf + tp_offset);
+            net_hdr.udp_pl_offset = tp_offset + net::udp::HDR_LEN;
+            net_hdr.udp_dgram_len = ntohs(net_hdr.udp->dgram_len);
+        }
+    }
+
+    return net_hdr;
+}
+
+template <bool IsP2P>
+struct zoom::headers zoom::parse_zoom_hdrs(const unsigned char* buf, const net_headers& net_hdr) {
+
+    struct headers hdr;
+
+    hdr.ip = net_hdr.ip;
+
+    if (net_hdr.udp) {
+
+        hdr.udp = net_hdr.udp;
+        hdr.udp_pl_offset = net_hdr.udp_pl_offset;
+        parse_udp_pl<IsP2P>(buf, hdr);
+    }
+
     return hdr;
 }
+
+template <bool IsP2P>
+struct zoom::headers zoom::parse_zoom_hdrs(const unsigned char* buf, const net6_headers& net_hdr) {
+
+    struct headers hdr;
+
+    hdr.ip6 = net_hdr.ip;
+
+    if (net_hdr.udp) {
+
+        hdr.udp = net_hdr.udp;
+        hdr.udp_pl_offset = net_hdr.udp_pl_offset;
+        parse_udp_pl<IsP2P>(buf, hdr);
+    }
+
+    return hdr;
+}
+
+template zoom::net_headers zoom::parse_net_hdrs<net::link_layer::eth>(const unsigned char*);
+template zoom::net_headers zoom::parse_net_hdrs<net::link_layer::eth_vlan>(const unsigned char*);
+template zoom::net_headers zoom::parse_net_hdrs<net::link_layer::raw>(const unsigned char*);
+template zoom::net_headers zoom::parse_net_hdrs<net::link_layer::loop>(const unsigned char*);
+
+template struct zoom::headers zoom::parse_zoom_hdrs<false>(const unsigned char*, const net_headers&);
+template struct zoom::headers zoom::parse_zoom_hdrs<true>(const unsigned char*, const net_headers&);
+
+template zoom::net6_headers zoom::parse_net6_hdrs<net::link_layer::eth>(const unsigned char*);
+template zoom::net6_headers zoom::parse_net6_hdrs<net::link_layer::eth_vlan>(const unsigned char*);
+template zoom::net6_headers zoom::parse_net6_hdrs<net::link_layer::raw>(const unsigned char*);
+template zoom::net6_headers zoom::parse_net6_hdrs<net::link_layer::loop>(const unsigned char*);
+
+template struct zoom::headers zoom::parse_zoom_hdrs<false>(const unsigned char*, const net6_headers&);
+template struct zoom::headers zoom::parse_zoom_hdrs<true>(const unsigned char*, const net6_headers&);
+
+void zoom::parse_zoom_hdrs_batch(const unsigned char* const* bufs, const net_headers* net_hdrs,
+                                 const bool* is_p2p, std::size_t count, struct headers* hdrs) {
+
+    for (std::size_t i = 0; i < count; i++) {
+
+        if (i + BATCH_PREFETCH_DISTANCE < count) {
+
+            const auto& ahead = net_hdrs[i + BATCH_PREFETCH_DISTANCE];
+
+            if (ahead.udp) {
+                auto* udp_pl = bufs[i + BATCH_PREFETCH_DISTANCE] + ahead.udp_pl_offset;
+                __builtin_prefetch(udp_pl);
+                __builtin_prefetch(udp_pl + 63);
+            }
+        }
+
+        const auto* buf = bufs[i];
+        const auto& net_hdr = net_hdrs[i];
+        auto& hdr = hdrs[i];
+
+        hdr = {};
+        hdr.ip = net_hdr.ip;
+
+        if (!net_hdr.udp) continue;
+
+        hdr.udp = net_hdr.udp;
+        hdr.udp_pl_offset = net_hdr.udp_pl_offset;
+
+        auto* udp_pl = buf + hdr.udp_pl_offset;
+        bool is_srv_media = !is_p2p[i] && udp_pl[0] == SRV_MEDIA_TYPE;
+
+        hdr.zoom_outer = is_p2p[i] ? nullptr : udp_pl;
+        hdr.zoom_inner = udp_pl + (is_srv_media ? 8 : 0);
+
+        const auto& c = (is_p2p[i] ? P2P_MEDIA_CLASSES : SRV_MEDIA_CLASSES)[hdr.zoom_inner[0]];
+
+        bool valid = (c.rtp | c.rtcp)
+                     && (!c.srv_screen || hdr.zoom_inner[7] == P2P_SCREEN_SHARE_TYPE);
+
+        if (!valid) continue;
+
+        hdr.rtp_rtcp_offset = hdr.udp_pl_offset + c.offset
+                              + ((c.video && hdr.zoom_inner[20] == 0x02) ? 4 : 0);
+
+        if (c.rtp) {
+            hdr.rtp = (rtp::hdr*) (buf + hdr.rtp_rtcp_offset);
+
+            if (hdr.rtp->extension()) {
+                parse_rtp_ext1(buf, hdr);
+            }
+        } else {
+            hdr.rtcp = (rtcp::hdr*) (buf + hdr.rtp_rtcp_offset);
+        }
+    }
+}
@@ -18,6 +18,7 @@ namespace zoom {
 
     struct headers {
         const net::ipv4::hdr* ip        = nullptr;
+        const net::ipv6::hdr* ip6       = nullptr;
         const net::udp::hdr* udp        = nullptr;
         const unsigned char* zoom_inner = nullptr;
         const unsigned char* zoom_outer = nullptr;
@@ -29,10 +30,45 @@ namespace zoom {
         unsigned rtp_rtcp_offset        = 0;
     };
 
+    /*!
+     * Network and transport layer headers of a packet, parsed once per packet
+     *
+     * - ip_5t is in host byte order and can be passed to flow_tracker::track() directly
+     * - parse_zoom_hdrs() and zoom::pkt continue from these offsets and fields instead of walking
+     *   and byte-swapping the Ethernet/IP/UDP headers again
+     */
+    struct net_headers {
+        net::ipv4_5tuple ip_5t      = {};
+        const net::ipv4::hdr* ip    = nullptr;
+        const net::udp::hdr* udp    = nullptr;
+        unsigned udp_pl_offset      = 0;
+        std::uint16_t udp_dgram_len = 0;
+    };
+
+    /*!
+     * IPv6 counterpart of net_headers
+     *
+     * - only covers packets whose TCP or UDP header directly follows the fixed IPv6 header
+     */
+    struct net6_headers {
+        net::ipv6_5tuple ip_5t      = {};
+        const net::ipv6::hdr* ip    = nullptr;
+        const net::udp::hdr* udp    = nullptr;
+        unsigned udp_pl_offset      = 0;
+        std::uint16_t udp_dgram_len = 0;
+    };
+
     struct pkt {
 
         pkt();
         pkt(const struct zoom::headers& hdr, timeval tv, std::size_t pcap_frame_len, bool is_p2p);
+        pkt(const net_headers& net_hdr, const struct zoom::headers& hdr, timeval tv,
+            std::size_t pcap_frame_len, bool is_p2p);
+
+        //! - sets flags.ipv6 and stores net::ipv6::addr::fold32() of both addresses in ip_5t,
+        //!   which keeps the record size and identifies flows, but does not recover the addresses
+        pkt(const net6_headers& net_hdr, const struct zoom::headers& hdr, timeval tv,
+            std::size_t pcap_frame_len, bool is_p2p);
         pkt(const pkt&) = default;
         pkt& operator=(const pkt&) = default;
 
@@ -48,7 +84,8 @@ namespace zoom {
             std::uint8_t rtcp     : 1;
             std::uint8_t to_srv   : 1;
             std::uint8_t from_srv : 1;
-            std::uint8_t pad      : 2;
+            std::uint8_t ipv6     : 1;
+            std::uint8_t pad      : 1;
         };
 
         struct rtp_data { // 12 Bytes
@@ -111,6 +148,7 @@ namespace zoom {
         std::uint32_t rtp_ssrc = 0;
         enum media_type media_type;
         enum stream_type stream_type;
+        bool ipv6 = false; // ip_5t holds the address digests of an IPv6 flow (see pkt)
 
         static media_stream_key from_pkt(const pkt& pkt);
         bool operator<(const struct media_stream_key& a) const;
@@ -125,6 +163,64 @@ namespace zoom {
 
     [[nodiscard]] struct headers parse_zoom_pkt_buf(const unsigned char* buf,
             bool includes_eth = true, bool is_p2p = false);
+
+    //! parses the IPv4 and UDP/TCP headers of a packet and extracts its 5-tuple
+    [[nodiscard]] net_headers parse_net_hdrs(const unsigned char* buf, bool includes_eth = true);
+
+    //! parses the Zoom headers of a packet whose network headers were parsed by parse_net_hdrs()
+    //! - single-pass alternative to parse_zoom_pkt_buf() once the flow type is known
+    [[nodiscard]] struct headers parse_zoom_hdrs(const unsigned char* buf,
+            const net_headers& net_hdr, bool is_p2p);
+
+    //! parse_net_hdrs() specialized for the link layer framing L
+    //! - instantiated for all net::link_layer values, choose L once per file (or per frame for
+    //!   optional VLAN tags) to take the link layer branches out of the packet loop
+    template <net::link_layer L>
+    [[nodiscard]] net_headers parse_net_hdrs(const unsigned char* buf);
+
+    //! parse_zoom_hdrs() specialized for server-based (IsP2P = false) or P2P flows
+    template <bool IsP2P>
+    [[nodiscard]] struct headers parse_zoom_hdrs(const unsigned char* buf,
+            const net_headers& net_hdr);
+
+    //! parses the fixed IPv6 header and a directly following UDP/TCP header of a packet
+    //! - packets with extension headers only yield addresses and the next header type
+    template <net::link_layer L>
+    [[nodiscard]] net6_headers parse_net6_hdrs(const unsigned char* buf);
+
+    //! parse_zoom_hdrs() for IPv6 packets, sets headers::ip6 instead of headers::ip
+    template <bool IsP2P>
+    [[nodiscard]] struct headers parse_zoom_hdrs(const unsigned char* buf,
+            const net6_headers& net_hdr);
+
+    //! parse_zoom_pkt_buf() specialized for link layer framing L and server-based or P2P flows
+    template <net::link_layer L, bool IsP2P>
+    [[nodiscard]] inline struct headers parse_zoom_pkt_buf(const unsigned char* buf) {
+        return parse_zoom_hdrs<IsP2P>(buf, parse_net_hdrs<L>(buf));
+    }
+
+    //! number of packets parse_zoom_hdrs_batch() prefetches ahead
+    const unsigned BATCH_PREFETCH_DISTANCE = 8;
+
+    //! parses the Zoom headers of count packets, equivalent to parse_zoom_hdrs() on each packet
+    //! - prefetches the UDP payloads of packets BATCH_PREFETCH_DISTANCE ahead of the current one
+    //! - classifies Zoom types and RTP/RTCP offsets with lookup tables instead of a branch chain
+    void parse_zoom_hdrs_batch(const unsigned char* const* bufs, const net_headers* net_hdrs,
+            const bool* is_p2p, std::size_t count, struct headers* hdrs);
+}
+
+namespace std {
+    template<> struct hash<zoom::media_stream_key> {
+        //! mixes the 5-tuple hash with the SSRC, the media and stream types and the IPv6 flag
+        std::size_t operator()(const zoom::media_stream_key& k) const noexcept {
+            std::uint64_t h = hash<net::ipv4_5tuple>{}(k.ip_5t);
+            h ^= ((std::uint64_t) k.ipv6 << 48u) | ((std::uint64_t) k.rtp_ssrc << 16u)
+                 | ((std::uint64_t) k.media_type << 8u) | (std::uint64_t) k.stream_type;
+            h = (h ^ (h >> 30u)) * 0xbf58476d1ce4e5b9u;
+            h = (h ^ (h >> 27u)) * 0x94d049bb133111ebu;
+            return (std::size_t) (h ^ (h >> 31u));
+        }
+    };
 }
 
 #endif
@@ -1,17 +1,174 @@
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
 #include "zoom_analyzer.h"
 
-void zoom::analyzer::enable_pkt_log(const std::string& file_path) {
+namespace {
+
+    using type = arrow_ipc_writer::type;
+
+    const std::vector<arrow_ipc_writer::column> PKT_LOG_SCHEMA = {
+        {"ts_s", type::uint32}, {"ts_us", type::uint32}, {"dir", type::utf8},
+        {"flow_type", type::utf8, true}, {"ip_proto", type::uint8},
+        {"ip_src", type::utf8, true}, {"tp_src", type::uint16},
+        {"ip_dst", type::utf8, true}, {"tp_dst", type::uint16},
+        {"media_type", type::utf8, true}, {"pkts_in_frame", type::uint16, true},
+        {"ssrc", type::uint32}, {"pt", type::uint8}, {"rtp_seq", type::uint16},
+        {"rtp_ts", type::uint32}, {"pcap_frame_len", type::uint16}, {"pl_len", type::uint16},
+        {"rtp_ext1", type::utf8, true}, {"drop", type::uint8}
+    };
+
+    const std::vector<arrow_ipc_writer::column> FRAME_LOG_SCHEMA = {
+        {"ip_proto", type::uint8}, {"ip_src", type::utf8, true}, {"tp_src", type::uint16},
+        {"ip_dst", type::utf8, true}, {"tp_dst", type::uint16}, {"ssrc", type::uint32},
+        {"media_type", type::uint8}, {"rtp_ext1", type::utf8},
+        {"min_ts_s", type::uint32}, {"min_ts_us", type::uint32},
+        {"max_ts_s", type::uint32}, {"max_ts_us", type::uint32}, {"rtp_ts", type::uint32},
+        {"pkts_seen", type::uint32}, {"pkts_hint", type::uint32}, {"frame_size", type::uint32},
+        {"fps", type::uint32}, {"jitter_ms", type::float64}
+    };
+
+    const std::vector<arrow_ipc_writer::column> STREAMS_LOG_SCHEMA = {
+        {"rtp_ssrc", type::uint32}, {"media_type", type::utf8}, {"stream_type", type::utf8},
+        {"ip_src", type::utf8, true}, {"tp_src", type::uint16},
+        {"ip_dst", type::utf8, true}, {"tp_dst", type::uint16},
+        {"start_ts_s", type::uint64}, {"start_ts_us", type::uint64},
+        {"end_ts_s", type::uint64}, {"end_ts_us", type::uint64},
+        {"start_rtp_ts", type::uint32}, {"end_rtp_ts", type::uint32},
+        {"pkts", type::uint64}, {"bytes", type::uint64}
+    };
+
+    const std::vector<arrow_ipc_writer::column> STATS_LOG_SCHEMA = {
+        {"ts_s", type::uint32}, {"report_count", type::uint32}, {"rtp_ssrc", type::uint32},
+        {"media_type", type::utf8}, {"stream_type", type::utf8},
+        {"ip_src", type::utf8, true}, {"tp_src", type::uint16},
+        {"ip_dst", type::utf8, true}, {"tp_dst", type::uint16},
+        {"pkts", type::uint64}, {"bytes", type::uint64}, {"lost", type::uint64},
+        {"duplicate", type::uint64}, {"out_of_order", type::uint64}, {"frames", type::uint64},
+        {"mean_frame_len", type::float64}, {"mean_jitter", type::float64}
+    };
+
+    //! names of the quantile columns (see zoom::analyzer::enable_quantiles()), in the order of
+    //! for_each_quantile()
+    const std::vector<std::string> QUANTILE_COLUMNS = {
+        "jitter_ms_p50", "jitter_ms_p95", "jitter_ms_p99",
+        "frame_size_p50", "frame_size_p95", "frame_size_p99",
+        "frame_gap_ms_p50", "frame_gap_ms_p95", "frame_gap_ms_p99",
+        "fps_p50", "fps_p95", "fps_p99"
+    };
+
+    template <typename Fx>
+    void for_each_quantile(const zoom::analyzer::frame_quantiles& q, Fx&& fx) {
+
+        for (const auto* values: {&q.jitter_ms, &q.frame_size, &q.frame_gap_ms, &q.fps}) {
+            for (auto v: *values)
+                fx(v);
+        }
+    }
+
+    std::vector<arrow_ipc_writer::column> with_quantiles(
+            std::vector<arrow_ipc_writer::column> schema, bool quantiles) {
+
+        if (quantiles) {
+            for (const auto& name: QUANTILE_COLUMNS)
+                schema.push_back({name, type::float64});
+        }
+
+        return schema;
+    }
+
+    //! the CSV header of the quantile columns, including the leading comma
+    std::string quantiles_header(bool quantiles) {
+
+        std::string header;
+
+        if (quantiles) {
+            for (const auto& name: QUANTILE_COLUMNS)
+                header += "," + name;
+        }
+
+        return header;
+    }
+
+    //! formats 3 bytes as hex digits (like csv_buffer::put_hex()) into out
+    std::string_view hex(const std::uint8_t (&bytes)[3], char (&out)[8], bool prefix) {
+
+        static const char digits[] = "0123456789abcdef";
+        std::size_t len = 0;
+
+        if (prefix)
+            out[len++] = '0', out[len++] = 'x';
+
+        for (auto b: bytes)
+            out[len++] = digits[b >> 4u], out[len++] = digits[b & 0x0fu];
+
+        return {out, len};
+    }
+
+    std::string_view one_char(const char& c) {
+        return {&c, 1};
+    }
+
+    //! IPv6 records only hold digests of their addresses (see zoom::pkt), which are logged as NA
+    csv_buffer& put_addr(csv_buffer& row, std::uint32_t addr, bool ipv6) {
+        return ipv6 ? row.put("NA") : row.put_ipv4(addr);
+    }
 
-    _pkt_log.open(file_path);
+    arrow_ipc_writer& put_addr(arrow_ipc_writer& a, std::uint32_t addr, bool ipv6) {
+        return ipv6 ? a.put_null() : a.put_ipv4(addr);
+    }
+
+    std::string addr_to_str(std::uint32_t addr, bool ipv6) {
+        return ipv6 ? "NA" : net::ipv4::addr_to_str(addr);
+    }
+
+    void check_arrow_append(bool append, zoom::analyzer::log_format format) {
+
+        if (append && format == zoom::analyzer::log_format::arrow)
+            throw std::invalid_argument("zoom::analyzer: Arrow IPC logs cannot be appended to");
+    }
+}
+
+zoom::analyzer::~analyzer() {
+
+    _stop_async();
+}
+
+void zoom::analyzer::enable_pkt_log(const std::string& file_path, bool append,
+                                    log_format format) {
+
+    check_arrow_append(append, format);
+
+    if (format == log_format::arrow) {
+        _pkt_log.open_arrow(file_path, PKT_LOG_SCHEMA);
+        return;
+    }
+
+    _pkt_log.open(file_path, append);
+
+    if (append)
+        return;
 
     _pkt_log.stream << "ts_s,ts_us,dir,flow_type,ip_proto,ip_src,tp_src,ip_dst,tp_dst,media_type,"
                     << "pkts_in_frame,ssrc,pt,rtp_seq,rtp_ts,pcap_frame_len,pl_len,rtp_ext1,drop"
                     << std::endl;
 }
 
-void zoom::analyzer::enable_frame_log(const std::string& file_path) {
+void zoom::analyzer::enable_frame_log(const std::string& file_path, bool append,
+                                      log_format format) {
 
-    _frame_log.open(file_path);
+    check_arrow_append(append, format);
+
+    if (format == log_format::arrow) {
+        _frame_log.open_arrow(file_path, FRAME_LOG_SCHEMA);
+        return;
+    }
+
+    _frame_log.open(file_path, append);
+
+    if (append)
+        return;
 
     _frame_log.stream << "ip_proto,ip_src,tp_src,ip_dst,tp_dst,ssrc,media_type,rtp_ext1,"
                       << "min_ts_s, min_ts_us,max_ts_s,max_ts_us,rtp_ts,pkts_seen,pkts_hint,"
@@ -19,33 +176,510 @@ void zoom::analyzer::enable_frame_log(const std::string& file_path) {
                       << std::endl;
 }
 
-void zoom::analyzer::enable_streams_log(const std::string& file_path) {
+void zoom::analyzer::enable_streams_log(const std::string& file_path, bool append,
+                                        log_format format) {
+
+    check_arrow_append(append, format);
+
+    if (format == log_format::arrow) {
+        _streams_log.open_arrow(file_path, with_quantiles(STREAMS_LOG_SCHEMA, _quantiles));
+        return;
+    }
+
+    _streams_log.open(file_path, append);
 
-    _streams_log.open(file_path);
+    if (append)
+        return;
+
+    _streams_log.stream << "rtp_ssrc,media_type,stream_type,ip_src,tp_src,ip_dst,tp_dst,"
+                        << "start_ts_s,start_ts_us,end_ts_s,end_ts_us,start_rtp_ts,end_rtp_ts,"
+                        << "pkts,bytes" << quantiles_header(_quantiles) << std::endl;
 }
 
-void zoom::analyzer::enable_stats_log(const std::string& file_path) {
+void zoom::analyzer::enable_stats_log(const std::string& file_path, bool append,
+                                      log_format format, unsigned resolution_s) {
+
+    check_arrow_append(append, format);
+    auto& log = _stats_log_at(resolution_s);
+
+    if (format == log_format::arrow) {
+        log.open_arrow(file_path, with_quantiles(STATS_LOG_SCHEMA, _quantiles));
+        return;
+    }
 
-    _stats_log.open(file_path);
+    log.open(file_path, append);
 
-    _stats_log.stream << "ts_s,report_count,rtp_ssrc,media_type,stream_type,ip_src,tp_src,ip_dst,"
-                      << "tp_dst,pkts,bytes,lost,duplicate,out_of_order,frames,mean_frame_len,"
-                      << "mean_jitter" << std::endl;
+    if (append)
+        return;
+
+    log.stream << "ts_s,report_count,rtp_ssrc,media_type,stream_type,ip_src,tp_src,ip_dst,"
+               << "tp_dst,pkts,bytes,lost,duplicate,out_of_order,frames,mean_frame_len,"
+               << "mean_jitter" << quantiles_header(_quantiles) << std::endl;
 }
 
-void zoom::analyzer::_log::open(const std::string& file_path) {
+void zoom::analyzer::enable_async_logs(std::size_t queue_len, overflow_policy policy) {
+
+    if (_async)
+        throw std::logic_error("zoom::analyzer: async logs are already enabled");
 
-    stream.open(file_path);
+    _async = std::make_unique<_async_writer>(queue_len, policy);
+    _async->stats.queue_len = queue_len;
+    _async->thread = std::thread([this]() { _run_async_writer(); });
+}
+
+void zoom::analyzer::enable_quantiles() {
+
+    _quantiles = true;
+}
+
+zoom::analyzer::async_log_stats zoom::analyzer::async_stats() const {
+
+    return _async ? _async->stats : async_log_stats{};
+}
+
+void zoom::analyzer::forward_rows(row_sink* sink, const analyzer& logs) {
+
+    if (_async)
+        throw std::logic_error("zoom::analyzer: cannot forward rows with async logs");
+
+    _row_sink = sink;
+    _quantiles = logs._quantiles;
+    _frame_log.enabled = logs._frame_log.enabled;
+    _streams_log.enabled = logs._streams_log.enabled;
+    _stats_log.enabled = logs._stats_log.enabled;
+
+    for (std::size_t i = 0; i < _stats_rollup_logs.size(); i++)
+        _stats_rollup_logs[i].enabled = logs._stats_rollup_logs[i].enabled;
+}
+
+zoom::analyzer::log_positions zoom::analyzer::flush_logs() {
+
+    _drain_async();
+
+    log_positions pos = {
+        .pkt     = _pkt_log.flush(),
+        .frame   = _frame_log.flush(),
+        .streams = _streams_log.flush(),
+        .stats   = _stats_log.flush()
+    };
+
+    for (std::size_t i = 0; i < _stats_rollup_logs.size(); i++)
+        pos.stats_rollups[i] = _stats_rollup_logs[i].flush();
+
+    return pos;
+}
+
+zoom::analyzer::_log& zoom::analyzer::_stats_log_at(unsigned resolution_s) {
+
+    if (resolution_s == 1)
+        return _stats_log;
+
+    for (std::size_t i = 0; i < STATS_ROLLUP_RESOLUTIONS.size(); i++) {
+        if (STATS_ROLLUP_RESOLUTIONS[i] == resolution_s)
+            return _stats_rollup_logs[i];
+    }
+
+    throw std::invalid_argument("zoom::analyzer: unsupported stats resolution of "
+                                + std::to_string(resolution_s) + "s");
+}
+
+void zoom::analyzer::_log::open(const std::string& file_path, bool append) {
+
+    stream.open(file_path, append);
     enabled = true;
 
     if (!stream.is_open())
         throw std::runtime_error("zoom::analyzer: could not open log file at " + file_path);
 }
 
+void zoom::analyzer::_log::open_arrow(const std::string& file_path,
+                                      const std::vector<arrow_ipc_writer::column>& schema) {
+
+    if (output_stream::is_gzip_path(file_path))
+        throw std::invalid_argument("zoom::analyzer: Arrow IPC logs cannot be gzip-compressed");
+
+    arrow = std::make_unique<arrow_ipc_writer>(file_path, schema);
+    enabled = true;
+}
+
+zoom::analyzer::_log::~_log() {
+
+    if (stream.is_open())
+        rows.write_to(stream);
+}
+
+void zoom::analyzer::_log::end_row() {
+
+    rows.put('\n');
+
+    if (rows.full())
+        rows.write_to(stream);
+}
+
+std::int64_t zoom::analyzer::_log::flush() {
+
+    if (!enabled || arrow)
+        return -1;
+
+    rows.write_to(stream);
+    return stream.flush_position();
+}
+
 void zoom::analyzer::_log::close() {
 
+    if (arrow) {
+        arrow->close();
+        return;
+    }
+
     if (!stream.is_open())
         throw std::logic_error("zoom::analyzer: could not close log file: file is not open");
 
+    rows.write_to(stream);
     stream.close();
 }
+
+void zoom::analyzer::_push(const log_record& record) {
+
+    auto& stats = _async->stats;
+
+    if ((stats.rows & 63u) == 0)
+        stats.max_depth = std::max(stats.max_depth, _async->queue.size());
+
+    // quantiles complete the row before them, they are dropped with it but never on their own
+    bool completes_row = std::holds_alternative<quantiles_row>(record);
+
+    if (completes_row && _async->dropped_last) {
+        stats.drops++;
+        return;
+    }
+
+    if (!_async->queue.try_push(record)) {
+
+        stats.max_depth = stats.queue_len;
+
+        if (_async->policy == overflow_policy::drop && !completes_row) {
+            stats.drops++;
+            _async->dropped_last = true;
+            return;
+        }
+
+        stats.stalls++;
+
+        while (!_async->queue.try_push(record))
+            std::this_thread::yield();
+    }
+
+    _async->dropped_last = false;
+    stats.rows++;
+}
+
+void zoom::analyzer::_run_async_writer() {
+
+    log_record record;
+    unsigned idle = 0;
+
+    while (true) {
+
+        if (_async->queue.try_pop(record)) {
+
+            _write_record(record);
+
+            // only this thread writes rows_written, the store publishes the written row
+            _async->rows_written.store(_async->rows_written.load(std::memory_order_relaxed) + 1,
+                                       std::memory_order_release);
+            idle = 0;
+
+        } else if (_async->stop.load(std::memory_order_acquire)) {
+
+            // rows pushed before stop was set are visible now
+            if (_async->queue.empty())
+                break;
+
+        } else if (++idle < 64) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+}
+
+void zoom::analyzer::_drain_async() {
+
+    if (!_async)
+        return;
+
+    while (_async->rows_written.load(std::memory_order_acquire) != _async->stats.rows)
+        std::this_thread::yield();
+}
+
+void zoom::analyzer::_stop_async() {
+
+    if (!_async)
+        return;
+
+    _async->stop.store(true, std::memory_order_release);
+    _async->thread.join();
+    _async.reset();
+}
+
+void zoom::analyzer::_write_record(const log_record& record) {
+
+    std::visit([this](const auto& row) { _write_row(row); }, record);
+}
+
+void zoom::analyzer::_write_row(const zoom::pkt& pkt) {
+
+    if (_pkt_log.arrow) {
+
+        auto& a = *_pkt_log.arrow;
+        char ext1[8];
+
+        a.put(pkt.ts.s).put(pkt.ts.us).put("u");
+
+        if (pkt.flags.srv) {
+            a.put("s");
+        } else if (pkt.flags.p2p) {
+            a.put("p");
+        } else {
+            a.put_null();
+        }
+
+        a.put((unsigned) pkt.ip_5t.ip_proto);
+        put_addr(a, pkt.ip_5t.ip_src, pkt.flags.ipv6).put(pkt.ip_5t.tp_src);
+        put_addr(a, pkt.ip_5t.ip_dst, pkt.flags.ipv6).put(pkt.ip_5t.tp_dst);
+
+        if (pkt.zoom_media_type == zoom::AUDIO_TYPE) {
+            a.put("a");
+        } else if (pkt.zoom_media_type == zoom::VIDEO_TYPE) {
+            a.put("v");
+        } else {
+            a.put_null();
+        }
+
+        if (pkt.pkts_in_frame) {
+            a.put(pkt.pkts_in_frame);
+        } else {
+            a.put_null();
+        }
+
+        a.put((unsigned) pkt.proto.rtp.ssrc).put((unsigned) pkt.proto.rtp.pt)
+         .put((unsigned) pkt.proto.rtp.seq).put((unsigned) pkt.proto.rtp.ts)
+         .put((unsigned) pkt.pcap_frame_len).put((unsigned) pkt.udp_pl_len);
+
+        if (pkt.rtp_ext1[0] != 0 || pkt.rtp_ext1[1] != 0 || pkt.rtp_ext1[2] != 0) {
+            a.put(hex(pkt.rtp_ext1, ext1, true));
+        } else {
+            a.put_null();
+        }
+
+        a.put(0).end_row();
+        return;
+    }
+
+    auto& row = _pkt_log.rows;
+
+    row.put(pkt.ts.s).put(',').put(pkt.ts.us).put(",u,");
+
+    if (pkt.flags.srv) {
+        row.put("s,");
+    } else if (pkt.flags.p2p) {
+        row.put("p,");
+    } else {
+        row.put("NA,");
+    }
+
+    row.put((unsigned) pkt.ip_5t.ip_proto).put(',');
+    put_addr(row, pkt.ip_5t.ip_src, pkt.flags.ipv6).put(',').put(pkt.ip_5t.tp_src).put(',');
+    put_addr(row, pkt.ip_5t.ip_dst, pkt.flags.ipv6).put(',').put(pkt.ip_5t.tp_dst).put(',');
+
+    //TODO: handle screen share
+    if (pkt.zoom_media_type == zoom::AUDIO_TYPE) {
+        row.put("a,");
+    } else if (pkt.zoom_media_type == zoom::VIDEO_TYPE) {
+        row.put("v,");
+    } else {
+        row.put("NA,");
+    }
+
+    if (pkt.pkts_in_frame) {
+        row.put(pkt.pkts_in_frame).put(',');
+    } else {
+        row.put("NA,");
+    }
+
+    row.put((unsigned) pkt.proto.rtp.ssrc).put(',')
+       .put((unsigned) pkt.proto.rtp.pt).put(',')
+       .put((unsigned) pkt.proto.rtp.seq).put(',')
+       .put((unsigned) pkt.proto.rtp.ts).put(',')
+       .put((unsigned) pkt.pcap_frame_len).put(',')
+       .put((unsigned) pkt.udp_pl_len).put(',');
+
+    if (pkt.rtp_ext1[0] != 0 || pkt.rtp_ext1[1] != 0 || pkt.rtp_ext1[2] != 0) {
+        row.put("0x").put_hex(pkt.rtp_ext1[0]).put_hex(pkt.rtp_ext1[1]).put_hex(pkt.rtp_ext1[2])
+           .put(',');
+    } else {
+        row.put("NA,");
+    }
+
+    row.put('0');
+    _pkt_log.end_row();
+}
+
+void zoom::analyzer::_write_row(const frame_row& f) {
+
+    if (_frame_log.arrow) {
+        auto& a = *_frame_log.arrow;
+        char ext1[8];
+
+        a.put((unsigned) f.ip_5t.ip_proto);
+        put_addr(a, f.ip_5t.ip_src, f.ipv6).put(f.ip_5t.tp_src);
+        put_addr(a, f.ip_5t.ip_dst, f.ipv6).put(f.ip_5t.tp_dst)
+            .put(f.rtp_ssrc).put(f.pkt_type).put(hex(f.rtp_ext1, ext1, false))
+            .put(f.ts_min_s).put(f.ts_min_us).put(f.ts_max_s).put(f.ts_max_us)
+            .put(f.rtp_ts).put(f.pkts_seen).put(f.pkts_hint).put(f.frame_len).put(f.fps)
+            .put(f.jitter)
+            .end_row();
+        return;
+    }
+
+    auto& row = _frame_log.rows;
+
+    row.put((unsigned) f.ip_5t.ip_proto).put(',');
+    put_addr(row, f.ip_5t.ip_src, f.ipv6).put(',').put(f.ip_5t.tp_src).put(',');
+    put_addr(row, f.ip_5t.ip_dst, f.ipv6).put(',').put(f.ip_5t.tp_dst).put(',')
+       .put(f.rtp_ssrc).put(',')
+       .put((unsigned) f.pkt_type).put(',')
+       .put_hex(f.rtp_ext1[0])
+       .put_hex(f.rtp_ext1[1])
+       .put_hex(f.rtp_ext1[2]).put(',')
+       .put(f.ts_min_s).put(',')
+       .put(f.ts_min_us).put(',')
+       .put(f.ts_max_s).put(',')
+       .put(f.ts_max_us).put(',')
+       .put(f.rtp_ts).put(',')
+       .put(f.pkts_seen).put(',')
+       .put(f.pkts_hint).put(',')
+       .put(f.frame_len).put(',')
+       .put(f.fps).put(',')
+       .put(f.jitter, 5);
+
+    _frame_log.end_row();
+}
+
+void zoom::analyzer::_write_row(const stats_row& s) {
+
+    auto& log = _stats_log_at(s.resolution_s);
+
+    if (log.arrow) {
+        auto& a = *log.arrow;
+
+        a.put(s.ts).put(s.report_count).put(s.key.rtp_ssrc)
+            .put(one_char(zoom::media_type_to_char(s.key.media_type)))
+            .put(one_char(zoom::stream_type_to_char(s.key.stream_type)));
+        put_addr(a, s.key.ip_5t.ip_src, s.key.ipv6).put(s.key.ip_5t.tp_src);
+        put_addr(a, s.key.ip_5t.ip_dst, s.key.ipv6).put(s.key.ip_5t.tp_dst)
+            .put(s.pkts).put(s.bytes).put(s.lost).put(s.duplicate).put(s.out_of_order)
+            .put(s.frames).put(s.mean_frame_len).put(s.mean_jitter);
+
+        // otherwise ended by the quantiles_row that follows
+        if (!_quantiles)
+            a.end_row();
+
+        return;
+    }
+
+    log.rows
+        .put(s.ts).put(',')
+        .put(s.report_count).put(',')
+
+        .put(s.key.rtp_ssrc).put(',')
+        .put(zoom::media_type_to_char(s.key.media_type)).put(',')
+        .put(zoom::stream_type_to_char(s.key.stream_type)).put(',');
+
+    put_addr(log.rows, s.key.ip_5t.ip_src, s.key.ipv6).put(',')
+        .put(s.key.ip_5t.tp_src).put(',');
+    put_addr(log.rows, s.key.ip_5t.ip_dst, s.key.ipv6).put(',')
+        .put(s.key.ip_5t.tp_dst).put(',')
+
+        .put(s.pkts).put(',')
+        .put(s.bytes).put(',')
+
+        .put(s.lost).put(',')
+        .put(s.duplicate).put(',')
+        .put(s.out_of_order).put(',')
+
+        .put(s.frames).put(',')
+        .put(s.mean_frame_len, 6).put(',')
+        .put(s.mean_jitter, 6);
+
+    if (!_quantiles)
+        log.end_row();
+}
+
+void zoom::analyzer::_write_row(const streams_row& s) {
+
+    if (_streams_log.arrow) {
+        auto& a = *_streams_log.arrow;
+
+        a.put(s.key.rtp_ssrc)
+            .put(one_char(zoom::media_type_to_char(s.key.media_type)))
+            .put(one_char(zoom::stream_type_to_char(s.key.stream_type)));
+        put_addr(a, s.key.ip_5t.ip_src, s.key.ipv6).put(s.key.ip_5t.tp_src);
+        put_addr(a, s.key.ip_5t.ip_dst, s.key.ipv6).put(s.key.ip_5t.tp_dst)
+            .put(s.first_ts.tv_sec).put(s.first_ts.tv_usec)
+            .put(s.last_ts.tv_sec).put(s.last_ts.tv_usec)
+            .put(s.first_rtp).put(s.last_rtp)
+            .put(s.pkts).put(s.bytes);
+
+        if (!_quantiles)
+            a.end_row();
+
+        return;
+    }
+
+    _streams_log.stream
+        << s.key.rtp_ssrc << ","
+        << zoom::media_type_to_char(s.key.media_type) << ","
+        << zoom::stream_type_to_char(s.key.stream_type) << ","
+
+        << addr_to_str(s.key.ip_5t.ip_src, s.key.ipv6) << ","
+        << s.key.ip_5t.tp_src << ","
+        << addr_to_str(s.key.ip_5t.ip_dst, s.key.ipv6) << ","
+        << s.key.ip_5t.tp_dst << ","
+
+        << s.first_ts.tv_sec << ","
+        << s.first_ts.tv_usec << ","
+        << s.last_ts.tv_sec << ","
+        << s.last_ts.tv_usec << ","
+
+        << s.first_rtp << ","
+        << s.last_rtp << ","
+
+        << s.pkts << ","
+        << s.bytes;
+
+    if (!_quantiles)
+        _streams_log.stream << '\n';
+}
+
+void zoom::analyzer::_write_row(const quantiles_row& q) {
+
+    auto& log = q.resolution_s ? _stats_log_at(q.resolution_s) : _streams_log;
+
+    if (log.arrow) {
+        for_each_quantile(q.quantiles, [&](double v) { log.arrow->put(v); });
+        log.arrow->end_row();
+        return;
+    }
+
+    // the streams log is written to its stream directly
+    if (!q.resolution_s) {
+        for_each_quantile(q.quantiles, [&](double v) { log.stream << "," << v; });
+        log.stream << '\n';
+        return;
+    }
+
+    for_each_quantile(q.quantiles, [&](double v) { log.rows.put(',').put(v, 6); });
+    log.end_row();
+}
@@ -2,8 +2,20 @@
 #ifndef ZOOM_ANALYSIS_ZOOM_ANALYZER_H
 #define ZOOM_ANALYSIS_ZOOM_ANALYZER_H
 
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <fstream>
+#include <thread>
+#include <variant>
+
+#include "arrow_ipc_writer.h"
+#include "csv_buffer.h"
+#include "output_stream.h"
+#include "spsc_queue.h"
+#include "zoom.h"
 
 namespace zoom {
     class analyzer {
@@ -13,18 +25,180 @@ namespace zoom {
         analyzer& operator=(const analyzer&) = delete;
         analyzer(analyzer&&) = default;
         analyzer& operator=(analyzer&&) = default;
+        ~analyzer();
+
+        //! resolutions of the rolled-up stats logs in seconds (see enable_stats_log())
+        static constexpr std::array<unsigned, 3> STATS_ROLLUP_RESOLUTIONS = {10, 60, 300};
+
+        //! sizes of the log files in Bytes, -1 if a log is disabled
+        struct log_positions {
+            std::int64_t pkt = -1, frame = -1, streams = -1, stats = -1;
+            std::array<std::int64_t, STATS_ROLLUP_RESOLUTIONS.size()> stats_rollups = {-1, -1, -1};
+        };
+
+        enum class log_format {
+            csv,
+            arrow //!< Arrow IPC file with typed columns, "NA" values become nulls
+        };
+
+        //! what the packet-processing thread does when the async log queue is full
+        enum class overflow_policy {
+            block, //!< wait for the writer thread (counted as a stall), no rows are lost
+            drop   //!< discard the row (counted as a drop)
+        };
+
+        //! counters of the async log writer, all 0 if async logs are disabled
+        struct async_log_stats {
+            std::size_t queue_len = 0;
+            std::size_t max_depth = 0; //!< sampled every 64 rows and on every full queue
+            std::uint64_t rows    = 0; //!< rows handed to the writer thread, incl. quantiles
+            std::uint64_t stalls  = 0;
+            std::uint64_t drops   = 0;
+        };
+
+        //! - append: continue an existing log (e.g., after restoring a checkpoint) without
+        //!   writing the CSV header again, Arrow IPC logs cannot be appended to
+        //! - CSV logs are gzip-compressed on a background thread if file_path ends in ".gz"
+        void enable_pkt_log(const std::string& file_path, bool append = false,
+                            log_format format = log_format::csv);
+        void enable_frame_log(const std::string& file_path, bool append = false,
+                              log_format format = log_format::csv);
+        void enable_streams_log(const std::string& file_path, bool append = false,
+                                log_format format = log_format::csv);
+
+        //! - resolution_s: 1 for the 1s stats or one of STATS_ROLLUP_RESOLUTIONS, each resolution
+        //!   is written to its own log and rolled up from the 1s stats whether or not their log
+        //!   is enabled, rows are reported once the interval (aligned to a multiple of the
+        //!   resolution, ts_s is its start) has passed
+        void enable_stats_log(const std::string& stats_path, bool append = false,
+                              log_format format = log_format::csv, unsigned resolution_s = 1);
+
+        //! formats and writes packet, frame and stats log rows on a background thread
+        //! - the packet-processing thread only copies each row as a binary record into a
+        //!   lock-free queue of queue_len (power of two) records, rows keep their order
+        //! - the analyzer must not be moved afterwards
+        void enable_async_logs(std::size_t queue_len = 1 << 14,
+                               overflow_policy policy = overflow_policy::block);
+
+        [[nodiscard]] async_log_stats async_stats() const;
+
+        //! adds the p50, p95 and p99 of the jitter, frame size, inter-frame gap and fps of the
+        //! frames of each interval to the stats logs and of each stream to the streams log
+        //! - must be called before the logs are enabled
+        void enable_quantiles();
+
+        //! quantiles of the frames of a stats or streams log row, -1 without frames
+        struct frame_quantiles {
+            static constexpr std::array<double, 3> QUANTILES = {0.5, 0.95, 0.99};
+
+            std::array<double, QUANTILES.size()> jitter_ms    = {-1, -1, -1};
+            std::array<double, QUANTILES.size()> frame_size   = {-1, -1, -1};
+            std::array<double, QUANTILES.size()> frame_gap_ms = {-1, -1, -1};
+            std::array<double, QUANTILES.size()> fps          = {-1, -1, -1};
+        };
+
+        //! frame log row
+        struct frame_row {
+            net::ipv4_5tuple ip_5t = {};
+            bool ipv6 = false;
+            unsigned rtp_ssrc = 0, rtp_ts = 0;
+            unsigned ts_min_s = 0, ts_min_us = 0, ts_max_s = 0, ts_max_us = 0;
+            unsigned pkts_seen = 0, pkts_hint = 0, frame_len = 0, fps = 0;
+            std::uint8_t pkt_type = 0;
+            std::uint8_t rtp_ext1[3] = {0, 0, 0};
+            double jitter = 0;
+        };
+
+        //! stats log row
+        struct stats_row {
+            zoom::media_stream_key key = {};
+            unsigned ts = 0, report_count = 0, resolution_s = 1;
+            unsigned long pkts = 0, bytes = 0, lost = 0, duplicate = 0, out_of_order = 0;
+            unsigned long frames = 0;
+            double mean_frame_len = 0, mean_jitter = 0;
+        };
+
+        //! streams log row
+        struct streams_row {
+            zoom::media_stream_key key = {};
+            timeval first_ts = {0, 0}, last_ts = {0, 0};
+            std::uint32_t first_rtp = 0, last_rtp = 0;
+            unsigned long pkts = 0, bytes = 0;
+        };
+
+        //! quantile columns of the stats or streams log row right before it, if enabled
+        //! - a record of its own, such that log_record stays as small as a packet log row
+        struct quantiles_row {
+            frame_quantiles quantiles;
+            unsigned resolution_s = 0; //!< of the stats log, 0 for the streams log
+        };
+
+        //! a row of any log, packet log rows are the zoom::pkt records themselves
+        using log_record = std::variant<zoom::pkt, frame_row, stats_row, streams_row,
+                                        quantiles_row>;
+
+        static_assert(sizeof(quantiles_row) <= sizeof(stats_row));
+
+        //! receives the rows of an analyzer instead of its logs (see forward_rows())
+        class row_sink {
+        public:
+            virtual ~row_sink() = default;
+            virtual void add(const log_record& record) = 0;
 
-        void enable_pkt_log(const std::string& file_path);
-        void enable_frame_log(const std::string& file_path);
-        void enable_streams_log(const std::string& file_path);
-        void enable_stats_log(const std::string& stats_path);
+            //! called before the rows of a stream that is retired or written to the streams
+            //! log, such that rows of several streams at once can be ordered by key
+            virtual void begin_stream(const zoom::media_stream_key& /*key*/) { }
+        };
+
+        //! hands the rows of the logs that are enabled in logs to sink instead of writing them
+        //! - the logs of this analyzer need not (and should not) be opened, packet log rows are
+        //!   not forwarded
+        //! - e.g., zoom::parallel_analyzer merges the rows of its workers this way
+        void forward_rows(row_sink* sink, const analyzer& logs);
+
+        //! flushes all enabled logs and returns their sizes
+        //! - compressed logs end a gzip member, such that they can be truncated to their size
+        //! - Arrow IPC logs are only complete once closed and always report -1
+        //! - with async logs, waits until the writer thread has written all queued rows
+        log_positions flush_logs();
 
     protected:
 
+        //! writes a row to its log, queues it for the writer thread if async logs are enabled
+        //! or hands it to the row sink if rows are forwarded
+        template <typename Row>
+        inline void _append(const Row& row) {
+
+            if (_async) {
+                _push(row);
+            } else if (_row_sink) {
+                _row_sink->add(row);
+            } else {
+                _write_row(row);
+            }
+        }
+
+        //! writes a row to its log right away
+        void _write_record(const log_record& record);
+
+        //! - rows are formatted into rows and only written to stream in large chunks, by
+        //!   end_row() once the buffer is full, flush(), close() or the destructor
+        //! - Arrow IPC logs are written by arrow instead, stream is unused
         struct _log {
-            void open(const std::string& file_path);
+            _log() = default;
+            _log(_log&&) = default;
+            _log& operator=(_log&&) = default;
+            ~_log();
+
+            void open(const std::string& file_path, bool append = false);
+            void open_arrow(const std::string& file_path,
+                            const std::vector<arrow_ipc_writer::column>& schema);
+            std::int64_t flush();
             bool enabled = false;
-            std::ofstream stream;
+            output_stream stream;
+            csv_buffer rows;
+            std::unique_ptr<arrow_ipc_writer> arrow;
+            void end_row();
             void close();
         };
 
@@ -32,6 +206,43 @@ namespace zoom {
         _log _frame_log;
         _log _streams_log;
         _log _stats_log;
+        std::array<_log, STATS_ROLLUP_RESOLUTIONS.size()> _stats_rollup_logs;
+
+        //! the log of the stats at resolution_s, throws std::invalid_argument if not supported
+        _log& _stats_log_at(unsigned resolution_s);
+
+        row_sink* _row_sink = nullptr;
+        bool _quantiles = false;
+
+    private:
+
+        struct _async_writer {
+            explicit _async_writer(std::size_t queue_len, overflow_policy policy)
+                : queue(queue_len), policy(policy) { }
+
+            spsc_queue<log_record> queue;
+            overflow_policy policy;
+            std::thread thread;
+            std::atomic<bool> stop = false;
+            std::atomic<std::uint64_t> rows_written = 0;
+            async_log_stats stats; // updated by the packet-processing thread only
+            bool dropped_last = false; // whether the previous row was dropped
+        };
+
+        void _push(const log_record& record);
+        void _run_async_writer();
+
+        //! waits until the writer thread has written all queued rows
+        void _drain_async();
+        void _stop_async();
+
+        void _write_row(const zoom::pkt& pkt);
+        void _write_row(const frame_row& row);
+        void _write_row(const stats_row& row);
+        void _write_row(const streams_row& row);
+        void _write_row(const quantiles_row& row);
+
+        std::unique_ptr<_async_writer> _async;
     };
 }
 
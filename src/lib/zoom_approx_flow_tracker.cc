@@ -0,0 +1,186 @@
+
+#include "pcap_util.h"
+#include "zoom_approx_flow_tracker.h"
+#include "zoom_nets.h"
+
+#include <algorithm>
+#include <cmath>
+
+zoom::approx_flow_tracker::config zoom::approx_flow_tracker::config::for_memory(
+    std::size_t bytes) {
+
+    config c;
+
+    c.peer_filter_cells = sketch::floor_power_of_two(
+        std::max<std::size_t>(bytes / 4 / sizeof(std::uint32_t), 1));
+
+    // two sketches (packets, bytes) with 64 bit counters share the remaining memory, a budget
+    // below the minimal peer filter leaves nothing for them
+    auto filter_bytes = c.peer_filter_cells * sizeof(std::uint32_t);
+    auto sketch_bytes = bytes > filter_bytes ? bytes - filter_bytes : 0;
+
+    c.sketch_width = sketch::floor_power_of_two(std::max<std::size_t>(
+        sketch_bytes / (2 * c.sketch_depth * sizeof(std::uint64_t)), 1));
+
+    return c;
+}
+
+void zoom::approx_flow_tracker::comparison::add(
+    const std::optional<flow_tracker::flow_stats>& exact,
+    const std::optional<flow_tracker::flow_stats>& approx) {
+
+    pkts++;
+
+    if (exact && approx) {
+        if (exact->type == approx->type) {
+            agree++;
+        } else {
+            type_mismatches++;
+        }
+    } else if (approx) {
+        false_positives++;
+    } else if (exact) {
+        false_negatives++;
+    } else {
+        agree++;
+    }
+}
+
+void zoom::approx_flow_tracker::comparison::add_counter_errors(const flow_tracker& exact,
+                                                               const approx_flow_tracker& approx) {
+
+    double pkts_err_sum = 0.0, bytes_err_sum = 0.0;
+
+    for (const auto& [ip_5t, stats]: exact.flows()) {
+
+        auto est = approx.estimate(ip_5t);
+
+        // in bidirectional mode, the exact tracker counts both directions in one entry
+        if (exact.bidirectional()) {
+            auto rev_est = approx.estimate(ip_5t.reversed());
+            est.pkts += rev_est.pkts, est.bytes += rev_est.bytes;
+        }
+
+        double pkts_err = stats.pkts ? std::abs((double) est.pkts - (double) stats.pkts)
+                                       / (double) stats.pkts : 0.0;
+        double bytes_err = stats.bytes ? std::abs((double) est.bytes - (double) stats.bytes)
+                                         / (double) stats.bytes : 0.0;
+
+        pkts_err_sum += pkts_err, bytes_err_sum += bytes_err;
+        max_pkts_rel_error = std::max(max_pkts_rel_error, pkts_err);
+        max_bytes_rel_error = std::max(max_bytes_rel_error, bytes_err);
+        flows++;
+    }
+
+    mean_pkts_rel_error = flows ? pkts_err_sum / (double) flows : 0.0;
+    mean_bytes_rel_error = flows ? bytes_err_sum / (double) flows : 0.0;
+}
+
+zoom::approx_flow_tracker::approx_flow_tracker(const config& c, unsigned stun_expiration)
+    : _stun_expiration(stun_expiration),
+      _p2p_peers(c.peer_filter_cells, c.peer_filter_hashes),
+      _pkts(c.sketch_width, c.sketch_depth),
+      _bytes(c.sketch_width, c.sketch_depth) { }
+
+std::optional<zoom::flow_tracker::flow_stats> zoom::approx_flow_tracker::track(
+    const net::ipv4_5tuple& ip_5t, const timeval& ts, unsigned bytes) {
+
+    _total_pkts_processed++;
+
+    // lazily expired peers still count towards the fill ratio, reset them periodically
+    if (ts.tv_sec >= _last_expiration_ts_s + _stun_expiration) {
+        _p2p_peers.expire(ts.tv_sec, _stun_expiration);
+        _last_expiration_ts_s = ts.tv_sec;
+    }
+
+    auto ft = _classify(ip_5t, ts);
+
+    if (!ft)
+        return std::nullopt;
+
+    flow_tracker::flow_stats fs;
+    fs.pkts = _pkts.add(ip_5t, 1);
+    fs.bytes = _bytes.add(ip_5t, bytes);
+    fs.start_ts = ts, fs.last_ts = ts;
+    fs.type = *ft;
+
+    _zoom_pkts_detected++;
+    _zoom_bytes_detected += bytes;
+    return fs;
+}
+
+std::optional<zoom::flow_tracker::flow_type> zoom::approx_flow_tracker::_classify(
+    const net::ipv4_5tuple& ip_5t, const timeval& ts) {
+
+    if (zoom::nets::match(ip_5t.ip_src) || zoom::nets::match(ip_5t.ip_dst)) {
+
+        if (_is_udp(ip_5t)) {
+
+            if (_is_stun_port(ip_5t.tp_src)) {
+                _p2p_peers.insert({ip_5t.ip_dst, ip_5t.tp_dst}, ts.tv_sec);
+                return flow_tracker::flow_type::udp_stun;
+            } else if (_is_stun_port(ip_5t.tp_dst)) {
+                _p2p_peers.insert({ip_5t.ip_src, ip_5t.tp_src}, ts.tv_sec);
+                return flow_tracker::flow_type::udp_stun;
+            }
+
+            return flow_tracker::flow_type::udp_srv;
+
+        } else if (_is_tcp(ip_5t)) {
+            return flow_tracker::flow_type::tcp;
+        }
+
+    } else if (_is_udp(ip_5t)) {
+
+        if (_p2p_peers.contains_and_refresh({ip_5t.ip_src, ip_5t.tp_src}, ts.tv_sec,
+                                            _stun_expiration)
+            || _p2p_peers.contains_and_refresh({ip_5t.ip_dst, ip_5t.tp_dst}, ts.tv_sec,
+                                               _stun_expiration)) {
+
+            return flow_tracker::flow_type::udp_p2p;
+        }
+    }
+
+    return std::nullopt;
+}
+
+zoom::flow_tracker::flow_stats zoom::approx_flow_tracker::estimate(
+    const net::ipv4_5tuple& ip_5t) const {
+
+    flow_tracker::flow_stats fs;
+    fs.pkts = _pkts.estimate(ip_5t);
+    fs.bytes = _bytes.estimate(ip_5t);
+    return fs;
+}
+
+unsigned long long zoom::approx_flow_tracker::count_total_pkts_processed() const {
+    return _total_pkts_processed;
+}
+
+unsigned long long zoom::approx_flow_tracker::count_zoom_pkts_detected() const {
+    return _zoom_pkts_detected;
+}
+
+unsigned long long zoom::approx_flow_tracker::count_zoom_bytes_detected() const {
+    return _zoom_bytes_detected;
+}
+
+std::size_t zoom::approx_flow_tracker::memory_bytes() const {
+    return _p2p_peers.memory_bytes() + _pkts.memory_bytes() + _bytes.memory_bytes();
+}
+
+double zoom::approx_flow_tracker::peer_filter_false_positive_rate() const {
+    return _p2p_peers.false_positive_rate();
+}
+
+double zoom::approx_flow_tracker::pkts_error_bound() const {
+    return _pkts.error_bound();
+}
+
+double zoom::approx_flow_tracker::bytes_error_bound() const {
+    return _bytes.error_bound();
+}
+
+double zoom::approx_flow_tracker::error_bound_confidence() const {
+    return _pkts.confidence();
+}
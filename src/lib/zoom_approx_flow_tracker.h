@@ -0,0 +1,107 @@
+
+#ifndef ZOOM_ANALYSIS_ZOOM_APPROX_FLOW_TRACKER_H
+#define ZOOM_ANALYSIS_ZOOM_APPROX_FLOW_TRACKER_H
+
+#include "net.h"
+#include "sketches.h"
+#include "zoom_flow_tracker.h"
+
+#include <ctime>
+#include <optional>
+
+namespace zoom {
+
+    /*!
+     * Fixed-memory variant of zoom::flow_tracker
+     *
+     * - classifies every packet without per-flow state (like p4/src/zoom_capture.p4)
+     * - remembers P2P peers learned through STUN in an aging Bloom filter
+     * - estimates per-flow packet and byte counts with count-min sketches
+     * - results of track() have id == 0 and start_ts == last_ts == ts since flows are not stored
+     */
+    class approx_flow_tracker {
+
+    public:
+
+        struct config {
+            std::size_t peer_filter_cells = 1 << 16;
+            unsigned peer_filter_hashes   = 3;
+            std::size_t sketch_width      = 1 << 14;
+            unsigned sketch_depth         = 4;
+
+            //! splits a memory budget between the peer filter (1/4) and the counter sketches
+            static config for_memory(std::size_t bytes);
+        };
+
+        //! compares an approx_flow_tracker with a flow_tracker that is fed the same packets
+        struct comparison {
+            unsigned long long pkts                = 0;
+            unsigned long long agree               = 0;
+            unsigned long long false_positives     = 0;
+            unsigned long long false_negatives     = 0;
+            unsigned long long type_mismatches     = 0;
+
+            unsigned long flows                    = 0;
+            double mean_pkts_rel_error             = 0.0;
+            double max_pkts_rel_error              = 0.0;
+            double mean_bytes_rel_error            = 0.0;
+            double max_bytes_rel_error             = 0.0;
+
+            //! compares the classification of a single packet
+            void add(const std::optional<flow_tracker::flow_stats>& exact,
+                     const std::optional<flow_tracker::flow_stats>& approx);
+
+            //! compares the counter estimates of all flows tracked by exact
+            void add_counter_errors(const flow_tracker& exact, const approx_flow_tracker& approx);
+        };
+
+        explicit approx_flow_tracker(const config& c, unsigned stun_expiration = 300);
+
+        approx_flow_tracker(const approx_flow_tracker&) = default;
+        approx_flow_tracker& operator=(const approx_flow_tracker&) = default;
+
+        std::optional<flow_tracker::flow_stats> track(const net::ipv4_5tuple& ip_5t,
+                                                      const timeval& ts, unsigned bytes);
+
+        //! returns the estimated packet and byte counts of a flow
+        [[nodiscard]] flow_tracker::flow_stats estimate(const net::ipv4_5tuple& ip_5t) const;
+
+        unsigned long long count_total_pkts_processed() const;
+        unsigned long long count_zoom_pkts_detected() const;
+        unsigned long long count_zoom_bytes_detected() const;
+
+        [[nodiscard]] std::size_t memory_bytes() const;
+        [[nodiscard]] double peer_filter_false_positive_rate() const;
+        [[nodiscard]] double pkts_error_bound() const;
+        [[nodiscard]] double bytes_error_bound() const;
+        [[nodiscard]] double error_bound_confidence() const;
+
+    private:
+
+        inline static bool _is_tcp(const net::ipv4_5tuple& ip_5t) {
+            return ip_5t.ip_proto == 6;
+        }
+
+        inline static bool _is_udp(const net::ipv4_5tuple& ip_5t) {
+            return ip_5t.ip_proto == 17;
+        }
+
+        inline static bool _is_stun_port(uint16_t p) {
+            return p == 3478 || p == 3479;
+        }
+
+        std::optional<flow_tracker::flow_type> _classify(const net::ipv4_5tuple& ip_5t,
+                                                         const timeval& ts);
+
+        unsigned _stun_expiration = 300;
+        long _last_expiration_ts_s = 0;
+        aging_bloom_filter<net::ipv4_port> _p2p_peers;
+        count_min_sketch<net::ipv4_5tuple> _pkts;
+        count_min_sketch<net::ipv4_5tuple> _bytes;
+        unsigned long long _total_pkts_processed = 0;
+        unsigned long long _zoom_pkts_detected = 0;
+        unsigned long long _zoom_bytes_detected = 0;
+    };
+}
+
+#endif
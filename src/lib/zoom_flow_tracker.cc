@@ -19,41 +19,67 @@ bool zoom::flow_tracker::flow_stats::is_p2p() const {
     return type == flow_type::udp_p2p;
 }
 
-zoom::flow_tracker::flow_tracker(unsigned int stun_expiration)
-    : _stun_expiration(stun_expiration) { }
+zoom::flow_tracker::flow_tracker(unsigned int stun_expiration, bool bidirectional)
+    : _stun_expiration(stun_expiration), _bidirectional(bidirectional) { }
 
 std::optional<zoom::flow_tracker::flow_stats> zoom::flow_tracker::track(
     const net::ipv4_5tuple& ip_5t, const timeval& ts, unsigned bytes) {
 
+    return _track(ip_5t, ts, bytes, _flows, _p2p_peers);
+}
+
+std::optional<zoom::flow_tracker::flow_stats> zoom::flow_tracker::track(
+    const net::ipv6_5tuple& ip_5t, const timeval& ts, unsigned bytes) {
+
+    return _track(ip_5t, ts, bytes, _flows6, _p2p_peers6);
+}
+
+template <typename FiveTuple, typename Port>
+std::optional<zoom::flow_tracker::flow_stats> zoom::flow_tracker::_track(
+    const FiveTuple& ip_5t, const timeval& ts, unsigned bytes,
+    std::unordered_map<FiveTuple, flow_stats>& flows, std::unordered_map<Port, long>& p2p_peers) {
+
     _total_pkts_processed++;
 
-    auto flows_it = _flows.find(ip_5t);
+    // in bidirectional mode, packets in reverse direction of the canonical key are swapped
+    bool swapped = _bidirectional && !ip_5t.is_canonical();
+    auto flows_it = flows.find(swapped ? ip_5t.reversed() : ip_5t);
 
-    if (flows_it != _flows.end()) { // flow has been seen before
+    if (flows_it != flows.end()) { // flow has been seen before
 
         auto& stats = flows_it->second;
+        auto dir = swapped ? _reverse(stats.dir) : stats.dir;
 
         stats.pkts += 1, stats.bytes += bytes;
+        _count(stats, dir, bytes);
 
         if (ts > stats.last_ts)
             stats.last_ts = ts;
 
         _zoom_pkts_detected++;
         _zoom_bytes_detected += bytes;
-        return flows_it->second;
+
+        auto fs = stats;
+        fs.dir = dir;
+        return fs;
 
     } else { // flows has not yet been seen
 
         auto ft = flow_type::unknown;
+        auto dir = flow_dir::unknown;
 
-        if (zoom::nets::match(ip_5t.ip_src) || zoom::nets::match(ip_5t.ip_dst)) {
+        bool srv_dst = zoom::nets::match(ip_5t.ip_dst);
+
+        if (srv_dst || zoom::nets::match(ip_5t.ip_src)) {
             // flow is going to / coming from zoom server
 
+            dir = srv_dst ? flow_dir::to_srv : flow_dir::from_srv;
+
             if (_is_udp(ip_5t)) {
 
                 if (_is_stun_port(ip_5t.tp_src) || _is_stun_port(ip_5t.tp_dst)) {
 
-                    net::ipv4_port p2p_local_peer;
+                    Port p2p_local_peer;
 
                     if (_is_stun_port(ip_5t.tp_src)) {
                         p2p_local_peer = {ip_5t.ip_dst, ip_5t.tp_dst};
@@ -61,10 +87,10 @@ std::optional<zoom::flow_tracker::flow_stats> zoom::flow_tracker::track(
                         p2p_local_peer = {ip_5t.ip_src, ip_5t.tp_src};
                     }
 
-                    auto p2p_peers_it = _p2p_peers.find(p2p_local_peer);
+                    auto p2p_peers_it = p2p_peers.find(p2p_local_peer);
 
-                    if (p2p_peers_it == _p2p_peers.end()) {
-                        _p2p_peers.insert({p2p_local_peer, ts.tv_sec});
+                    if (p2p_peers_it == p2p_peers.end()) {
+                        p2p_peers.insert({p2p_local_peer, ts.tv_sec});
                     } else {
                         p2p_peers_it->second = ts.tv_sec;
                     }
@@ -85,18 +111,20 @@ std::optional<zoom::flow_tracker::flow_stats> zoom::flow_tracker::track(
 
             if (_is_udp(ip_5t)) {
 
-                auto _p2p_peers_src_it = _p2p_peers.find({ip_5t.ip_src, ip_5t.tp_src});
-                auto _p2p_peers_dst_it = _p2p_peers.find({ip_5t.ip_dst, ip_5t.tp_dst});
+                auto _p2p_peers_src_it = p2p_peers.find({ip_5t.ip_src, ip_5t.tp_src});
+                auto _p2p_peers_dst_it = p2p_peers.find({ip_5t.ip_dst, ip_5t.tp_dst});
 
-                if (_p2p_peers_src_it != _p2p_peers.end()
+                if (_p2p_peers_src_it != p2p_peers.end()
                     && ts.tv_sec <= _p2p_peers_src_it->second + _stun_expiration) {
 
                     ft = flow_type::udp_p2p;
+                    dir = flow_dir::to_srv;
 
-                } else if (_p2p_peers_dst_it != _p2p_peers.end()
+                } else if (_p2p_peers_dst_it != p2p_peers.end()
                            && ts.tv_sec <= _p2p_peers_dst_it->second + _stun_expiration) {
 
                     ft = flow_type::udp_p2p;
+                    dir = flow_dir::from_srv;
                 } else {
                     return std::nullopt;
                 }
@@ -105,8 +133,17 @@ std::optional<zoom::flow_tracker::flow_stats> zoom::flow_tracker::track(
             }
         }
 
-        flow_stats fs{_next_id++, 1, bytes, ts, ts, ft };
-        _flows.insert(std::make_pair(ip_5t, fs));
+        flow_stats fs{_next_id++, 1, bytes, ts, ts, ft, dir };
+        _count(fs, dir, bytes);
+
+        if (swapped) {
+            auto key_fs = fs;
+            key_fs.dir = _reverse(dir);
+            flows.insert(std::make_pair(ip_5t.reversed(), key_fs));
+        } else {
+            flows.insert(std::make_pair(ip_5t, fs));
+        }
+
         _zoom_pkts_detected++;
         return fs;
     }
@@ -128,8 +165,83 @@ unsigned long long zoom::flow_tracker::count_zoom_bytes_detected() const {
     return _zoom_bytes_detected;
 }
 
+bool zoom::flow_tracker::bidirectional() const {
+    return _bidirectional;
+}
+
 const std::unordered_map<net::ipv4_5tuple, zoom::flow_tracker::flow_stats>&
     zoom::flow_tracker::flows() const {
 
     return _flows;
 }
+
+const std::unordered_map<net::ipv6_5tuple, zoom::flow_tracker::flow_stats>&
+    zoom::flow_tracker::flows6() const {
+
+    return _flows6;
+}
+
+void zoom::flow_tracker::save(checkpoint::writer& w) const {
+
+    w.write(_next_id), w.write(_stun_expiration), w.write(_bidirectional);
+    w.write(_total_pkts_processed), w.write(_zoom_pkts_detected), w.write(_zoom_bytes_detected);
+
+    w.write((std::uint64_t) _flows.size());
+
+    for (const auto& [ip_5t, stats]: _flows) {
+        w.write(ip_5t), w.write(stats);
+    }
+
+    w.write((std::uint64_t) _p2p_peers.size());
+
+    for (const auto& [peer, ts_s]: _p2p_peers) {
+        w.write(peer), w.write(ts_s);
+    }
+
+    w.write((std::uint64_t) _flows6.size());
+
+    for (const auto& [ip_5t, stats]: _flows6) {
+        w.write(ip_5t), w.write(stats);
+    }
+
+    w.write((std::uint64_t) _p2p_peers6.size());
+
+    for (const auto& [peer, ts_s]: _p2p_peers6) {
+        w.write(peer), w.write(ts_s);
+    }
+}
+
+void zoom::flow_tracker::restore(checkpoint::reader& r) {
+
+    r.read(_next_id), r.read(_stun_expiration);
+
+    if (r.read<bool>() != _bidirectional)
+        throw std::runtime_error("flow_tracker: checkpoint was taken in another mode");
+
+    r.read(_total_pkts_processed), r.read(_zoom_pkts_detected), r.read(_zoom_bytes_detected);
+
+    _flows.clear();
+    _p2p_peers.clear();
+    _flows6.clear();
+    _p2p_peers6.clear();
+
+    for (auto n = r.read<std::uint64_t>(); n > 0; n--) {
+        auto ip_5t = r.read<net::ipv4_5tuple>();
+        _flows.insert({ip_5t, r.read<flow_stats>()});
+    }
+
+    for (auto n = r.read<std::uint64_t>(); n > 0; n--) {
+        auto peer = r.read<net::ipv4_port>();
+        _p2p_peers.insert({peer, r.read<long>()});
+    }
+
+    for (auto n = r.read<std::uint64_t>(); n > 0; n--) {
+        auto ip_5t = r.read<net::ipv6_5tuple>();
+        _flows6.insert({ip_5t, r.read<flow_stats>()});
+    }
+
+    for (auto n = r.read<std::uint64_t>(); n > 0; n--) {
+        auto peer = r.read<net::ipv6_port>();
+        _p2p_peers6.insert({peer, r.read<long>()});
+    }
+}
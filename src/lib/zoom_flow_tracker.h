@@ -2,6 +2,7 @@
 #ifndef ZOOM_ANALYSIS_ZOOM_FLOW_TRACKER_H
 #define ZOOM_ANALYSIS_ZOOM_FLOW_TRACKER_H
 
+#include "checkpoint.h"
 #include "net.h"
 
 #include <ctime>
@@ -24,12 +25,28 @@ namespace zoom {
             udp_p2p  = 4
         };
 
+        //! direction relative to the Zoom server
+        //! - for P2P flows, the remote peer takes the place of the server, i.e., to_srv refers
+        //!   to packets sent by the local peer that was registered through STUN
+        enum class flow_dir : unsigned {
+            unknown  = 0,
+            to_srv   = 1,
+            from_srv = 2
+        };
+
         struct flow_stats {
             unsigned id = 0;
             unsigned long pkts = 0, bytes = 0;
             timeval start_ts = { 0, 0 }, last_ts = { 0, 0 };
             flow_type type = flow_type::unknown;
 
+            //! direction of the tracked packet (for results of track()) or of the 5-tuple key
+            //! (for entries in flows())
+            flow_dir dir = flow_dir::unknown;
+
+            unsigned long pkts_to_srv = 0, bytes_to_srv = 0;
+            unsigned long pkts_from_srv = 0, bytes_from_srv = 0;
+
             [[nodiscard]] bool is_udp() const;
             [[nodiscard]] bool is_stun() const;
             [[nodiscard]] bool is_tcp() const;
@@ -46,7 +63,18 @@ namespace zoom {
             }
         }
 
-        explicit flow_tracker(unsigned stun_expiration = 300);
+        static std::string flow_dir_string(const flow_dir& fd) {
+            switch (fd) {
+                case flow_dir::to_srv:   return "to_srv";
+                case flow_dir::from_srv: return "from_srv";
+                default:                 return "unknown";
+            }
+        }
+
+        //! - in bidirectional mode, both directions of a conversation share a single entry keyed
+        //!   by the canonical 5-tuple (see net::ipv4_5tuple::canonical()), with per-direction
+        //!   packet and byte counters
+        explicit flow_tracker(unsigned stun_expiration = 300, bool bidirectional = false);
 
         flow_tracker(const flow_tracker&) = default;
         flow_tracker& operator=(const flow_tracker&) = default;
@@ -54,20 +82,36 @@ namespace zoom {
         std::optional<flow_stats> track(const net::ipv4_5tuple& ip_5t, const timeval& ts,
                                         unsigned bytes);
 
+        //! - IPv6 flows are matched against zoom::nets::match(const net::ipv6::addr&) and kept
+        //!   in a separate table, flow ids and counters are shared with IPv4 flows
+        std::optional<flow_stats> track(const net::ipv6_5tuple& ip_5t, const timeval& ts,
+                                        unsigned bytes);
+
         unsigned count_zoom_flows_detected() const;
         unsigned long long count_total_pkts_processed() const;
         unsigned long long count_zoom_pkts_detected() const;
         unsigned long long count_zoom_bytes_detected() const;
+        bool bidirectional() const;
 
         const std::unordered_map<net::ipv4_5tuple, flow_stats>& flows() const;
+        const std::unordered_map<net::ipv6_5tuple, flow_stats>& flows6() const;
+
+        //! writes flows, P2P peers and counters to a checkpoint
+        void save(checkpoint::writer& w) const;
+
+        //! replaces the state of this tracker with a checkpoint written by save()
+        //! - throws std::runtime_error if the checkpoint was taken in another (bidirectional) mode
+        void restore(checkpoint::reader& r);
 
     private:
 
-        inline static bool _is_tcp(const net::ipv4_5tuple& ip_5t) {
+        template <typename FiveTuple>
+        inline static bool _is_tcp(const FiveTuple& ip_5t) {
             return ip_5t.ip_proto == 6;
         }
 
-        inline static bool _is_udp(const net::ipv4_5tuple& ip_5t) {
+        template <typename FiveTuple>
+        inline static bool _is_udp(const FiveTuple& ip_5t) {
             return ip_5t.ip_proto == 17;
         }
 
@@ -75,10 +119,35 @@ namespace zoom {
             return p == 3478 || p == 3479;
         }
 
+        inline static flow_dir _reverse(flow_dir d) {
+            switch (d) {
+                case flow_dir::to_srv:   return flow_dir::from_srv;
+                case flow_dir::from_srv: return flow_dir::to_srv;
+                default:                 return flow_dir::unknown;
+            }
+        }
+
+        inline static void _count(flow_stats& stats, flow_dir d, unsigned bytes) {
+            if (d == flow_dir::to_srv) {
+                stats.pkts_to_srv += 1, stats.bytes_to_srv += bytes;
+            } else if (d == flow_dir::from_srv) {
+                stats.pkts_from_srv += 1, stats.bytes_from_srv += bytes;
+            }
+        }
+
+        //! shared implementation of track() for IPv4 and IPv6 flow tables
+        template <typename FiveTuple, typename Port>
+        std::optional<flow_stats> _track(const FiveTuple& ip_5t, const timeval& ts, unsigned bytes,
+                                         std::unordered_map<FiveTuple, flow_stats>& flows,
+                                         std::unordered_map<Port, long>& p2p_peers);
+
         unsigned _next_id = 0;
         unsigned _stun_expiration = 300;
+        bool _bidirectional = false;
         std::unordered_map<net::ipv4_5tuple, flow_stats> _flows = {};
         std::unordered_map<net::ipv4_port, long> _p2p_peers = {};
+        std::unordered_map<net::ipv6_5tuple, flow_stats> _flows6 = {};
+        std::unordered_map<net::ipv6_port, long> _p2p_peers6 = {};
         unsigned long long _total_pkts_processed = 0;
         unsigned long long _zoom_pkts_detected = 0;
         unsigned long long _zoom_bytes_detected = 0;
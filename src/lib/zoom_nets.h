@@ -5,6 +5,10 @@
 #include "net.h"
 
 #include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
 namespace zoom {
@@ -22,6 +26,47 @@ namespace zoom {
             return false;
         }
 
+        static bool match(const net::ipv6::addr& ip) {
+
+            return std::any_of(NETS6.begin(), NETS6.end(), [&ip](const auto& ip_mask) {
+                return ip_mask.match(ip);
+            });
+        }
+
+        //! adds IPv6 prefixes in CIDR notation (one per line, # starts a comment) from a file
+        //! - throws std::runtime_error if the file cannot be read or contains an invalid prefix
+        static void load_ipv6_nets(const std::string& file_name) {
+
+            std::ifstream is(file_name);
+            std::string line;
+
+            if (!is.is_open())
+                throw std::runtime_error("nets: could not open " + file_name);
+
+            while (std::getline(is, line)) {
+
+                line = line.substr(0, line.find('#'));
+                line.erase(std::remove_if(line.begin(), line.end(), [](unsigned char c) {
+                    return std::isspace(c);
+                }), line.end());
+
+                if (line.empty())
+                    continue;
+
+                try {
+                    NETS6.push_back(net::ipv6_mask::from_str(line));
+                } catch (const std::exception&) {
+                    throw std::runtime_error("nets: invalid ipv6 prefix " + line + " in "
+                                             + file_name);
+                }
+            }
+        }
+
+        // Zoom does not publish a stable list of IPv6 server prefixes, the list starts out empty
+        // and is filled by load_ipv6_nets(), e.g., from the -6 option of zoom_flows
+
+        static inline std::vector<net::ipv6_mask> NETS6 = {};
+
         // addresses taken from:
         // https://support.zoom.us/hc/en-us/articles/
         //   201362683-Network-firewall-or-proxy-server-settings-for-Zoom
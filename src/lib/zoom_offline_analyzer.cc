@@ -1,217 +1,372 @@
+#include <algorithm>
+#include <stdexcept>
+
 #include "zoom_offline_analyzer.h"
 
+namespace {
+
+    //! the quantiles of frame_sketches of a stream analyzer, all -1 without sketches
+    template <typename Sketches>
+    zoom::analyzer::frame_quantiles to_quantiles(const Sketches* s) {
+
+        zoom::analyzer::frame_quantiles q;
+
+        if (!s)
+            return q;
+
+        const auto& quantiles = zoom::analyzer::frame_quantiles::QUANTILES;
+
+        for (std::size_t i = 0; i < quantiles.size(); i++) {
+            q.jitter_ms[i]    = s->jitter_ms.quantile(quantiles[i]);
+            q.frame_size[i]   = s->frame_size.quantile(quantiles[i]);
+            q.frame_gap_ms[i] = s->frame_gap_ms.quantile(quantiles[i]);
+            q.fps[i]          = s->fps.quantile(quantiles[i]);
+        }
+
+        return q;
+    }
+}
+
 void zoom::offline_analyzer::add(const zoom::pkt& pkt) {
 
     _pkts_processed++;
 
+    if (_idle_timeout_s && pkt.ts.s >= _next_idle_check_s) {
+        retire_idle_streams(pkt.ts.s, _idle_timeout_s);
+        _next_idle_check_s = pkt.ts.s + 1;
+    }
+
     if (_pkt_log.enabled) {
-        _write_pkt_log(pkt);
+        _append(pkt);
     }
 
     if (pkt.flags.rtp) {
 
         auto key = zoom::media_stream_key::from_pkt(pkt);
 
-        auto streams_it = _media_streams.find(key);
+        _with_streams(key.media_type, [&](auto& ms) {
 
-        if (streams_it == _media_streams.end()) {
+            if (ms.last == NO_STREAM || !(ms.streams.key(ms.last) == key))
+                ms.last = ms.streams.find(key);
 
-            if ((streams_it = _insert_new_stream(key, pkt)) == _media_streams.end()) {
-                std::cerr << "error: failed setting up stream state, exiting." << std::endl;
-                return;
+            if (ms.last == NO_STREAM) {
+
+                // use 8,000 kHz for audio, 90,000 kHz for video
+                auto sampling_rate = pkt.zoom_media_type == 15 ? 8000 : 90000;
+
+                if ((ms.last = _insert_new_stream(key, sampling_rate)) == NO_STREAM) {
+                    std::cerr << "error: failed setting up stream state, exiting." << std::endl;
+                    return;
+                }
             }
-        }
 
-        timeval tv{pkt.ts.s, (int) pkt.ts.us};
+            timeval tv{pkt.ts.s, (int) pkt.ts.us};
 
-        streams_it->second.analyzer.add(
-            pkt.proto.rtp.seq, pkt.proto.rtp.ts, tv, pkt.udp_pl_len, {
-                .rtp_ext1 = { pkt.rtp_ext1[0], pkt.rtp_ext1[1], pkt.rtp_ext1[2] },
-                .pkt_type = pkt.zoom_media_type,
-                .pkts_hint = pkt.pkts_in_frame
+            ms.streams[ms.last].analyzer.add(
+                pkt.proto.rtp.seq, pkt.proto.rtp.ts, tv, pkt.udp_pl_len, {
+                    .rtp_ext1 = { pkt.rtp_ext1[0], pkt.rtp_ext1[1], pkt.rtp_ext1[2] },
+                    .pkt_type = pkt.zoom_media_type,
+                    .pkts_hint = pkt.pkts_in_frame
+            });
         });
     }
 }
 
-zoom::offline_analyzer::media_streams_map::iterator zoom::offline_analyzer::_insert_new_stream(
-        const zoom::media_stream_key& stream_key, const zoom::pkt& pkt) {
+void zoom::offline_analyzer::enable_rfc3550_jitter() {
+
+    if (_pkts_processed)
+        throw std::logic_error("zoom::offline_analyzer: the jitter calculator must be selected "
+                               "before the first packet");
+
+    _rfc3550_jitter = true;
+}
 
-    // auto stream_meta = zoom::media_stream_meta::from_pkt(pkt);
+std::size_t zoom::offline_analyzer::active_streams() const {
 
-    auto frame_handler = [this](const auto& analyzer, const auto& frame) {
-        _frame_handler(analyzer, frame);
-    };
+    std::size_t streams = 0;
+    _for_each_streams([&](const auto& ms) { streams += ms.streams.size(); });
+    return streams;
+}
 
-    auto stats_handler = [this](const auto& analyzer, unsigned report_count,
-                                unsigned ts, const auto& stats) -> void {
+std::array<zoom::offline_analyzer::stream_memory, 3> zoom::offline_analyzer::memory_usage() const {
 
-        _stats_handler(analyzer, report_count, ts, stats);
-    };
+    std::array<stream_memory, 3> usage;
+    std::size_t i = 0;
 
-    // use 8,000 kHz for audio, 90,000 kHz for video
-    auto sampling_rate = pkt.zoom_media_type == 15 ? 8000 : 90000;
+    _for_each_streams([&](const auto& ms) {
 
-    stream_analyzer analyzer(frame_handler, stats_handler, sampling_rate, stream_key);
+        using media_streams = std::decay_t<decltype(ms)>;
 
-    const auto &[it, success] = _media_streams.emplace(stream_key, stream_data{
-        .analyzer = std::move(analyzer)
+        usage[i++] = {
+            .ring_len     = media_streams::RING_LEN,
+            .streams      = ms.streams.size(),
+            .stream_bytes = sizeof(typename media_streams::data),
+            .bytes        = ms.streams.bytes()
+        };
     });
 
-    return success ? it : _media_streams.end();
+    return usage;
 }
 
-void zoom::offline_analyzer::_frame_handler(const stream_analyzer& a,
-                                            const struct stream_analyzer::frame& f) {
+zoom::offline_analyzer::stream_handle zoom::offline_analyzer::_insert_new_stream(
+        const zoom::media_stream_key& stream_key, unsigned sampling_rate) {
+
+    return _with_streams(stream_key.media_type, [&](auto& ms) {
+
+        using media_streams = std::decay_t<decltype(ms)>;
+
+        decltype(media_streams::data::analyzer) analyzer(stream_sink{this}, sampling_rate,
+                                                         stream_key);
+
+        if (_quantiles)
+            analyzer.enable_quantiles();
+
+        const auto [h, success] = ms.streams.emplace(
+            stream_key, typename media_streams::data{.analyzer = std::move(analyzer)});
+
+        return success ? h : NO_STREAM;
+    });
+}
+
+std::vector<zoom::offline_analyzer::stream_ref> zoom::offline_analyzer::_sorted_streams() const {
+
+    std::vector<stream_ref> streams;
+    streams.reserve(active_streams());
+
+    _for_each_streams([&](const auto& ms) {
+        for (auto h: ms.streams.handles())
+            streams.push_back({ms.streams.key(h), h});
+    });
+
+    std::sort(streams.begin(), streams.end(), [](const auto& a, const auto& b) {
+        return a.key < b.key;
+    });
+
+    return streams;
+}
+
+void zoom::offline_analyzer::save(checkpoint::writer& w) const {
+
+    w.write(_pkts_processed);
+    w.write(_rfc3550_jitter);
+    w.write(_quantiles);
+    w.write((std::uint64_t) active_streams());
+
+    for (const auto& s: _sorted_streams()) {
+        w.write(s.key);
+        _with_streams(s.key.media_type, [&](const auto& ms) { ms.streams[s.h].analyzer.save(w); });
+    }
+}
+
+void zoom::offline_analyzer::restore(checkpoint::reader& r) {
+
+    r.read(_pkts_processed);
+
+    if (r.read<bool>() != _rfc3550_jitter)
+        throw std::runtime_error("zoom::offline_analyzer: checkpoint was taken with the other "
+                                 "jitter calculator");
+
+    if (r.read<bool>() != _quantiles)
+        throw std::runtime_error(_quantiles
+            ? "zoom::offline_analyzer: checkpoint was taken without quantiles"
+            : "zoom::offline_analyzer: checkpoint was taken with quantiles");
+
+    auto clear = [](auto&... ms) { ((ms.streams.clear(), ms.last = NO_STREAM), ...); };
+    std::apply(clear, _media_streams);
+    std::apply(clear, _rfc3550_media_streams);
+
+    _next_idle_check_s = 0;
+
+    for (auto n = r.read<std::uint64_t>(); n > 0; n--) {
+
+        auto key = r.read<zoom::media_stream_key>();
+        auto h = _insert_new_stream(key, 90000);
+
+        if (h == NO_STREAM)
+            throw std::runtime_error("zoom::offline_analyzer: duplicate stream in checkpoint");
+
+        // restores the sampling rate along with the jitter calculator
+        _with_streams(key.media_type, [&](auto& ms) { ms.streams[h].analyzer.restore(r); });
+    }
+}
+
+template <typename Analyzer, typename Frame>
+void zoom::offline_analyzer::_frame_handler(const Analyzer& a, const Frame& f) {
 
     if (_frame_log.enabled)
         _write_frame_log(a, f);
 }
 
-void zoom::offline_analyzer::_stats_handler(const stream_analyzer& a, unsigned report_count,
-                                            unsigned ts, const struct stream_analyzer::stats& c) {
+template <typename Analyzer, typename Stats>
+void zoom::offline_analyzer::_stats_handler(const Analyzer& a, unsigned report_count,
+                                            unsigned ts, const Stats& c) {
 
     if (_stats_log.enabled)
-        _write_stats_log(a.meta(), report_count, ts, c);
+        _write_stats_log(a.meta(), 1, report_count, ts, c, a.reported_sketches(1));
+}
+
+template <typename Analyzer, typename Stats>
+void zoom::offline_analyzer::_rollup_handler(const Analyzer& a, unsigned resolution_s,
+                                             unsigned report_count, unsigned ts, const Stats& c) {
+
+    if (_stats_log_at(resolution_s).enabled)
+        _write_stats_log(a.meta(), resolution_s, report_count, ts, c,
+                         a.reported_sketches(resolution_s));
 }
 
 void zoom::offline_analyzer::write_streams_log() {
 
-    _streams_log.stream << "rtp_ssrc,media_type,stream_type,ip_src,tp_src,ip_dst,tp_dst,"
-                        << "start_ts_s,start_ts_us,end_ts_s,end_ts_us,start_rtp_ts,end_rtp_ts,"
-                        << "pkts,bytes" << std::endl;
+    for (const auto& s: _sorted_streams()) {
+
+        if (_row_sink)
+            _row_sink->begin_stream(s.key);
+
+        _with_streams(s.key.media_type, [&](const auto& ms) {
+            _write_streams_row(s.key, ms.streams[s.h]);
+        });
+    }
+}
+
+void zoom::offline_analyzer::set_idle_timeout(unsigned timeout_s) {
+
+    _idle_timeout_s = timeout_s;
+    _next_idle_check_s = 0;
+}
 
-    for (const auto& [key, data]: _media_streams) {
+void zoom::offline_analyzer::retire_streams() {
 
-        _streams_log.stream
-            << key.rtp_ssrc << ","
-            << zoom::media_type_to_char(key.media_type) << ","
-            << zoom::stream_type_to_char(key.stream_type) << ","
+    for (const auto& s: _sorted_streams())
+        _retire_stream(s);
+}
 
-            << net::ipv4::addr_to_str(key.ip_5t.ip_src) << ","
-            << key.ip_5t.tp_src << ","
-            << net::ipv4::addr_to_str(key.ip_5t.ip_dst) << ","
-            << key.ip_5t.tp_dst << ","
+void zoom::offline_analyzer::flush_stats() {
 
-            << data.analyzer.timestamps().first_timeval.tv_sec << ","
-            << data.analyzer.timestamps().first_timeval.tv_usec << ","
-            << data.analyzer.timestamps().last_timeval.tv_sec << ","
-            << data.analyzer.timestamps().last_timeval.tv_usec << ","
+    for (const auto& s: _sorted_streams()) {
 
-            << data.analyzer.timestamps().first_rtp << ","
-            << data.analyzer.timestamps().last_rtp << ","
+        if (_row_sink)
+            _row_sink->begin_stream(s.key);
 
-            << data.analyzer.stats().total_pkts << ","
-            << data.analyzer.stats().total_bytes
-            << std::endl;
+        _with_streams(s.key.media_type, [&](auto& ms) { ms.streams[s.h].analyzer.flush_stats(); });
     }
 }
 
-void zoom::offline_analyzer::_write_pkt_log(const zoom::pkt& pkt) {
+void zoom::offline_analyzer::retire_idle_streams(unsigned now_s, unsigned timeout_s) {
 
-    _pkt_log.stream << std::dec<< pkt.ts.s << "," << pkt.ts.us << ",u,";
+    std::vector<stream_ref> idle;
 
-    if (pkt.flags.srv) {
-        _pkt_log.stream << "s,";
-    } else if (pkt.flags.p2p) {
-        _pkt_log.stream << "p,";
-    } else {
-        _pkt_log.stream << "NA,";
-    }
+    _for_each_streams([&](const auto& ms) {
 
-    _pkt_log.stream << pkt.ip_5t << ",";
+        for (auto h: ms.streams.handles()) {
 
-    //TODO: handle screen share
-    if (pkt.zoom_media_type == zoom::AUDIO_TYPE) {
-        _pkt_log.stream << "a,";
-    } else if (pkt.zoom_media_type == zoom::VIDEO_TYPE) {
-        _pkt_log.stream << "v,";
-    } else {
-        _pkt_log.stream << "NA,";
-    }
+            auto last_s = (unsigned) ms.streams[h].analyzer.timestamps().last_timeval.tv_sec;
 
-    if (pkt.pkts_in_frame) {
-        _pkt_log.stream << pkt.pkts_in_frame << ",";
-    } else {
-        _pkt_log.stream << "NA,";
-    }
+            if (last_s + timeout_s <= now_s)
+                idle.push_back({ms.streams.key(h), h});
+        }
+    });
+
+    std::sort(idle.begin(), idle.end(), [](const auto& a, const auto& b) {
+        return a.key < b.key;
+    });
 
-    _pkt_log.stream
-        << std::dec << (unsigned) pkt.proto.rtp.ssrc << ","
-        << std::dec << (unsigned) pkt.proto.rtp.pt << ","
-        << std::dec << (unsigned) pkt.proto.rtp.seq << ","
-        << std::dec << (unsigned) pkt.proto.rtp.ts << ","
-        << std::dec << (unsigned) pkt.pcap_frame_len << ","
-        << std::dec << (unsigned) pkt.udp_pl_len << ",";
-
-    if (pkt.rtp_ext1[0] != 0 || pkt.rtp_ext1[1] != 0 || pkt.rtp_ext1[2] != 0) {
-        _pkt_log.stream << "0x";
-        _pkt_log.stream << std::hex << std::setw(2) << std::setfill('0') << (unsigned) pkt.rtp_ext1[0];
-        _pkt_log.stream << std::hex << std::setw(2) << std::setfill('0') << (unsigned) pkt.rtp_ext1[1];
-        _pkt_log.stream << std::hex << std::setw(2) << std::setfill('0') << (unsigned) pkt.rtp_ext1[2];
-        _pkt_log.stream << ",";
-    } else {
-        _pkt_log.stream << "NA,";
+    for (const auto& s: idle)
+        _retire_stream(s);
+}
+
+void zoom::offline_analyzer::_retire_stream(const stream_ref& s) {
+
+    if (_row_sink)
+        _row_sink->begin_stream(s.key);
+
+    _with_streams(s.key.media_type, [&](auto& ms) {
+
+        auto& data = ms.streams[s.h];
+        data.analyzer.finish();
+
+        if (_streams_log.enabled)
+            _write_streams_row(s.key, data);
+
+        ms.streams.erase(s.h);
+
+        if (ms.last == s.h)
+            ms.last = NO_STREAM;
+    });
+
+    _retired_streams++;
+}
+
+template <typename StreamData>
+void zoom::offline_analyzer::_write_streams_row(const zoom::media_stream_key& key,
+                                                const StreamData& data) {
+
+    const auto& ts = data.analyzer.timestamps();
+
+    _append(streams_row{
+        .key       = key,
+        .first_ts  = ts.first_timeval,
+        .last_ts   = ts.last_timeval,
+        .first_rtp = ts.first_rtp,
+        .last_rtp  = ts.last_rtp,
+        .pkts      = data.analyzer.stats().total_pkts,
+        .bytes     = data.analyzer.stats().total_bytes
+    });
+
+    if (_quantiles) {
+        const auto sketches = data.analyzer.stream_sketches();
+
+        _append(quantiles_row{
+            .quantiles    = to_quantiles(data.analyzer.quantiles_enabled() ? &sketches : nullptr),
+            .resolution_s = 0
+        });
     }
+}
+
+template <typename Analyzer, typename Frame>
+void zoom::offline_analyzer::_write_frame_log(const Analyzer& a, const Frame& f) {
+
+    const auto& meta = a.meta();
+    const auto first_pkt = f.pkt_at(0);
+
+    _append(frame_row{
+        .ip_5t     = meta.ip_5t,
+        .ipv6      = meta.ipv6,
+        .rtp_ssrc  = (unsigned) meta.rtp_ssrc,
+        .rtp_ts    = (unsigned) f.rtp_ts,
+        .ts_min_s  = (unsigned) f.ts_min.tv_sec,
+        .ts_min_us = (unsigned) f.ts_min.tv_usec,
+        .ts_max_s  = (unsigned) f.ts_max.tv_sec,
+        .ts_max_us = (unsigned) f.ts_max.tv_usec,
+        .pkts_seen = (unsigned) f.pkts_seen,
+        .pkts_hint = (unsigned) first_pkt.meta.pkts_hint,
+        .frame_len = (unsigned) f.total_pl_len,
+        .fps       = (unsigned) f.fps,
+        .pkt_type  = first_pkt.meta.pkt_type,
+        .rtp_ext1  = { first_pkt.meta.rtp_ext1[0], first_pkt.meta.rtp_ext1[1],
+                       first_pkt.meta.rtp_ext1[2] },
+        .jitter    = f.jitter
+    });
+}
+
+template <typename Stats, typename Sketches>
+void zoom::offline_analyzer::_write_stats_log(const zoom::media_stream_key& k, unsigned resolution_s,
+                                              unsigned report_count, unsigned ts, const Stats& c,
+                                              const Sketches* sketches) {
+
+    _append(stats_row{
+        .key            = k,
+        .ts             = ts,
+        .report_count   = report_count,
+        .resolution_s   = resolution_s,
+        .pkts           = c.total_pkts,
+        .bytes          = c.total_bytes,
+        .lost           = c.lost_pkts,
+        .duplicate      = c.duplicate_pkts,
+        .out_of_order   = c.out_of_order_pkts,
+        .frames         = c.total_frames,
+        .mean_frame_len = c.mean_frame_size(),
+        .mean_jitter    = c.mean_jitter()
+    });
 
-    _pkt_log.stream << "0" << std::endl;
-
-}
-
-void zoom::offline_analyzer::_write_frame_log(const stream_analyzer& a, const stream_analyzer::frame& f) {
-
-    auto meta = a.meta();
-    const auto* first_pkt = &(f.pkts[0]);
-
-    _frame_log.stream
-        << meta.ip_5t << ","
-        << std::dec << (unsigned) meta.rtp_ssrc << ","
-//        << std::dec << (unsigned) meta.rtp_pt << ","
-        << std::dec << (unsigned) first_pkt->meta.pkt_type << ","
-        << std::hex << std::setw(2) << std::setfill('0')
-            << (unsigned) first_pkt->meta.rtp_ext1[0]
-        << std::hex << std::setw(2) << std::setfill('0')
-            << (unsigned) first_pkt->meta.rtp_ext1[1]
-        << std::hex << std::setw(2) << std::setfill('0')
-            << (unsigned) first_pkt->meta.rtp_ext1[2] << ","
-        << std::dec << (unsigned) f.ts_min.tv_sec << ","
-        << std::dec << (unsigned) f.ts_min.tv_usec << ","
-        << std::dec << (unsigned) f.ts_max.tv_sec << ","
-        << std::dec << (unsigned) f.ts_max.tv_usec << ","
-        << std::dec << (unsigned) f.rtp_ts << ","
-        << std::dec << (unsigned) f.pkts_seen << ","
-        << std::dec << (unsigned) first_pkt->meta.pkts_hint << ","
-        << std::dec << (unsigned) f.total_pl_len << ","
-        << std::dec << (unsigned) f.fps << ","
-        << std::setprecision(5) << f.jitter
-        << std::endl;
-}
-
-void zoom::offline_analyzer::_write_stats_log(const zoom::media_stream_key& k, unsigned report_count,
-                                              unsigned ts,
-                                              const struct stream_analyzer::stats& c) {
-
-    _stats_log.stream
-        << ts << ","
-        << report_count << ","
-
-        << k.rtp_ssrc << ","
-        << zoom::media_type_to_char(k.media_type) << ","
-        << zoom::stream_type_to_char(k.stream_type) << ","
-
-        << net::ipv4::addr_to_str(k.ip_5t.ip_src) << ","
-        << k.ip_5t.tp_src << ","
-        << net::ipv4::addr_to_str(k.ip_5t.ip_dst) << ","
-        << k.ip_5t.tp_dst << ","
-
-        << std::dec << c.total_pkts << ","
-        << std::dec << c.total_bytes << ","
-
-        << std::dec << c.lost_pkts << ","
-        << std::dec << c.duplicate_pkts << ","
-        << std::dec << c.out_of_order_pkts << ","
-
-        << std::dec << c.total_frames << ","
-        << std::dec << c.mean_frame_size() << ","
-        << std::dec << c.mean_jitter()
-        << std::endl;
+    if (_quantiles)
+        _append(quantiles_row{.quantiles = to_quantiles(sketches), .resolution_s = resolution_s});
 }
@@ -1,9 +1,14 @@
 #ifndef ZOOM_ANALYSIS_ZOOM_OFFLINE_ANALYZER_H
 #define ZOOM_ANALYSIS_ZOOM_OFFLINE_ANALYZER_H
 
-#include <map>
+#include <array>
+#include <cstdint>
+#include <tuple>
+#include <vector>
 
+#include "checkpoint.h"
 #include "rtp_stream_analyzer.h"
+#include "slab_map.h"
 #include "zoom.h"
 #include "zoom_analyzer.h"
 
@@ -11,43 +16,240 @@ namespace zoom {
 
     class offline_analyzer : public analyzer {
 
-    static const unsigned STREAM_ANALYZER_BUF_LEN = 64;
+    //! forwards the frames and stats of the stream analyzers to the logs (statically dispatched)
+    struct stream_sink {
+        offline_analyzer* analyzer;
+
+        template <typename Analyzer, typename Frame>
+        inline void frame(const Analyzer& a, const Frame& f) {
+            analyzer->_frame_handler(a, f);
+        }
+
+        template <typename Analyzer, typename Stats>
+        inline void stats(const Analyzer& a, unsigned report_count, unsigned ts, const Stats& c) {
+            analyzer->_stats_handler(a, report_count, ts, c);
+        }
+
+        template <typename Analyzer, typename Stats>
+        inline void rollup(const Analyzer& a, unsigned resolution_s, unsigned report_count,
+                           unsigned ts, const Stats& c) {
+            analyzer->_rollup_handler(a, resolution_s, report_count, ts, c);
+        }
+    };
 
+    template <unsigned Len, typename Jitter>
     using stream_analyzer = rtp_stream_analyzer<zoom::media_stream_key,
-        zoom::rtp_pkt_meta, STREAM_ANALYZER_BUF_LEN>;
+        zoom::rtp_pkt_meta, Len, stream_sink, Jitter>;
+
+    using stream_handle = slab_map<zoom::media_stream_key, int>::handle;
+    static constexpr stream_handle NO_STREAM = slab_map<zoom::media_stream_key, int>::NONE;
 
+    template <unsigned Len, typename Jitter>
     struct stream_data {
-        stream_analyzer analyzer;
+        stream_analyzer<Len, Jitter> analyzer;
     };
 
-    using media_streams_map = std::map<zoom::media_stream_key, stream_data>;
+    //! the streams of one media type, each type has its own ring length
+    template <unsigned Len, typename Jitter>
+    struct media_streams {
+        using data = stream_data<Len, Jitter>;
+        using map = slab_map<zoom::media_stream_key, data>;
+        static constexpr unsigned RING_LEN = Len;
+
+        // not a default member initializer, such that the tuple of them is default-constructible
+        // within offline_analyzer
+        media_streams() : last(NO_STREAM) { }
+
+        map streams;
+
+        // stream of the previous RTP packet of this type, consecutive packets mostly belong to
+        // the same stream
+        stream_handle last;
+    };
+
+    //! a stream in one of the media_streams, which one follows from key.media_type
+    struct stream_ref {
+        zoom::media_stream_key key;
+        stream_handle h;
+    };
 
     public:
 
+        //! ring lengths of the stream analyzers (packets), by media type
+        //! - audio has a single packet per frame, screen share frames can have more than 64
+        //! - the ring length bounds the tolerated reordering, a packet more than a ring behind the
+        //!   newest one of its stream is dropped
+        static constexpr unsigned AUDIO_RING_LEN = 16;
+        static constexpr unsigned VIDEO_RING_LEN = 64;
+        static constexpr unsigned SCREEN_RING_LEN = 256;
+
+        //! memory of the streams of a media type
+        struct stream_memory {
+            unsigned ring_len        = 0;
+            std::size_t streams      = 0; //!< active streams
+            std::size_t stream_bytes = 0; //!< size of the state of a stream
+            std::size_t bytes        = 0; //!< allocated for streams and their index, see slab_map
+        };
+
         offline_analyzer() = default;
         offline_analyzer(offline_analyzer&&) = default;
         offline_analyzer& operator=(offline_analyzer&&) = default;
 
         void add(const zoom::pkt& pkt);
+
+        //! computes the jitter of the frames with rfc3550_jitter_calculator (fixed point, from
+        //! microsecond arrival times) instead of jitter_calculator (from millisecond wallclock
+        //! times), which changes the jitter values of the frame and stats logs
+        //! - must be called before the first packet, throws std::logic_error otherwise
+        void enable_rfc3550_jitter();
+
+        [[nodiscard]] bool rfc3550_jitter() const {
+            return _rfc3550_jitter;
+        }
+
+        //! writes a streams log row for each stream that was not retired
         void write_streams_log();
 
+        //! retires streams without packets for timeout_s seconds (by packet timestamps), 0 (the
+        //! default) keeps all streams until the end
+        //! - a retired stream reports its last frames and stats, writes its streams log row right
+        //!   away and frees its state, a later packet of it starts a new stream
+        void set_idle_timeout(unsigned timeout_s);
+
+        //! retires all streams, e.g., at the end of the input
+        void retire_streams();
+
+        //! reports the stats of the current second and of the open rollup intervals of all streams
+        //! (see rtp_stream_analyzer::flush_stats()), e.g., at the end of the input if the streams
+        //! are not retired, such that the stats logs cover the whole input
+        void flush_stats();
+
+        //! retires the streams without packets for timeout_s seconds at now_s, add() does this
+        //! once per trace second if an idle timeout is set
+        void retire_idle_streams(unsigned now_s, unsigned timeout_s);
+
+        [[nodiscard]] std::size_t active_streams() const;
+
+        [[nodiscard]] unsigned long retired_streams() const {
+            return _retired_streams;
+        }
+
+        //! memory of the streams by media type (audio, video, screen)
+        [[nodiscard]] std::array<stream_memory, 3> memory_usage() const;
+
+        //! writes the state of all streams to a checkpoint (logs are not included)
+        void save(checkpoint::writer& w) const;
+
+        //! replaces all streams with the ones in a checkpoint written by save()
+        //! - throws std::runtime_error if the checkpoint was taken with the other jitter calculator
+        void restore(checkpoint::reader& r);
+
     private:
 
-        media_streams_map::iterator _insert_new_stream(const zoom::media_stream_key& key,
-                                                       const zoom::pkt& pkt);
+        //! the streams of each media type, with the same jitter calculator
+        template <typename Jitter>
+        using all_media_streams = std::tuple<media_streams<AUDIO_RING_LEN, Jitter>,
+            media_streams<VIDEO_RING_LEN, Jitter>, media_streams<SCREEN_RING_LEN, Jitter>>;
+
+        //! calls fx with the media_streams of a media type, unknown types count as video
+        template <typename Fx>
+        inline decltype(auto) _with_streams(zoom::media_type type, Fx&& fx) {
 
-        void _frame_handler(const stream_analyzer& a, const struct stream_analyzer::frame& f);
-        void _stats_handler(const stream_analyzer& a, unsigned report_count,
-                            unsigned ts, const struct stream_analyzer::stats& c);
+            if (_rfc3550_jitter)
+                return _with_streams_of(_rfc3550_media_streams, type, fx);
 
-        void _write_pkt_log(const zoom::pkt& pkt);
-        void _write_frame_log(const stream_analyzer& a, const struct stream_analyzer::frame& frame);
-        void _write_stats_log(const zoom::media_stream_key& k, unsigned report_count, unsigned ts,
-                              const struct stream_analyzer::stats& c);
+            return _with_streams_of(_media_streams, type, fx);
+        }
+
+        template <typename Fx>
+        inline decltype(auto) _with_streams(zoom::media_type type, Fx&& fx) const {
+
+            if (_rfc3550_jitter)
+                return _with_streams_of(_rfc3550_media_streams, type, fx);
+
+            return _with_streams_of(_media_streams, type, fx);
+        }
+
+        template <typename Tuple, typename Fx>
+        static inline decltype(auto) _with_streams_of(Tuple& media_streams, zoom::media_type type,
+                                                      Fx& fx) {
+            switch (type) {
+                case zoom::media_type::audio:  return fx(std::get<0>(media_streams));
+                case zoom::media_type::screen: return fx(std::get<2>(media_streams));
+                default:                       return fx(std::get<1>(media_streams));
+            }
+        }
+
+        //! calls fx with the media_streams of each media type
+        template <typename Fx>
+        inline void _for_each_streams(Fx&& fx) const {
+
+            auto for_each = [&](const auto&... streams) { (fx(streams), ...); };
+
+            if (_rfc3550_jitter) {
+                std::apply(for_each, _rfc3550_media_streams);
+            } else {
+                std::apply(for_each, _media_streams);
+            }
+        }
+
+        //! returns the handle of the new stream or NO_STREAM if it already exists
+        stream_handle _insert_new_stream(const zoom::media_stream_key& key, unsigned sampling_rate);
+
+        //! all streams ordered by key, for deterministic logs and checkpoints
+        [[nodiscard]] std::vector<stream_ref> _sorted_streams() const;
+
+        void _retire_stream(const stream_ref& s);
+
+        template <typename Analyzer, typename Frame>
+        void _frame_handler(const Analyzer& a, const Frame& f);
+
+        template <typename Analyzer, typename Stats>
+        void _stats_handler(const Analyzer& a, unsigned report_count, unsigned ts, const Stats& c);
+
+        template <typename Analyzer, typename Stats>
+        void _rollup_handler(const Analyzer& a, unsigned resolution_s, unsigned report_count,
+                             unsigned ts, const Stats& c);
+
+        template <typename StreamData>
+        void _write_streams_row(const zoom::media_stream_key& key, const StreamData& data);
+
+        template <typename Analyzer, typename Frame>
+        void _write_frame_log(const Analyzer& a, const Frame& frame);
+
+        //! - sketches: of the reported interval, nullptr if quantiles are disabled
+        template <typename Stats, typename Sketches>
+        void _write_stats_log(const zoom::media_stream_key& k, unsigned resolution_s,
+                              unsigned report_count, unsigned ts, const Stats& c,
+                              const Sketches* sketches);
 
         unsigned long _pkts_processed = 0;
-        media_streams_map _media_streams;
+
+        // only the streams of the selected jitter calculator are used
+        all_media_streams<jitter_calculator> _media_streams;
+        all_media_streams<rfc3550_jitter_calculator> _rfc3550_media_streams;
+        bool _rfc3550_jitter = false;
+
+        unsigned _idle_timeout_s = 0;
+        unsigned _next_idle_check_s = 0;
+        unsigned long _retired_streams = 0;
     };
+
+    //! the stats logs are looked up by the resolutions of the stream analyzers
+    static_assert([]() {
+        const auto& logs = analyzer::STATS_ROLLUP_RESOLUTIONS;
+        const auto& streams = rtp_stream_analyzer<>::ROLLUP_RESOLUTIONS;
+
+        if (logs.size() != streams.size())
+            return false;
+
+        for (std::size_t i = 0; i < logs.size(); i++) {
+            if (logs[i] != streams[i])
+                return false;
+        }
+
+        return true;
+    }(), "zoom::analyzer and rtp_stream_analyzer must roll up the stats at the same resolutions");
 }
 
 #endif
@@ -0,0 +1,396 @@
+
+#include "zoom_p4_model.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+
+    //! parses a key expression "_", "32w0x0a000000" or "32w0x0a000000 &&& 32w0xff000000"
+    zoom::p4_ternary_table::key parse_p4_key(const std::string& s) {
+
+        auto trim = [](const std::string& t) {
+            auto begin = t.find_first_not_of(" \t");
+            auto end = t.find_last_not_of(" \t");
+            return begin == std::string::npos ? std::string() : t.substr(begin, end - begin + 1);
+        };
+
+        auto parse_value = [](const std::string& t) -> std::uint32_t {
+            auto w = t.find('w');
+            // bit<N> literals, e.g. 32w0x0a000000 or 16w3478
+            return (std::uint32_t) std::stoul(w == std::string::npos ? t : t.substr(w + 1),
+                                              nullptr, 0);
+        };
+
+        auto k = trim(s);
+
+        if (k == "_")
+            return {};
+
+        auto sep = k.find("&&&");
+
+        if (sep == std::string::npos)
+            return {parse_value(k), 0xffffffff};
+
+        auto value = parse_value(trim(k.substr(0, sep)));
+        auto mask = parse_value(trim(k.substr(sep + 3)));
+        return {value & mask, mask};
+    }
+}
+
+zoom::p4_ternary_table zoom::p4_ternary_table::from_p4inc(const std::string& file_name) {
+
+    std::ifstream ifs(file_name);
+
+    if (!ifs.is_open())
+        throw std::runtime_error("p4_ternary_table: could not open " + file_name);
+
+    std::vector<entry> entries;
+    std::string line;
+    unsigned line_no = 0;
+
+    while (std::getline(ifs, line)) {
+
+        line_no++;
+        line = line.substr(0, line.find("//"));
+
+        auto open = line.find('('), close = line.find(')'), colon = line.find(':', close);
+
+        if (open == std::string::npos) {
+            if (line.find_first_not_of(" \t\r") != std::string::npos)
+                throw std::runtime_error("p4_ternary_table: invalid entry in " + file_name + ":"
+                                         + std::to_string(line_no));
+            continue;
+        }
+
+        auto action_end = line.find('(', colon);
+
+        if (close == std::string::npos || colon == std::string::npos
+            || action_end == std::string::npos) {
+            throw std::runtime_error("p4_ternary_table: invalid entry in " + file_name + ":"
+                                     + std::to_string(line_no));
+        }
+
+        entry e;
+        auto keys = line.substr(open + 1, close - open - 1);
+
+        for (std::size_t begin = 0, end; begin <= keys.size(); begin = end + 1) {
+            end = std::min(keys.find(',', begin), keys.size());
+            e.keys.push_back(parse_p4_key(keys.substr(begin, end - begin)));
+        }
+
+        auto action = line.substr(colon + 1, action_end - colon - 1);
+        action.erase(std::remove_if(action.begin(), action.end(), ::isspace), action.end());
+        e.action = action;
+
+        entries.push_back(e);
+    }
+
+    return p4_ternary_table(std::move(entries));
+}
+
+zoom::p4_ternary_table::p4_ternary_table(std::vector<entry> entries)
+    : _entries(std::move(entries)) {
+
+    for (auto& candidates: _candidates) {
+        candidates.assign(1u << 16u, false);
+    }
+
+    for (int i = 0; i < (int) _entries.size(); i++) {
+
+        const auto& keys = _entries[i].keys;
+
+        if (keys.empty() || keys.size() > 2)
+            throw std::invalid_argument("p4_ternary_table: entries must have one or two keys");
+
+        // an entry can only match if its first non-wildcard field does
+        auto first = std::find_if(keys.begin(), keys.end(),
+                                  [](const key& k) { return k.mask != 0; });
+
+        if (first == keys.end()) {
+            _wildcard_entry = true;
+        } else {
+
+            auto& candidates = _candidates[first - keys.begin()];
+            std::uint32_t mask_hi = first->mask >> 16u, value_hi = first->value >> 16u;
+
+            for (std::uint32_t hi = 0; hi < candidates.size(); hi++) {
+                if ((hi & mask_hi) == value_hi) candidates[hi] = true;
+            }
+        }
+
+        auto specified = std::count_if(keys.begin(), keys.end(),
+                                       [](const key& k) { return k.mask != 0; });
+
+        if (specified != 1) {
+            _unindexed.push_back(i);
+            continue;
+        }
+
+        unsigned field = keys[0].mask != 0 ? 0 : 1;
+        const auto& k = keys[field];
+
+        auto it = std::find_if(_index.begin(), _index.end(), [&](const mask_index& mi) {
+            return mi.field == field && mi.mask == k.mask;
+        });
+
+        if (it == _index.end()) {
+            _index.push_back({field, k.mask});
+            it = std::prev(_index.end());
+        }
+
+        // keep the first entry, later duplicates can never match
+        it->first_entry.emplace(k.value, i);
+    }
+}
+
+int zoom::p4_ternary_table::match(std::uint32_t k0, std::uint32_t k1) const {
+
+    if (!_wildcard_entry && !_candidates[0][k0 >> 16u] && !_candidates[1][k1 >> 16u])
+        return -1;
+
+    int first = -1;
+
+    auto update = [&first](int i) {
+        if (first == -1 || i < first) first = i;
+    };
+
+    for (const auto& mi: _index) {
+
+        auto it = mi.first_entry.find((mi.field == 0 ? k0 : k1) & mi.mask);
+
+        if (it != mi.first_entry.end())
+            update(it->second);
+    }
+
+    for (auto i: _unindexed) {
+
+        const auto& keys = _entries[i].keys;
+        bool matched = (k0 & keys[0].mask) == keys[0].value;
+
+        if (keys.size() > 1)
+            matched = matched && (k1 & keys[1].mask) == keys[1].value;
+
+        if (matched) {
+            update(i);
+            break;
+        }
+    }
+
+    return first;
+}
+
+const std::vector<zoom::p4_ternary_table::entry>& zoom::p4_ternary_table::entries() const {
+    return _entries;
+}
+
+void zoom::p4_model::comparison::add(const std::optional<flow_tracker::flow_stats>& tracker,
+                                     const std::optional<flow_tracker::flow_type>& model) {
+    pkts++;
+
+    if (tracker && model) {
+        both++;
+    } else if (model) {
+        model_only++;
+    } else if (tracker) {
+        tracker_only++;
+    } else {
+        neither++;
+    }
+
+    if (tracker)
+        tracker_types[(unsigned) tracker->type]++;
+
+    if (model)
+        model_types[(unsigned) *model]++;
+}
+
+double zoom::p4_model::comparison::agreement() const {
+    return pkts ? (double) (both + neither) / (double) pkts : 1.0;
+}
+
+zoom::p4_model zoom::p4_model::from_p4_src_dir(const std::string& p4_src_dir, const config& c) {
+
+    return p4_model(p4_ternary_table::from_p4inc(p4_src_dir + "/entries_match_zoom_server.p4inc"),
+                    p4_ternary_table::from_p4inc(p4_src_dir + "/entries_match_campus_sources.p4inc"),
+                    p4_ternary_table::from_p4inc(
+                        p4_src_dir + "/entries_match_campus_destinations.p4inc"),
+                    c);
+}
+
+zoom::p4_model::p4_model(p4_ternary_table match_zoom_srv, p4_ternary_table match_campus_src,
+                         p4_ternary_table match_campus_dst, const config& c)
+    : _config(c),
+      _match_zoom_srv(std::move(match_zoom_srv)),
+      _match_campus_src(std::move(match_campus_src)),
+      _match_campus_dst(std::move(match_campus_dst)) {
+
+    if (c.idx_width == 0 || c.idx_width > BF_IDX_WIDTH)
+        throw std::invalid_argument("p4_model: idx_width must be in [1, 16]");
+
+    _idx_mask = (1u << c.idx_width) - 1;
+
+    _zoom_srv_actions = _actions(_match_zoom_srv);
+    _campus_src_actions = _actions(_match_campus_src);
+    _campus_dst_actions = _actions(_match_campus_dst);
+
+    for (auto& reg: _p2p_srcs) reg.assign(_idx_mask + 1, 0);
+    for (auto& reg: _p2p_dsts) reg.assign(_idx_mask + 1, 0);
+}
+
+std::vector<zoom::p4_model::action> zoom::p4_model::_actions(const p4_ternary_table& t) {
+
+    std::vector<action> actions;
+
+    for (const auto& e: t.entries()) {
+        if (e.action == "set_zoom_srv_src_matched") {
+            actions.push_back(action::zoom_srv_src);
+        } else if (e.action == "set_zoom_srv_dst_matched") {
+            actions.push_back(action::zoom_srv_dst);
+        } else if (e.action == "set_campus_src_matched") {
+            actions.push_back(action::campus_src);
+        } else if (e.action == "set_campus_dst_matched") {
+            actions.push_back(action::campus_dst);
+        } else if (e.action == "nop") {
+            actions.push_back(action::nop);
+        } else {
+            throw std::invalid_argument("p4_model: unknown action " + e.action);
+        }
+    }
+
+    return actions;
+}
+
+std::optional<zoom::flow_tracker::flow_type> zoom::p4_model::process(
+    const net::ipv4_5tuple& ip_5t, const timeval& ts) {
+
+    static const std::uint16_t STUN_PORTS[] = {3478, 3479};
+    auto is_stun_port = [](std::uint16_t p) { return p == STUN_PORTS[0] || p == STUN_PORTS[1]; };
+
+    _all_pkts_count++;
+
+    auto tstamp = ingress_tstamp(ts);
+    auto i = _match_zoom_srv.match(ip_5t.ip_src, ip_5t.ip_dst);
+    auto srv = i >= 0 ? _zoom_srv_actions[i] : action::nop;
+    bool srv_matched = srv == action::zoom_srv_src || srv == action::zoom_srv_dst;
+
+    if (ip_5t.ip_proto == 6 && srv_matched) {
+        _zoom_pkts_count++;
+        return flow_tracker::flow_type::tcp;
+    }
+
+    if (ip_5t.ip_proto != 17)
+        return std::nullopt;
+
+    if (srv_matched) {
+
+        if (srv == action::zoom_srv_src && is_stun_port(ip_5t.tp_src)) {
+            auto idx = _idx(ip_5t.ip_dst, ip_5t.tp_dst);
+            _set(_p2p_srcs, idx, tstamp), _set(_p2p_dsts, idx, tstamp);
+        } else if (srv == action::zoom_srv_dst && is_stun_port(ip_5t.tp_dst)) {
+            auto idx = _idx(ip_5t.ip_src, ip_5t.tp_src);
+            _set(_p2p_srcs, idx, tstamp), _set(_p2p_dsts, idx, tstamp);
+        } else {
+            _zoom_pkts_count++;
+            return flow_tracker::flow_type::udp_srv;
+        }
+
+        _zoom_pkts_count++;
+        return flow_tracker::flow_type::udp_stun;
+    }
+
+    if (ip_5t.tp_src <= 1023 || ip_5t.tp_dst <= 1023)
+        return std::nullopt;
+
+    auto campus_src = _match_campus_src.match(ip_5t.ip_src);
+    auto campus_dst = _match_campus_dst.match(ip_5t.ip_dst);
+    bool p2p_matched = false;
+
+    if (campus_src >= 0 && _campus_src_actions[campus_src] == action::campus_src) {
+        p2p_matched = _update_or_reset(_p2p_srcs, _idx(ip_5t.ip_src, ip_5t.tp_src), tstamp);
+    }
+
+    if (campus_dst >= 0 && _campus_dst_actions[campus_dst] == action::campus_dst) {
+        // evaluated regardless of the source match, both register stages are updated in P4
+        p2p_matched = _update_or_reset(_p2p_dsts, _idx(ip_5t.ip_dst, ip_5t.tp_dst), tstamp)
+                      || p2p_matched;
+    }
+
+    if (!p2p_matched)
+        return std::nullopt;
+
+    _zoom_pkts_count++;
+    return flow_tracker::flow_type::udp_p2p;
+}
+
+std::uint32_t zoom::p4_model::ingress_tstamp(const timeval& ts) {
+    // the 48 bit MAC timestamp counts ns, the program keeps bits [47:16]
+    auto ns = (std::uint64_t) ts.tv_sec * 1000000000ull + (std::uint64_t) ts.tv_usec * 1000ull;
+    return (std::uint32_t) ((ns & 0xffffffffffffull) >> 16u);
+}
+
+void zoom::p4_model::_set(registers& r, const std::array<std::uint32_t, 3>& idx,
+                          std::uint32_t ts) {
+
+    for (unsigned stage = 0; stage < 3; stage++) {
+        r[stage][idx[stage]] = ts > 0 ? ts : 1;
+    }
+}
+
+bool zoom::p4_model::_update_or_reset(registers& r, const std::array<std::uint32_t, 3>& idx,
+                                      std::uint32_t ts) const {
+
+    bool present = true;
+
+    for (unsigned stage = 0; stage < 3; stage++) {
+
+        auto& val = r[stage][idx[stage]];
+
+        // 32 bit wrap-around arithmetic as on the switch
+        if (val > 0 && (std::uint32_t) (ts - val) > _config.time_dur_cutoff) {
+            val = 0, present = false;
+        } else if (val > 0) {
+            val = ts;
+        } else {
+            present = false;
+        }
+    }
+
+    return present;
+}
+
+unsigned long long zoom::p4_model::all_pkts_count() const {
+    return _all_pkts_count;
+}
+
+unsigned long long zoom::p4_model::zoom_pkts_count() const {
+    return _zoom_pkts_count;
+}
+
+double zoom::p4_model::register_fill_ratio() const {
+
+    std::size_t set = 0;
+
+    for (const auto* regs: {&_p2p_srcs, &_p2p_dsts}) {
+        for (const auto& reg: *regs) {
+            set += (std::size_t) std::count_if(reg.begin(), reg.end(),
+                                               [](std::uint32_t v) { return v != 0; });
+        }
+    }
+
+    return (double) set / (double) register_cells();
+}
+
+std::size_t zoom::p4_model::register_cells() const {
+    return 6 * ((std::size_t) _idx_mask + 1);
+}
+
+std::size_t zoom::p4_model::register_memory_bytes() const {
+    return register_cells() * sizeof(std::uint32_t);
+}
+
+const zoom::p4_model::config& zoom::p4_model::model_config() const {
+    return _config;
+}
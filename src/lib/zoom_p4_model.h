@@ -0,0 +1,166 @@
+
+#ifndef ZOOM_ANALYSIS_ZOOM_P4_MODEL_H
+#define ZOOM_ANALYSIS_ZOOM_P4_MODEL_H
+
+#include "net.h"
+#include "zoom_flow_tracker.h"
+
+#include <array>
+#include <ctime>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace zoom {
+
+    /*!
+     * ternary match-action table with the const entries of a P4 include file (*.p4inc)
+     *
+     * - entries have the form "( 32w0x0a000000 &&& 32w0xff000000, _ ): action();"
+     * - like on the switch, the first listed matching entry wins
+     */
+    class p4_ternary_table {
+
+    public:
+
+        struct key {
+            std::uint32_t value = 0;
+            std::uint32_t mask  = 0; // 0 -> wildcard
+        };
+
+        struct entry {
+            std::vector<key> keys;
+            std::string action;
+        };
+
+        //! reads table entries from a .p4inc file, throws std::runtime_error upon error
+        static p4_ternary_table from_p4inc(const std::string& file_name);
+
+        explicit p4_ternary_table(std::vector<entry> entries);
+
+        //! returns the index of the first entry matching the key fields or -1
+        [[nodiscard]] int match(std::uint32_t k0, std::uint32_t k1 = 0) const;
+
+        [[nodiscard]] const std::vector<entry>& entries() const;
+
+    private:
+
+        //! entries with a single non-wildcard key field, grouped by field and mask
+        struct mask_index {
+            unsigned field     = 0;
+            std::uint32_t mask = 0;
+            std::unordered_map<std::uint32_t, int> first_entry = {};
+        };
+
+        std::vector<entry> _entries;
+        std::vector<mask_index> _index;
+        std::vector<int> _unindexed;
+
+        //! per key field, set for the upper 16 bits of values that may match an entry
+        //! - lets most non-matching keys skip all index lookups
+        std::array<std::vector<bool>, 2> _candidates;
+        bool _wildcard_entry = false;
+    };
+
+    /*!
+     * software model of the ingress pipeline in p4/src/zoom_capture.p4
+     *
+     * - uses the same match_zoom_srv, match_campus_src and match_campus_dst entries
+     * - models the three 32 bit timestamp register stages per P2P direction, indexed by
+     *   ip[31:16], ip[15:0] and port truncated to idx_width bits (BF_IDX_WIDTH)
+     * - models the 32 bit ingress timestamp (mac timestamp [47:16]) and TIME_DUR_CUTOFF expiry,
+     *   with timestamps taken from the capture
+     */
+    class p4_model {
+
+    public:
+
+        static const unsigned BF_IDX_WIDTH = 16;
+        static const std::uint32_t TIME_DUR_CUTOFF = 0x9D2922A;
+
+        struct config {
+            unsigned idx_width = BF_IDX_WIDTH;
+            std::uint32_t time_dur_cutoff = TIME_DUR_CUTOFF;
+        };
+
+        //! compares the verdicts of the model with zoom::flow_tracker for the same packets
+        struct comparison {
+            unsigned long long pkts         = 0;
+            unsigned long long both         = 0;
+            unsigned long long neither      = 0;
+            unsigned long long model_only   = 0;
+            unsigned long long tracker_only = 0;
+
+            //! packets accepted, by zoom::flow_tracker::flow_type
+            std::array<unsigned long long, 5> model_types   = {};
+            std::array<unsigned long long, 5> tracker_types = {};
+
+            void add(const std::optional<flow_tracker::flow_stats>& tracker,
+                     const std::optional<flow_tracker::flow_type>& model);
+
+            //! returns the fraction of packets with the same accept/drop verdict
+            [[nodiscard]] double agreement() const;
+        };
+
+        //! loads the table entries from the entries_match_*.p4inc files in p4_src_dir
+        static p4_model from_p4_src_dir(const std::string& p4_src_dir, const config& c);
+
+        p4_model(p4_ternary_table match_zoom_srv, p4_ternary_table match_campus_src,
+                 p4_ternary_table match_campus_dst, const config& c);
+
+        //! runs a packet through the ingress pipeline
+        //! - returns the type of Zoom traffic the packet was accepted as or std::nullopt if dropped
+        std::optional<flow_tracker::flow_type> process(const net::ipv4_5tuple& ip_5t,
+                                                       const timeval& ts);
+
+        //! converts a capture timestamp to the 32 bit ingress timestamp used by the program
+        static std::uint32_t ingress_tstamp(const timeval& ts);
+
+        [[nodiscard]] unsigned long long all_pkts_count() const;
+        [[nodiscard]] unsigned long long zoom_pkts_count() const;
+
+        //! returns the fraction of non-zero cells over all six P2P registers
+        [[nodiscard]] double register_fill_ratio() const;
+
+        [[nodiscard]] std::size_t register_cells() const;
+        [[nodiscard]] std::size_t register_memory_bytes() const;
+        [[nodiscard]] const config& model_config() const;
+
+    private:
+
+        enum class action : std::uint8_t {
+            nop                = 0,
+            zoom_srv_src       = 1,
+            zoom_srv_dst       = 2,
+            campus_src         = 3,
+            campus_dst         = 4
+        };
+
+        using registers = std::array<std::vector<std::uint32_t>, 3>;
+
+        static std::vector<action> _actions(const p4_ternary_table& t);
+
+        [[nodiscard]] inline std::array<std::uint32_t, 3> _idx(std::uint32_t ip,
+                                                               std::uint16_t port) const {
+            return {(ip >> 16u) & _idx_mask, ip & _idx_mask, port & _idx_mask};
+        }
+
+        static void _set(registers& r, const std::array<std::uint32_t, 3>& idx, std::uint32_t ts);
+        bool _update_or_reset(registers& r, const std::array<std::uint32_t, 3>& idx,
+                              std::uint32_t ts) const;
+
+        config _config;
+        std::uint32_t _idx_mask = 0xffff;
+
+        p4_ternary_table _match_zoom_srv, _match_campus_src, _match_campus_dst;
+        std::vector<action> _zoom_srv_actions, _campus_src_actions, _campus_dst_actions;
+
+        registers _p2p_srcs, _p2p_dsts;
+
+        unsigned long long _all_pkts_count = 0;
+        unsigned long long _zoom_pkts_count = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,339 @@
+#include <chrono>
+#include <stdexcept>
+
+#include "zoom_parallel_analyzer.h"
+
+namespace {
+
+    //! yields to the other threads, sleeps once idle for a while
+    void back_off(unsigned& idle) {
+
+        if (++idle < 64) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+}
+
+zoom::parallel_analyzer::parallel_analyzer(unsigned workers, std::size_t queue_len) {
+
+    if (workers == 0)
+        throw std::invalid_argument("zoom::parallel_analyzer: at least one worker is required");
+
+    for (unsigned i = 0; i < workers; i++)
+        _workers.push_back(std::make_unique<_worker>(queue_len));
+}
+
+zoom::parallel_analyzer::~parallel_analyzer() {
+
+    if (!_started)
+        return;
+
+    _drain();
+    _stop.store(true, std::memory_order_release);
+
+    for (auto& w: _workers)
+        w->thread.join();
+
+    _merger.join();
+}
+
+void zoom::parallel_analyzer::add(const zoom::pkt& pkt) {
+
+    if (!_started)
+        _start();
+
+    // same checks as offline_analyzer::add(), but broadcast to all workers
+    if (_idle_timeout_s && pkt.ts.s >= _next_idle_check_s) {
+
+        _broadcast({
+            .type      = _event::type::retire_idle,
+            .now_s     = pkt.ts.s,
+            .timeout_s = _idle_timeout_s,
+            .pkt       = {}
+        });
+
+        _next_idle_check_s = pkt.ts.s + 1;
+    }
+
+    if (_pkt_log.enabled) {
+        _append(pkt);
+    }
+
+    if (pkt.flags.rtp) {
+
+        auto hash = (std::uint64_t) std::hash<zoom::media_stream_key>{}(
+            zoom::media_stream_key::from_pkt(pkt));
+
+        // upper bits, the stream maps of the workers index by the lower bits
+        auto& w = *_workers[(hash >> 32u) % _workers.size()];
+
+        _dispatch(w, {.type = _event::type::pkt, .seq = ++_seq, .pkt = pkt});
+        _dispatched_seq.store(_seq, std::memory_order_release);
+    }
+}
+
+void zoom::parallel_analyzer::enable_rfc3550_jitter() {
+
+    if (_started)
+        throw std::logic_error("zoom::parallel_analyzer: the jitter calculator must be selected "
+                               "before the first packet");
+
+    for (auto& w: _workers)
+        w->analyzer.enable_rfc3550_jitter();
+}
+
+void zoom::parallel_analyzer::write_streams_log() {
+
+    if (!_started)
+        _start();
+
+    _broadcast({.type = _event::type::streams_log, .pkt = {}});
+}
+
+void zoom::parallel_analyzer::set_idle_timeout(unsigned timeout_s) {
+
+    _idle_timeout_s = timeout_s;
+    _next_idle_check_s = 0;
+}
+
+void zoom::parallel_analyzer::retire_streams() {
+
+    if (!_started)
+        _start();
+
+    _broadcast({.type = _event::type::retire_all, .pkt = {}});
+}
+
+void zoom::parallel_analyzer::flush_stats() {
+
+    if (!_started)
+        _start();
+
+    _broadcast({.type = _event::type::flush_stats, .pkt = {}});
+}
+
+zoom::analyzer::log_positions zoom::parallel_analyzer::flush_logs() {
+
+    _drain();
+    return analyzer::flush_logs();
+}
+
+std::size_t zoom::parallel_analyzer::active_streams() {
+
+    _drain();
+    std::size_t streams = 0;
+
+    for (auto& w: _workers)
+        streams += w->analyzer.active_streams();
+
+    return streams;
+}
+
+unsigned long zoom::parallel_analyzer::retired_streams() {
+
+    _drain();
+    unsigned long streams = 0;
+
+    for (auto& w: _workers)
+        streams += w->analyzer.retired_streams();
+
+    return streams;
+}
+
+std::array<zoom::offline_analyzer::stream_memory, 3> zoom::parallel_analyzer::memory_usage() {
+
+    _drain();
+    auto usage = _workers.front()->analyzer.memory_usage();
+
+    for (std::size_t i = 1; i < _workers.size(); i++) {
+
+        auto worker_usage = _workers[i]->analyzer.memory_usage();
+
+        for (std::size_t t = 0; t < usage.size(); t++) {
+            usage[t].streams += worker_usage[t].streams;
+            usage[t].bytes += worker_usage[t].bytes;
+        }
+    }
+
+    return usage;
+}
+
+void zoom::parallel_analyzer::_worker::add(const log_record& record) {
+
+    tag.record = record;
+
+    while (!rows.try_push(tag))
+        std::this_thread::yield();
+
+    rows_added.store(rows_added.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void zoom::parallel_analyzer::_worker::begin_stream(const zoom::media_stream_key& key) {
+
+    tag.key = key;
+}
+
+void zoom::parallel_analyzer::_start() {
+
+    for (auto& w: _workers)
+        w->analyzer.forward_rows(w.get(), *this);
+
+    for (auto& w: _workers)
+        w->thread = std::thread([this, &worker = *w]() { _run_worker(worker); });
+
+    _merger = std::thread([this]() { _run_merger(); });
+    _started = true;
+}
+
+void zoom::parallel_analyzer::_dispatch(_worker& w, const _event& e) {
+
+    while (!w.events.try_push(e))
+        std::this_thread::yield();
+
+    // only the reader writes dispatched
+    w.dispatched.store(w.dispatched.load(std::memory_order_relaxed) + 1,
+                       std::memory_order_release);
+}
+
+void zoom::parallel_analyzer::_broadcast(_event e) {
+
+    e.seq = ++_seq;
+
+    for (auto& w: _workers)
+        _dispatch(*w, e);
+
+    _dispatched_seq.store(_seq, std::memory_order_release);
+}
+
+void zoom::parallel_analyzer::_drain() {
+
+    if (!_started)
+        return;
+
+    std::uint64_t rows = 0;
+
+    for (auto& w: _workers) {
+
+        while (w->processed.load(std::memory_order_acquire)
+               != w->dispatched.load(std::memory_order_relaxed)) {
+
+            std::this_thread::yield();
+        }
+
+        rows += w->rows_added.load(std::memory_order_acquire);
+    }
+
+    while (_rows_merged.load(std::memory_order_acquire) != rows)
+        std::this_thread::yield();
+}
+
+void zoom::parallel_analyzer::_run_worker(_worker& w) {
+
+    _event e;
+    unsigned idle = 0;
+
+    while (true) {
+
+        if (w.events.try_pop(e)) {
+
+            w.tag.seq = e.seq;
+
+            switch (e.type) {
+                case _event::type::pkt:
+                    w.analyzer.add(e.pkt);
+                    break;
+                case _event::type::retire_idle:
+                    w.analyzer.retire_idle_streams(e.now_s, e.timeout_s);
+                    break;
+                case _event::type::retire_all:
+                    w.analyzer.retire_streams();
+                    break;
+                case _event::type::streams_log:
+                    w.analyzer.write_streams_log();
+                    break;
+                case _event::type::flush_stats:
+                    w.analyzer.flush_stats();
+                    break;
+            }
+
+            // publishes the rows of the event before it counts as processed
+            w.last_seq.store(e.seq, std::memory_order_release);
+            w.processed.store(w.processed.load(std::memory_order_relaxed) + 1,
+                              std::memory_order_release);
+            idle = 0;
+
+        } else if (_stop.load(std::memory_order_acquire)) {
+            break;
+        } else {
+            back_off(idle);
+        }
+    }
+}
+
+std::uint64_t zoom::parallel_analyzer::_watermark(const _worker& w,
+                                                  std::uint64_t dispatched_seq) const {
+
+    // dispatched_seq was loaded first: dispatched includes all events of w up to it, and an idle
+    // worker only gets events after it
+    auto dispatched = w.dispatched.load(std::memory_order_acquire);
+
+    if (w.processed.load(std::memory_order_acquire) == dispatched)
+        return dispatched_seq;
+
+    return w.last_seq.load(std::memory_order_acquire);
+}
+
+void zoom::parallel_analyzer::_run_merger() {
+
+    unsigned idle = 0;
+
+    while (true) {
+
+        _worker* next = nullptr;
+
+        for (auto& w: _workers) {
+
+            if (!w->head && !w->rows.try_pop(w->head.emplace()))
+                w->head.reset();
+
+            if (w->head && (!next || *w->head < *next->head))
+                next = w.get();
+        }
+
+        bool ready = next != nullptr;
+
+        if (ready) {
+
+            auto dispatched_seq = _dispatched_seq.load(std::memory_order_acquire);
+
+            // a worker without queued rows may still add rows before next, unless it is past it;
+            // the queue is checked again after the watermark for rows added in between
+            for (auto& w: _workers) {
+
+                if (!w->head && (_watermark(*w, dispatched_seq) < next->head->seq
+                                 || !w->rows.empty())) {
+                    ready = false;
+                    break;
+                }
+            }
+        }
+
+        if (ready) {
+
+            _write_record(next->head->record);
+            next->head.reset();
+
+            // only the merger writes rows_merged, the store publishes the written row
+            _rows_merged.store(_rows_merged.load(std::memory_order_relaxed) + 1,
+                               std::memory_order_release);
+            idle = 0;
+
+        } else if (_stop.load(std::memory_order_acquire)) {
+            break;
+        } else {
+            back_off(idle);
+        }
+    }
+}
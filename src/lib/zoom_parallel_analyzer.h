@@ -0,0 +1,150 @@
+
+#ifndef ZOOM_ANALYSIS_ZOOM_PARALLEL_ANALYZER_H
+#define ZOOM_ANALYSIS_ZOOM_PARALLEL_ANALYZER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "spsc_queue.h"
+#include "zoom.h"
+#include "zoom_analyzer.h"
+#include "zoom_offline_analyzer.h"
+
+namespace zoom {
+
+    /*!
+     * Analyzes RTP streams like zoom::offline_analyzer on several worker threads
+     *
+     * - add() runs on the reader thread: it writes the packet log and hands each RTP packet to
+     *   the worker of its stream (by the hash of its media_stream_key) over a lock-free queue,
+     *   each worker runs an offline_analyzer on its share of the streams
+     * - the frame, stats and streams log rows of the workers are merged into the logs of this
+     *   analyzer on a background thread, in exactly the order of a single offline_analyzer:
+     *   - every packet and every broadcast (e.g., retiring idle streams) gets a sequence number
+     *     and the rows it causes are tagged with it, rows of streams retired by the same
+     *     broadcast are ordered by key, as offline_analyzer retires them
+     *   - a row is written once every other worker has either a later row queued or processed
+     *     everything up to its sequence number
+     * - logs must be enabled before the first add(), checkpoints are not supported
+     * - the analyzer must not be moved
+     */
+    class parallel_analyzer : public analyzer {
+    public:
+
+        //! - queue_len: packets queued per worker and rows queued per worker (power of two)
+        explicit parallel_analyzer(unsigned workers, std::size_t queue_len = 1 << 12);
+
+        parallel_analyzer(const parallel_analyzer&) = delete;
+        parallel_analyzer& operator=(const parallel_analyzer&) = delete;
+        parallel_analyzer(parallel_analyzer&&) = delete;
+        parallel_analyzer& operator=(parallel_analyzer&&) = delete;
+
+        //! waits for the workers and the merger to finish and stops them
+        ~parallel_analyzer();
+
+        void add(const zoom::pkt& pkt);
+
+        //! see offline_analyzer
+        void enable_rfc3550_jitter();
+        void write_streams_log();
+        void set_idle_timeout(unsigned timeout_s);
+        void retire_streams();
+        void flush_stats();
+
+        //! waits until all rows of the dispatched packets are merged, then flushes the logs
+        log_positions flush_logs();
+
+        //! wait until the workers have processed all dispatched packets
+        [[nodiscard]] std::size_t active_streams();
+        [[nodiscard]] unsigned long retired_streams();
+
+        //! summed up over the workers, see offline_analyzer
+        [[nodiscard]] std::array<offline_analyzer::stream_memory, 3> memory_usage();
+
+        [[nodiscard]] unsigned workers() const {
+            return (unsigned) _workers.size();
+        }
+
+    private:
+
+        struct _event {
+            enum class type : std::uint8_t {
+                pkt, retire_idle, retire_all, streams_log, flush_stats
+            } type = type::pkt;
+
+            std::uint64_t seq = 0;
+            unsigned now_s = 0, timeout_s = 0; // retire_idle
+            zoom::pkt pkt;
+        };
+
+        //! log row tagged with the event that caused it
+        struct _row {
+            std::uint64_t seq = 0;
+            zoom::media_stream_key key = {};
+            log_record record;
+
+            [[nodiscard]] bool operator<(const _row& r) const {
+                return seq < r.seq || (seq == r.seq && key < r.key);
+            }
+        };
+
+        //! worker thread state, the worker is also the row sink of its analyzer
+        struct _worker : row_sink {
+            explicit _worker(std::size_t queue_len) : events(queue_len), rows(queue_len) { }
+
+            void add(const log_record& record) override;
+            void begin_stream(const zoom::media_stream_key& key) override;
+
+            offline_analyzer analyzer;
+            spsc_queue<_event> events;
+            spsc_queue<_row> rows;
+            std::thread thread;
+
+            _row tag; // of the next row, updated by the worker thread only
+            std::optional<_row> head; // next row to be merged, used by the merger only
+
+            std::atomic<std::uint64_t> dispatched = 0; // events, written by the reader only
+            std::atomic<std::uint64_t> processed  = 0; // events, written by the worker only
+            std::atomic<std::uint64_t> last_seq   = 0; // of the last processed event
+            std::atomic<std::uint64_t> rows_added = 0; // written by the worker only
+        };
+
+        //! hands the logs to the workers and starts the threads, before the first event
+        void _start();
+
+        //! hands an event to one worker, waits while its queue is full
+        void _dispatch(_worker& w, const _event& e);
+
+        //! hands an event to all workers
+        void _broadcast(_event e);
+
+        //! waits until the workers have processed all events and their rows are merged
+        void _drain();
+
+        void _run_worker(_worker& w);
+        void _run_merger();
+
+        //! all rows of w up to this sequence number are queued or merged
+        [[nodiscard]] std::uint64_t _watermark(const _worker& w,
+                                               std::uint64_t dispatched_seq) const;
+
+        std::vector<std::unique_ptr<_worker>> _workers;
+        std::thread _merger;
+        bool _started = false;
+        std::atomic<bool> _stop = false;
+
+        std::uint64_t _seq = 0; // of the last event, reader only
+        std::atomic<std::uint64_t> _dispatched_seq = 0; // published after an event is dispatched
+        std::atomic<std::uint64_t> _rows_merged = 0;   // written by the merger only
+
+        unsigned _idle_timeout_s = 0;
+        unsigned _next_idle_check_s = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,151 @@
+
+#include <catch.h>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include "lib/arrow_ipc_writer.h"
+
+namespace {
+
+    const std::string FILE_NAME =
+        (std::filesystem::temp_directory_path() / "zoom_analysis_arrow_test.arrow").string();
+
+    std::string read_file(const std::string& path) {
+        std::ifstream is(path, std::ios::binary);
+        std::stringstream ss;
+        ss << is.rdbuf();
+        return ss.str();
+    }
+
+    template <typename T>
+    T read_at(const std::string& buf, std::size_t pos) {
+        T v;
+        REQUIRE(pos + sizeof(T) <= buf.size());
+        std::memcpy(&v, buf.data() + pos, sizeof(T));
+        return v;
+    }
+
+    //! position of a field of the flatbuffer table at table in buf, 0 if absent
+    std::size_t fb_field(const std::string& buf, std::size_t table, unsigned slot) {
+
+        auto vtable = table - read_at<std::int32_t>(buf, table);
+        auto vtable_len = read_at<std::uint16_t>(buf, vtable);
+
+        if (4 + 2 * slot >= vtable_len)
+            return 0;
+
+        auto off = read_at<std::uint16_t>(buf, vtable + 4 + 2 * slot);
+        return off ? table + off : 0;
+    }
+
+    //! root table of a flatbuffer
+    std::size_t fb_root(const std::string& buf) {
+        return read_at<std::uint32_t>(buf, 0);
+    }
+
+    //! follows the offset of a table, string or vector field
+    std::size_t fb_deref(const std::string& buf, std::size_t field) {
+        REQUIRE(field != 0);
+        return field + read_at<std::uint32_t>(buf, field);
+    }
+
+    const std::vector<arrow_ipc_writer::column> SCHEMA = {
+        {"ts_s",   arrow_ipc_writer::type::uint32},
+        {"ip_src", arrow_ipc_writer::type::utf8},
+        {"jitter", arrow_ipc_writer::type::float64},
+        {"hint",   arrow_ipc_writer::type::uint16, true}
+    };
+}
+
+TEST_CASE("arrow_ipc_writer", "[arrow_ipc_writer]") {
+
+    SECTION("writes an Arrow IPC file with one record batch per batch_rows rows") {
+
+        {
+            arrow_ipc_writer w(FILE_NAME, SCHEMA, 4);
+
+            for (unsigned i = 0; i < 10; i++) {
+
+                w.put(1600000000 + i).put_ipv4(0x0a000001).put(i / 4.0);
+
+                if (i % 2) {
+                    w.put(i);
+                } else {
+                    w.put_null();
+                }
+
+                w.end_row();
+            }
+
+            CHECK(w.rows() == 10);
+        }
+
+        auto file = read_file(FILE_NAME);
+        REQUIRE(file.size() > 16);
+
+        // magic, padded to 8 Bytes at the start and followed by the footer length at the end
+        CHECK(file.substr(0, 8) == std::string("ARROW1\0\0", 8));
+        CHECK(file.substr(file.size() - 6) == "ARROW1");
+
+        std::int32_t footer_len;
+        std::memcpy(&footer_len, file.data() + file.size() - 10, 4);
+        CHECK(footer_len > 0);
+        CHECK((std::size_t) footer_len < file.size() - 18);
+
+        // schema message starts with a continuation marker
+        CHECK(file.substr(8, 4) == "\xff\xff\xff\xff");
+
+        // the footer follows the end-of-stream marker, its record batch blocks point to messages
+        // whose RecordBatch headers hold the row counts
+        auto footer_pos = file.size() - 10 - (std::size_t) footer_len;
+        CHECK(file.substr(footer_pos - 8, 8) == std::string("\xff\xff\xff\xff\0\0\0\0", 8));
+
+        auto footer = file.substr(footer_pos, (std::size_t) footer_len);
+        auto blocks = fb_deref(footer, fb_field(footer, fb_root(footer), 3));
+        REQUIRE(read_at<std::uint32_t>(footer, blocks) == 3);
+
+        std::vector<std::int64_t> rows;
+
+        for (std::size_t i = 0; i < 3; i++) {
+
+            // Block: offset, metadata length (padded to 8 Bytes), body length
+            auto offset = read_at<std::int64_t>(footer, blocks + 4 + i * 24);
+            auto metadata_len = read_at<std::int32_t>(footer, blocks + 4 + i * 24 + 8);
+
+            CHECK(offset % 8 == 0);
+            CHECK(read_at<std::uint32_t>(file, (std::size_t) offset) == 0xffffffff);
+            CHECK(read_at<std::int32_t>(file, (std::size_t) offset + 4) + 8 == metadata_len);
+
+            auto message = file.substr((std::size_t) offset + 8, (std::size_t) metadata_len - 8);
+            auto header = fb_deref(message, fb_field(message, fb_root(message), 2));
+            rows.push_back(read_at<std::int64_t>(message, fb_field(message, header, 0)));
+        }
+
+        CHECK(rows == std::vector<std::int64_t>{4, 4, 2});
+
+        // column names and values are stored verbatim
+        CHECK(file.find("ip_src") != std::string::npos);
+        CHECK(file.find("10.0.0.1") != std::string::npos);
+    }
+
+    SECTION("rejects rows that do not match the schema") {
+
+        arrow_ipc_writer w(FILE_NAME, SCHEMA);
+
+        CHECK_THROWS_AS(w.put("10.0.0.1"), std::logic_error);
+        CHECK_THROWS_AS(w.put(1u).put(2u), std::logic_error);
+
+        arrow_ipc_writer w2(FILE_NAME, SCHEMA);
+        CHECK_THROWS_AS(w2.put_null(), std::logic_error);
+        w2.put(1u).put("10.0.0.1");
+        CHECK_THROWS_AS(w2.end_row(), std::logic_error);
+    }
+
+    SECTION("cannot open a file in a missing directory") {
+        CHECK_THROWS_AS(arrow_ipc_writer("/nonexistent/dir/file.arrow", SCHEMA), std::runtime_error);
+    }
+
+    std::filesystem::remove(FILE_NAME);
+}
@@ -0,0 +1,111 @@
+
+#include <catch.h>
+#include <filesystem>
+
+#include "lib/checkpoint.h"
+#include "lib/net.h"
+#include "lib/rtp_stream_analyzer.h"
+#include "lib/zoom_flow_tracker.h"
+
+static const std::string CHECKPOINT_FILE_NAME =
+    (std::filesystem::temp_directory_path() / "zoom_analysis_checkpoint_test.ckpt").string();
+
+TEST_CASE("checkpoint: values can be written and read back", "[checkpoint]") {
+
+    checkpoint::writer w(CHECKPOINT_FILE_NAME, "test");
+    w.write(42u);
+    w.write(std::string("pcap0"));
+    w.write(std::vector<std::string>{"a", "bc"});
+    w.commit();
+
+    checkpoint::reader r(CHECKPOINT_FILE_NAME, "test");
+    CHECK(r.read<unsigned>() == 42);
+    CHECK(r.read<std::string>() == "pcap0");
+    CHECK(r.read<std::vector<std::string>>() == std::vector<std::string>{"a", "bc"});
+    CHECK_THROWS(r.read<unsigned>());
+
+    CHECK_THROWS(checkpoint::reader(CHECKPOINT_FILE_NAME, "other"));
+    CHECK_THROWS(checkpoint::reader("data/zoom_test.pcap", "test"));
+}
+
+TEST_CASE("checkpoint: zoom::flow_tracker can be saved and restored", "[checkpoint]") {
+
+    net::ipv4_5tuple zoom_stun_flow {
+            net::ipv4::str_to_addr("10.0.0.6"), net::ipv4::str_to_addr("144.195.0.5"),
+            12433, 3478, 17
+    };
+
+    net::ipv4_5tuple zoom_p2p_flow {
+            net::ipv4::str_to_addr("84.202.2.49"), net::ipv4::str_to_addr("10.0.0.6"),
+            8809, 12433, 17
+    };
+
+    zoom::flow_tracker tracker;
+    tracker.track(zoom_stun_flow, {10, 0}, 100);
+
+    {
+        checkpoint::writer w(CHECKPOINT_FILE_NAME, "test");
+        tracker.save(w);
+        w.commit();
+    }
+
+    zoom::flow_tracker restored;
+    checkpoint::reader r(CHECKPOINT_FILE_NAME, "test");
+    restored.restore(r);
+
+    CHECK(restored.count_zoom_flows_detected() == 1);
+    CHECK(restored.count_zoom_pkts_detected() == 1);
+    CHECK(restored.flows().at(zoom_stun_flow).bytes == 100);
+
+    // the P2P peer learned before the checkpoint is still known
+    auto fs = restored.track(zoom_p2p_flow, {20, 0}, 200);
+    REQUIRE(fs);
+    CHECK(fs->type == zoom::flow_tracker::flow_type::udp_p2p);
+    CHECK(fs->id == 1);
+
+    zoom::flow_tracker bidirectional(300, true);
+    checkpoint::reader r2(CHECKPOINT_FILE_NAME, "test");
+    CHECK_THROWS(bidirectional.restore(r2));
+}
+
+TEST_CASE("checkpoint: rtp_stream_analyzer can be saved and restored", "[checkpoint]") {
+
+    using analyzer = rtp_stream_analyzer<rtp_stream_analyzer_empty_meta,
+                                         rtp_stream_analyzer_empty_meta, 16>;
+
+    std::vector<unsigned> frames_a, frames_b;
+
+    analyzer a([&](const auto&, const auto& f) { frames_a.push_back(f.rtp_ts); },
+               [](const auto&, unsigned, unsigned, const auto&) { });
+
+    analyzer b([&](const auto&, const auto& f) { frames_b.push_back(f.rtp_ts); },
+               [](const auto&, unsigned, unsigned, const auto&) { });
+
+    for (unsigned i = 1; i <= 20; i++) {
+        a.add(i, i / 2 * 3000, {0, (int) i * 10000}, 1000, {});
+    }
+
+    {
+        checkpoint::writer w(CHECKPOINT_FILE_NAME, "test");
+        a.save(w);
+        w.commit();
+    }
+
+    checkpoint::reader r(CHECKPOINT_FILE_NAME, "test");
+    b.restore(r);
+    frames_a.clear();
+
+    // both analyzers evict the same frames from their restored rings
+    for (unsigned i = 21; i <= 40; i++) {
+        a.add(i, i / 2 * 3000, {0, (int) i * 10000}, 1000, {});
+        b.add(i, i / 2 * 3000, {0, (int) i * 10000}, 1000, {});
+    }
+
+    CHECK(!frames_a.empty());
+    CHECK(frames_a == frames_b);
+    CHECK(a.stats().total_pkts == 40);
+    CHECK(b.stats().total_pkts == 40);
+    CHECK(b.stats().total_frames == a.stats().total_frames);
+
+    std::filesystem::remove(CHECKPOINT_FILE_NAME);
+}
@@ -0,0 +1,61 @@
+
+#include <catch.h>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+#include "lib/csv_buffer.h"
+#include "lib/net.h"
+
+TEST_CASE("csv_buffer: formats fields like std::ostream", "[csv_buffer]") {
+
+    csv_buffer buf;
+    std::ostringstream expected;
+
+    buf.put(0u).put(',').put(std::numeric_limits<std::uint32_t>::max()).put(',')
+       .put(std::numeric_limits<unsigned long>::max()).put(',').put((std::uint16_t) 8801)
+       .put(',').put(-42).put(",x");
+
+    expected << 0u << "," << std::numeric_limits<std::uint32_t>::max() << ","
+             << std::numeric_limits<unsigned long>::max() << "," << (std::uint16_t) 8801
+             << "," << -42 << ",x";
+
+    CHECK(buf.view() == expected.str());
+
+    for (double d: {0.0, -1.0, 0.0440063123, 21313.83333, 1e-7, 123456789.0, 2.5}) {
+
+        csv_buffer b5, b6;
+        std::ostringstream e5, e6;
+
+        b5.put(d, 5), b6.put(d, 6);
+        e5 << std::setprecision(5) << d, e6 << d;
+
+        CHECK(b5.view() == e5.str());
+        CHECK(b6.view() == e6.str());
+    }
+
+    csv_buffer ip;
+    ip.put_ipv4(net::ipv4::str_to_addr("144.195.0.5")).put(',').put_hex(0x0a).put_hex(0xff);
+    CHECK(ip.view() == "144.195.0.5,0aff");
+}
+
+TEST_CASE("csv_buffer: collects rows until full", "[csv_buffer]") {
+
+    csv_buffer buf;
+    std::ostringstream os;
+    std::string row(1000, 'x');
+
+    while (!buf.full())
+        buf.put(row);
+
+    CHECK(buf.size() >= csv_buffer::FLUSH_LEN);
+
+    // rows beyond the initial capacity grow the buffer instead of overflowing it
+    buf.put(row).put(row);
+    auto size = buf.size();
+
+    buf.write_to(os);
+    CHECK(os.str().size() == size);
+    CHECK(buf.size() == 0);
+    CHECK_FALSE(buf.full());
+}
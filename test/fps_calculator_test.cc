@@ -0,0 +1,104 @@
+
+#include <catch.h>
+#include <filesystem>
+
+#include "lib/fps_calculator.h"
+
+TEST_CASE("fps_calculator: frames in the window", "[fps_calculator]") {
+
+    SECTION("steady frame rate") {
+
+        fps_calculator c;
+
+        // the first second ramps up, 30 frames span just over a second
+        for (unsigned i = 0; i < 30; i++)
+            CHECK(c.add_frame(std::int64_t(i) * 33334) == i + 1);
+
+        for (unsigned i = 30; i < 300; i++)
+            CHECK(c.add_frame(std::int64_t(i) * 33334) == 30);
+
+        CHECK(c.add_frame(timeval{100, 0}) == 1);
+    }
+
+    SECTION("5s window") {
+
+        fps_calculator c(5), d(5);
+        CHECK(c.window_s() == 5);
+
+        for (unsigned i = 0; i < 600; i++) {
+            (void) c.add_frame(1000000000 + std::int64_t(i) * 100000);
+            (void) d.add_frame(1000000000 + std::int64_t(i) * 20000);
+        }
+
+        CHECK(c.frames() == 50);
+        CHECK(c.fps() == 10);
+
+        // several frames per bucket (78.125 ms) are only counted approximately at the start
+        CHECK(d.frames() >= 249);
+        CHECK(d.frames() <= 251);
+        CHECK(d.fps() == 50);
+    }
+
+    SECTION("bursts do not throw") {
+
+        fps_calculator c;
+
+        for (unsigned i = 0; i < 10000; i++)
+            (void) c.add_frame(timeval{10, (int) i});
+
+        CHECK(c.fps() == 10000);
+
+        // beyond the counter limit of a bucket
+        for (unsigned i = 0; i < 100000; i++)
+            (void) c.add_frame(timeval{20, 0});
+
+        CHECK(c.fps() == 65535);
+    }
+
+    SECTION("reordered frames") {
+
+        fps_calculator c;
+        (void) c.add_frame(timeval{10, 0});
+        (void) c.add_frame(timeval{10, 500000});
+
+        // within the window of the latest frame, or older than it
+        CHECK(c.add_frame(timeval{9, 600000}) == 3);
+        CHECK(c.add_frame(timeval{8, 0}) == 3);
+        CHECK(c.add_frame(timeval{11, 400000}) == 2);
+    }
+
+    SECTION("timestamps before 1970") {
+
+        fps_calculator c;
+
+        for (int i = -30; i < 30; i++)
+            (void) c.add_frame(std::int64_t(i) * 33334);
+
+        CHECK(c.fps() == 30);
+    }
+}
+
+TEST_CASE("fps_calculator: can be saved and restored", "[fps_calculator]") {
+
+    const auto file_name =
+        (std::filesystem::temp_directory_path() / "zoom_analysis_fps_calculator_test.ckpt").string();
+    fps_calculator a(5), b;
+
+    for (unsigned i = 0; i < 200; i++)
+        (void) a.add_frame(std::int64_t(i) * 40000);
+
+    {
+        checkpoint::writer w(file_name, "test");
+        a.save(w);
+        w.commit();
+    }
+
+    checkpoint::reader r(file_name, "test");
+    b.restore(r);
+
+    CHECK(b.window_s() == 5);
+    CHECK(b.add_frame(std::int64_t(200) * 40000) == a.add_frame(std::int64_t(200) * 40000));
+    CHECK(b.frames() == 125);
+
+    std::filesystem::remove(file_name);
+}
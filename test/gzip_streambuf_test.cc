@@ -0,0 +1,115 @@
+
+#include <catch.h>
+#include <filesystem>
+#include <sstream>
+#include <zlib.h>
+
+#include "lib/checkpoint.h"
+#include "lib/output_stream.h"
+
+namespace {
+
+    const std::string FILE_NAME =
+        (std::filesystem::temp_directory_path() / "zoom_analysis_gzip_test.csv.gz").string();
+
+    std::string gunzip(const std::string& path) {
+
+        std::string out;
+        char buf[1 << 16];
+        auto* f = gzopen(path.c_str(), "rb");
+        int n;
+
+        while ((n = gzread(f, buf, sizeof(buf))) > 0)
+            out.append(buf, n);
+
+        gzclose(f);
+        return out;
+    }
+
+    //! rows spanning several chunks
+    std::string rows(unsigned from, unsigned to) {
+        std::ostringstream ss;
+
+        for (unsigned i = from; i < to; i++)
+            ss << i << ",10.0.0.1,8801,10.0.0.2," << i % 65536 << std::endl;
+
+        return ss.str();
+    }
+}
+
+TEST_CASE("gzip_streambuf", "[gzip_streambuf]") {
+
+    SECTION("output_stream compresses files ending in .gz") {
+
+        CHECK(output_stream::is_gzip_path("a.csv.gz"));
+        CHECK_FALSE(output_stream::is_gzip_path("a.csv"));
+        CHECK_FALSE(output_stream::is_gzip_path(".gz"));
+
+        auto expected = rows(0, 200000);
+
+        {
+            output_stream os(FILE_NAME);
+            REQUIRE(os.is_open());
+            CHECK(os.compressed());
+            os << expected;
+        }
+
+        CHECK(expected.size() > 2 * gzip_streambuf::CHUNK_LEN);
+        CHECK(std::filesystem::file_size(FILE_NAME) < expected.size() / 4);
+        CHECK(gunzip(FILE_NAME) == expected);
+    }
+
+    SECTION("can be truncated at a member end and appended to") {
+
+        std::int64_t pos;
+
+        {
+            output_stream os(FILE_NAME);
+            os << rows(0, 1000);
+            pos = os.flush_position();
+            CHECK(pos == (std::int64_t) std::filesystem::file_size(FILE_NAME));
+
+            // rows after the checkpoint that are discarded when resuming
+            os << rows(1000, 2000);
+        }
+
+        checkpoint::truncate_output(FILE_NAME, pos);
+
+        {
+            output_stream os(FILE_NAME, true);
+            os << rows(1000, 3000);
+        }
+
+        CHECK(gunzip(FILE_NAME) == rows(0, 3000));
+    }
+
+    SECTION("empty members are not written") {
+
+        output_stream os(FILE_NAME);
+        CHECK(os.flush_position() == 0);
+        os << "a" << std::endl;
+        auto pos = os.flush_position();
+        CHECK(pos > 0);
+        CHECK(os.flush_position() == pos);
+    }
+
+    SECTION("reports write errors") {
+
+        // writes to /dev/full fail with ENOSPC
+        if (!std::filesystem::exists("/dev/full"))
+            return;
+
+        gzip_streambuf buf("/dev/full");
+        REQUIRE(buf.is_open());
+
+        std::ostream os(&buf);
+        os << rows(0, 200000) << std::flush;
+
+        CHECK(os.bad());
+        CHECK_THROWS_AS(buf.end_member(), std::runtime_error);
+        CHECK_THROWS_AS(buf.close(), std::runtime_error);
+        CHECK_FALSE(buf.is_open());
+    }
+
+    std::filesystem::remove(FILE_NAME);
+}
@@ -0,0 +1,151 @@
+
+#include <catch.h>
+#include <cmath>
+#include <filesystem>
+#include <vector>
+
+#include "lib/jitter_calculator.h"
+#include "lib/rtp_stream_analyzer.h"
+
+namespace {
+
+    struct frame {
+        std::int64_t ts_us;
+        std::uint32_t rtp_ts;
+    };
+
+    //! 30 fps at 90 kHz, arrival times vary by up to 20 ms
+    std::vector<frame> video_frames(std::uint32_t rtp_ts_0, unsigned n = 1000) {
+
+        std::vector<frame> frames;
+        std::uint32_t x = 1;
+
+        for (unsigned i = 0; i < n; i++) {
+            x = x * 1103515245 + 12345;
+            frames.push_back({1600000000000000 + (std::int64_t) i * 33333 + (x >> 16) % 20000,
+                              rtp_ts_0 + i * 3000});
+        }
+
+        return frames;
+    }
+
+    //! RFC 3550 jitter in RTP units in floating point
+    double reference_jitter(const std::vector<frame>& frames, unsigned sampling_rate) {
+
+        double j = 0;
+
+        for (std::size_t i = 1; i < frames.size(); i++) {
+            auto dr = (double) (frames[i].ts_us - frames[i - 1].ts_us) * sampling_rate / 1e6;
+            auto ds = (double) (std::int32_t) (frames[i].rtp_ts - frames[i - 1].rtp_ts);
+            j += (std::abs(dr - ds) - j) / 16;
+        }
+
+        return j;
+    }
+}
+
+TEST_CASE("rfc3550_jitter_calculator", "[jitter_calculator]") {
+
+    SECTION("same as the floating-point RFC 3550 jitter") {
+
+        auto frames = video_frames(1000);
+        rfc3550_jitter_calculator c(90000);
+
+        for (const auto& f: frames)
+            (void) c.add_frame(f.ts_us, f.rtp_ts);
+
+        auto expected = reference_jitter(frames, 90000);
+        CHECK(expected > 100);
+        CHECK(std::abs((double) c.jitter_rtp() - expected) <= 1);
+        CHECK(c.jitter_ms() == Approx(expected / 90).epsilon(0.001));
+    }
+
+    SECTION("RTP timestamps wrap around") {
+
+        rfc3550_jitter_calculator a, b;
+        double jitter_a = 0, jitter_b = 0;
+
+        for (const auto& f: video_frames(1000))
+            jitter_a = a.add_frame(f.ts_us, f.rtp_ts);
+
+        // wraps after 100 frames
+        for (const auto& f: video_frames(-100 * 3000))
+            jitter_b = b.add_frame(f.ts_us, f.rtp_ts);
+
+        CHECK(jitter_b == jitter_a);
+    }
+
+    SECTION("sub-millisecond arrival times are not truncated") {
+
+        rfc3550_jitter_calculator a;
+        jitter_calculator b;
+        double jitter_a = 0, jitter_b = 0;
+
+        // exactly 30 fps with a constant delay of 0.6 ms, 3000 RTP units are 33333.3 µs
+        for (unsigned i = 0; i < 300; i++) {
+            timeval tv{(long) (i / 30), (long) (i % 30) * 100000 / 3 + 600};
+            jitter_a = a.add_frame(tv, i * 3000);
+            jitter_b = b.add_frame(tv, i * 3000);
+        }
+
+        CHECK(jitter_a < 0.001);
+        CHECK(jitter_b > 0.1);
+    }
+
+    SECTION("rejects sampling rates that overflow the fixed-point kernel") {
+
+        CHECK_THROWS_AS(rfc3550_jitter_calculator(0), std::invalid_argument);
+        CHECK_THROWS_AS(rfc3550_jitter_calculator((1u << 17) + 1), std::invalid_argument);
+        CHECK_NOTHROW(rfc3550_jitter_calculator(1u << 17));
+    }
+
+    SECTION("can be saved and restored") {
+
+        const auto file_name = (std::filesystem::temp_directory_path()
+                                / "zoom_analysis_jitter_calculator_test.ckpt").string();
+
+        auto frames = video_frames(1000);
+        rfc3550_jitter_calculator a(8000), b;
+
+        for (unsigned i = 0; i < 500; i++)
+            (void) a.add_frame(frames[i].ts_us, frames[i].rtp_ts);
+
+        {
+            checkpoint::writer w(file_name, "test");
+            a.save(w);
+            w.commit();
+        }
+
+        checkpoint::reader r(file_name, "test");
+        b.restore(r);
+
+        for (unsigned i = 500; i < frames.size(); i++)
+            CHECK(b.add_frame(frames[i].ts_us, frames[i].rtp_ts)
+                  == a.add_frame(frames[i].ts_us, frames[i].rtp_ts));
+
+        std::filesystem::remove(file_name);
+    }
+}
+
+TEST_CASE("rtp_stream_analyzer: RFC 3550 jitter", "[jitter_calculator]") {
+
+    std::vector<double> jitter;
+
+    rtp_stream_analyzer<rtp_stream_analyzer_empty_meta, rtp_stream_analyzer_empty_meta, 32, void,
+                        rfc3550_jitter_calculator> a(
+        [&](const auto&, const auto& f) { jitter.push_back(f.jitter); }, nullptr);
+
+    auto frames = video_frames(1000, 100);
+
+    for (unsigned i = 0; i < frames.size(); i++) {
+        a.add(i + 1, frames[i].rtp_ts, {(long) (frames[i].ts_us / 1000000),
+                                        (long) (frames[i].ts_us % 1000000)}, 1000, {});
+    }
+
+    a.flush();
+
+    rfc3550_jitter_calculator c;
+
+    for (const auto& f: frames)
+        CHECK(c.add_frame(f.ts_us, f.rtp_ts) == jitter.at(&f - frames.data()));
+}
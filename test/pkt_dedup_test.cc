@@ -0,0 +1,139 @@
+
+#include <catch.h>
+#include <filesystem>
+#include <vector>
+
+#include "lib/pkt_dedup.h"
+#include "lib/zoom.h"
+
+#include "test_packets.h"
+
+TEST_CASE("pkt_dedup", "[pkt_dedup]") {
+
+    std::vector<unsigned char> buf(std::begin(test::zoom_srv_video_buf),
+                                   std::end(test::zoom_srv_video_buf));
+
+    auto ip_len = buf.size() - net::eth::HDR_LEN;
+    auto* ip = (net::ipv4::hdr*) (buf.data() + net::eth::HDR_LEN);
+    auto ip_5t = zoom::parse_net_hdrs(buf.data()).ip_5t;
+
+    SECTION("drops copies within the window") {
+
+        pkt_dedup d(1000);
+
+        CHECK_FALSE(d.is_duplicate(ip, ip_5t, ip_len, {10, 0}));
+        CHECK(d.is_duplicate(ip, ip_5t, ip_len, {10, 500}));
+
+        // merged captures may be out of order
+        CHECK(d.is_duplicate(ip, ip_5t, ip_len, {9, 999500}));
+
+        // TTL and IP checksum may change between mirrored ports
+        ip->time_to_live--, ip->hdr_checksum++;
+        CHECK(d.is_duplicate(ip, ip_5t, ip_len, {10, 800}));
+
+        CHECK_FALSE(d.is_duplicate(ip, ip_5t, ip_len, {10, 1001}));
+        CHECK(d.checked_count() == 5);
+        CHECK(d.dropped_count() == 3);
+        CHECK(d.memory_bytes() == 256 * 1024);
+    }
+
+    SECTION("keeps packets that differ in IP ID, 5-tuple or payload prefix") {
+
+        pkt_dedup d(1000);
+        CHECK_FALSE(d.is_duplicate(ip, ip_5t, ip_len, {10, 0}));
+
+        ip->id++;
+        CHECK_FALSE(d.is_duplicate(ip, ip_5t, ip_len, {10, 0}));
+
+        auto other_5t = ip_5t;
+        other_5t.tp_dst++;
+        CHECK_FALSE(d.is_duplicate(ip, other_5t, ip_len, {10, 0}));
+
+        // the RTP sequence number lies within the first 24 bytes after the IP header
+        buf[net::eth::HDR_LEN + ip->ihl_bytes() + 20]++;
+        CHECK_FALSE(d.is_duplicate(ip, ip_5t, ip_len, {10, 0}));
+
+        // bytes after the prefix are not compared
+        buf.back()++;
+        CHECK(d.is_duplicate(ip, ip_5t, ip_len, {10, 0}));
+
+        CHECK(d.dropped_count() == 1);
+        CHECK(pkt_dedup::fingerprint(ip, ip_5t, ip_len) != 0);
+    }
+
+    SECTION("replaces the oldest fingerprint of a full bucket") {
+
+        pkt_dedup d(1000000, 1);
+
+        for (unsigned i = 0; i <= pkt_dedup::WAYS; i++) {
+            ip->id = htons(i);
+            CHECK_FALSE(d.is_duplicate(ip, ip_5t, ip_len, {10, (int) i}));
+        }
+
+        ip->id = htons(0);
+        CHECK_FALSE(d.is_duplicate(ip, ip_5t, ip_len, {10, 10}));
+
+        ip->id = htons(pkt_dedup::WAYS);
+        CHECK(d.is_duplicate(ip, ip_5t, ip_len, {10, 10}));
+
+        CHECK_THROWS(pkt_dedup(1000, 3));
+    }
+
+    SECTION("fills even and odd buckets") {
+
+        pkt_dedup d(1000000, 2);
+        std::vector<std::uint16_t> ids[2];
+
+        // pick WAYS packets per bucket, all of them fit if both buckets are used
+        for (std::uint16_t id = 0; ids[0].size() < pkt_dedup::WAYS
+                                   || ids[1].size() < pkt_dedup::WAYS; id++) {
+            REQUIRE(id < 1000);
+            ip->id = htons(id);
+            auto& bucket_ids = ids[pkt_dedup::fingerprint(ip, ip_5t, ip_len) & 1u];
+            if (bucket_ids.size() < pkt_dedup::WAYS) bucket_ids.push_back(id);
+        }
+
+        for (auto& bucket_ids: ids) {
+            for (auto id: bucket_ids) {
+                ip->id = htons(id);
+                CHECK_FALSE(d.is_duplicate(ip, ip_5t, ip_len, {10, 0}));
+            }
+        }
+
+        for (auto& bucket_ids: ids) {
+            for (auto id: bucket_ids) {
+                ip->id = htons(id);
+                CHECK(d.is_duplicate(ip, ip_5t, ip_len, {10, 1}));
+            }
+        }
+
+        CHECK(d.dropped_count() == 2 * pkt_dedup::WAYS);
+    }
+
+    SECTION("can be saved and restored") {
+
+        auto file_name = (std::filesystem::temp_directory_path() / "zoom_analysis_dedup.ckpt").string();
+
+        pkt_dedup d(1000);
+        CHECK_FALSE(d.is_duplicate(ip, ip_5t, ip_len, {10, 0}));
+
+        {
+            checkpoint::writer w(file_name, "test");
+            d.save(w);
+            w.commit();
+        }
+
+        pkt_dedup restored(1000);
+        checkpoint::reader r(file_name, "test");
+        restored.restore(r);
+
+        CHECK(restored.is_duplicate(ip, ip_5t, ip_len, {10, 100}));
+        CHECK(restored.checked_count() == 2);
+
+        pkt_dedup other_window(2000);
+        checkpoint::reader r2(file_name, "test");
+        CHECK_THROWS(other_window.restore(r2));
+
+        std::filesystem::remove(file_name);
+    }
+}
@@ -0,0 +1,213 @@
+
+#include <algorithm>
+#include <catch.h>
+#include <cmath>
+#include <filesystem>
+#include <vector>
+
+#include "lib/quantile_sketch.h"
+#include "lib/rtp_stream_analyzer.h"
+
+namespace {
+
+    //! log-normally distributed values between roughly 0.01 and 10^4
+    std::vector<double> values(unsigned n, std::uint32_t seed = 1) {
+
+        std::vector<double> values;
+        std::uint32_t x = seed;
+
+        for (unsigned i = 0; i < n; i++) {
+            x = x * 1103515245 + 12345;
+            values.push_back(std::exp((double) ((x >> 8) % 13000) / 1000 - 4.5));
+        }
+
+        return values;
+    }
+
+    //! value at the same rank as ddsketch::quantile()
+    double exact_quantile(std::vector<double> values, double q) {
+
+        std::sort(values.begin(), values.end());
+        return values[(std::size_t) (q * (double) (values.size() - 1))];
+    }
+}
+
+TEST_CASE("ddsketch", "[quantile_sketch]") {
+
+    SECTION("is empty without values") {
+
+        ddsketch s;
+
+        CHECK(s.empty());
+        CHECK(s.count() == 0);
+        CHECK(s.quantile(0.5) == -1);
+    }
+
+    SECTION("quantiles are within the relative accuracy") {
+
+        auto v = values(10000);
+        ddsketch s(0.01);
+
+        for (auto x: v)
+            s.add(x);
+
+        CHECK(s.count() == v.size());
+
+        for (auto q: {0.0, 0.01, 0.25, 0.5, 0.95, 0.99, 1.0}) {
+            auto expected = exact_quantile(v, q);
+            CHECK(std::abs(s.quantile(q) - expected) <= 0.01 * expected);
+        }
+    }
+
+    SECTION("counts values below MIN_VALUE as 0") {
+
+        ddsketch s;
+
+        for (auto x: {0.0, -5.0, 0.0, 20.0})
+            s.add(x);
+
+        CHECK(s.quantile(0) == 0);
+        CHECK(s.quantile(0.5) == 0);
+        CHECK(s.quantile(1) == Approx(20).epsilon(0.01));
+    }
+
+    SECTION("merged sketches are the same as one sketch of all values") {
+
+        auto a_values = values(5000, 1), b_values = values(3000, 2);
+        ddsketch a, b, all;
+
+        for (auto x: a_values)
+            a.add(x), all.add(x);
+
+        for (auto x: b_values)
+            b.add(x * 100), all.add(x * 100);
+
+        a.merge(b);
+        CHECK(a.count() == all.count());
+
+        for (auto q: {0.0, 0.1, 0.5, 0.9, 0.99, 1.0})
+            CHECK(a.quantile(q) == all.quantile(q));
+
+        CHECK_THROWS_AS(a.merge(ddsketch(0.02)), std::invalid_argument);
+    }
+
+    SECTION("collapses the lowest bins beyond max_bins") {
+
+        ddsketch s(0.01, 64);
+
+        for (auto x: values(10000))
+            s.add(x);
+
+        // the range covers about 650 bins, the upper quantiles keep their accuracy
+        auto v = values(10000);
+        auto p99 = exact_quantile(v, 0.99);
+        CHECK(std::abs(s.quantile(0.99) - p99) <= 0.01 * p99);
+        CHECK(s.quantile(0.01) > exact_quantile(v, 0.01));
+    }
+
+    SECTION("clear() removes all values") {
+
+        ddsketch s;
+
+        for (auto x: values(100))
+            s.add(x);
+
+        s.clear();
+        CHECK(s.empty());
+        CHECK(s.quantile(0.5) == -1);
+
+        s.add(3);
+        CHECK(s.quantile(0.5) == Approx(3).epsilon(0.01));
+    }
+
+    SECTION("can be saved and restored") {
+
+        const auto file_name = (std::filesystem::temp_directory_path()
+                                / "zoom_analysis_quantile_sketch_test.ckpt").string();
+
+        auto v = values(2000);
+        ddsketch a(0.02), b;
+
+        for (unsigned i = 0; i < 1000; i++)
+            a.add(v[i]);
+
+        {
+            checkpoint::writer w(file_name, "test");
+            a.save(w);
+            w.commit();
+        }
+
+        checkpoint::reader r(file_name, "test");
+        b.restore(r);
+
+        CHECK(b.rel_accuracy() == 0.02);
+
+        for (unsigned i = 1000; i < v.size(); i++)
+            a.add(v[i]), b.add(v[i]);
+
+        for (auto q: {0.0, 0.5, 0.99})
+            CHECK(b.quantile(q) == a.quantile(q));
+
+        std::filesystem::remove(file_name);
+    }
+}
+
+TEST_CASE("rtp_stream_analyzer: frame quantiles", "[quantile_sketch]") {
+
+    std::vector<double> p50_1s, p50_10s;
+    std::vector<std::uint64_t> counts_1s;
+
+    rtp_stream_analyzer<> a(
+        [](const auto&, const auto&) { },
+        [&](const auto& analyzer, unsigned, unsigned, const auto&) {
+            counts_1s.push_back(analyzer.reported_sketches(1)->frame_size.count());
+            p50_1s.push_back(analyzer.reported_sketches(1)->frame_gap_ms.quantile(0.5));
+        });
+
+    a.set_rollup_handler([&](const auto& analyzer, unsigned resolution_s, unsigned, unsigned,
+                             const auto&) {
+        if (resolution_s == 10)
+            p50_10s.push_back(analyzer.reported_sketches(10)->frame_gap_ms.quantile(0.5));
+    });
+
+    CHECK(a.reported_sketches(1) == nullptr);
+    a.enable_quantiles();
+    CHECK(a.quantiles_enabled());
+
+    // single-packet frames at 25 fps (40 ms apart) for 12 s, then at 50 fps for 12 s
+    std::int64_t us = 0;
+    std::uint32_t rtp_ts = 1;
+
+    for (unsigned i = 0; i < 900; i++) {
+        a.add(i + 1, rtp_ts, {(long) (us / 1000000), (long) (us % 1000000)}, 1000 + i % 2, {});
+        us += i < 300 ? 40000 : 20000;
+        rtp_ts += i < 300 ? 3600 : 1800;
+    }
+
+    a.finish();
+
+    REQUIRE(p50_1s.size() == 24);
+    CHECK(p50_1s[5] == Approx(40).epsilon(0.01));
+    CHECK(p50_1s[20] == Approx(20).epsilon(0.01));
+    CHECK(p50_10s.size() == 3);
+    CHECK(p50_10s[0] == Approx(40).epsilon(0.01));
+    CHECK(p50_10s[2] == Approx(20).epsilon(0.01));
+
+    std::uint64_t frames = 0;
+
+    for (auto n: counts_1s)
+        frames += n;
+
+    auto s = a.stream_sketches();
+    CHECK(frames == 900);
+    CHECK(s.frame_size.count() == 900);
+    CHECK(s.frame_gap_ms.count() == 899);
+    CHECK(s.frame_size.quantile(1) == Approx(1001).epsilon(0.01));
+
+    // copies get their own sketches
+    auto b = a;
+    b.reset();
+    CHECK(b.quantiles_enabled());
+    CHECK(b.stream_sketches().frame_size.empty());
+    CHECK(a.stream_sketches().frame_size.count() == 900);
+}
@@ -0,0 +1,118 @@
+
+#include <catch.h>
+#include <vector>
+
+#include "lib/rtp_stream_analyzer.h"
+
+namespace {
+
+    struct report {
+        unsigned resolution_s, report_count, ts;
+        unsigned long pkts;
+
+        bool operator==(const report& other) const {
+            return resolution_s == other.resolution_s && report_count == other.report_count
+                   && ts == other.ts && pkts == other.pkts;
+        }
+    };
+
+    struct recording_sink {
+        std::vector<unsigned>* frames;
+        std::vector<report>* reports;
+
+        template <typename Analyzer, typename Frame>
+        void frame(const Analyzer&, const Frame& f) {
+            frames->push_back(f.rtp_ts);
+        }
+
+        template <typename Analyzer, typename Stats>
+        void stats(const Analyzer&, unsigned report_count, unsigned ts, const Stats& c) {
+            reports->push_back({1, report_count, ts, c.total_pkts});
+        }
+
+        template <typename Analyzer, typename Stats>
+        void rollup(const Analyzer&, unsigned resolution_s, unsigned report_count, unsigned ts,
+                    const Stats& c) {
+            reports->push_back({resolution_s, report_count, ts, c.total_pkts});
+        }
+    };
+
+    //! 25 s of 3 packets per frame and 10 frames per second
+    template <typename Analyzer>
+    void add_pkts(Analyzer& a) {
+
+        for (unsigned i = 0; i < 750; i++) {
+            a.add(i + 1, i / 3 * 9000 + 1, {(long) (i / 30), (long) (i % 30) * 33333}, 1000, {});
+        }
+
+        a.flush();
+    }
+}
+
+TEST_CASE("rtp_stream_analyzer: sinks and std::function handlers", "[rtp_stream_analyzer]") {
+
+    std::vector<unsigned> frames_fn, frames_sink;
+    std::vector<report> reports_fn, reports_sink;
+
+    rtp_stream_analyzer<> a(
+        [&](const auto&, const auto& f) { frames_fn.push_back(f.rtp_ts); },
+        [&](const auto&, unsigned report_count, unsigned ts, const auto& c) {
+            reports_fn.push_back({1, report_count, ts, c.total_pkts});
+        });
+
+    a.set_rollup_handler([&](const auto&, unsigned resolution_s, unsigned report_count,
+                             unsigned ts, const auto& c) {
+        reports_fn.push_back({resolution_s, report_count, ts, c.total_pkts});
+    });
+
+    rtp_stream_analyzer<rtp_stream_analyzer_empty_meta, rtp_stream_analyzer_empty_meta, 32,
+                        recording_sink> b(recording_sink{&frames_sink, &reports_sink});
+
+    add_pkts(a);
+    add_pkts(b);
+
+    CHECK(frames_fn.size() == 250);
+    CHECK(frames_sink == frames_fn);
+    CHECK(reports_sink == reports_fn);
+
+    // 1s reports of seconds 0 to 23 and the 10s reports of seconds 0 to 9 and 10 to 19, which
+    // follow the 1s reports of seconds 10 and 20
+    REQUIRE(reports_fn.size() == 24 + 2);
+    CHECK(reports_fn[11] == report{10, 0, 0, 300});
+    CHECK(reports_fn[22] == report{10, 1, 10, 300});
+
+    SECTION("the stats handler is optional") {
+
+        unsigned frames = 0;
+        rtp_stream_analyzer<> c([&](const auto&, const auto&) { frames++; }, nullptr);
+        add_pkts(c);
+        CHECK(frames == frames_fn.size());
+    }
+}
+
+TEST_CASE("rtp_stream_analyzer: frame timestamps across hours", "[rtp_stream_analyzer]") {
+
+    // 3 packets per frame and one frame per 100 s for ~8 h, the ring moves its timestamp base
+    std::vector<std::pair<timeval, timeval>> frames;
+
+    rtp_stream_analyzer<> a([&](const auto&, const auto& f) {
+        frames.emplace_back(f.ts_min, f.ts_max);
+    }, nullptr);
+
+    for (unsigned i = 0; i < 900; i++) {
+        a.add(i + 1, i / 3 * 9000 + 1, {(long) (1600000000 + i / 3 * 100), (long) (i % 3) * 333331},
+              1000, {});
+    }
+
+    a.flush();
+
+    REQUIRE(frames.size() == 300);
+
+    for (unsigned i = 0; i < frames.size(); i++) {
+        INFO("frame " << i);
+        CHECK(frames[i].first.tv_sec == 1600000000 + i * 100);
+        CHECK(frames[i].first.tv_usec == 0);
+        CHECK(frames[i].second.tv_sec == 1600000000 + i * 100);
+        CHECK(frames[i].second.tv_usec == 666662);
+    }
+}
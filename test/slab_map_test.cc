@@ -0,0 +1,112 @@
+
+#include <catch.h>
+#include <string>
+#include <vector>
+
+#include "lib/slab_map.h"
+
+namespace {
+
+    //! puts all keys into the same index slot
+    struct colliding_hash {
+        std::size_t operator()(unsigned) const { return 7; }
+    };
+}
+
+TEST_CASE("slab_map", "[slab_map]") {
+
+    SECTION("handles are assigned in insertion order and stay valid") {
+
+        slab_map<unsigned, std::string, std::hash<unsigned>, 4> m;
+        CHECK(m.empty());
+        CHECK(m.find(1) == decltype(m)::NONE);
+
+        std::vector<const std::string*> values;
+
+        for (unsigned i = 0; i < 100; i++) {
+            auto [h, inserted] = m.emplace(i * 3, std::to_string(i));
+            CHECK(h == i);
+            CHECK(inserted);
+            values.push_back(&m[h]);
+        }
+
+        auto [h, inserted] = m.emplace(30, "x");
+        CHECK(h == 10);
+        CHECK_FALSE(inserted);
+        CHECK(m.size() == 100);
+
+        // growing the index and the chunks does not move values
+        for (unsigned i = 0; i < 100; i++) {
+            CHECK(m.find(i * 3) == i);
+            CHECK(m.key(i) == i * 3);
+            CHECK(&m[i] == values[i]);
+            CHECK(m[i] == std::to_string(i));
+        }
+
+        CHECK(m.find(1) == decltype(m)::NONE);
+
+        // 25 chunks of 4 entries and an index of 256 slots
+        CHECK(m.bytes() >= 100 * sizeof(std::pair<unsigned, std::string>) + 256 * 8);
+
+        m.clear();
+        CHECK(m.empty());
+        CHECK(m.find(3) == decltype(m)::NONE);
+        CHECK(m.emplace(3, "3").first == 0);
+    }
+
+    SECTION("colliding keys are probed") {
+
+        slab_map<unsigned, unsigned, colliding_hash> m;
+
+        for (unsigned i = 0; i < 20; i++)
+            m.emplace(i, i * 2);
+
+        for (unsigned i = 0; i < 20; i++)
+            CHECK(m[m.find(i)] == i * 2);
+
+        CHECK(m.find(20) == decltype(m)::NONE);
+    }
+
+    SECTION("erased slots are reused and colliding keys stay reachable") {
+
+        slab_map<unsigned, std::string, colliding_hash, 4> m;
+
+        for (unsigned i = 0; i < 10; i++)
+            m.emplace(i, std::to_string(i));
+
+        auto* value_3 = &m[3];
+        m.erase(3);
+        m.erase(0);
+
+        CHECK(m.size() == 8);
+        CHECK(m.find(3) == decltype(m)::NONE);
+        CHECK(m.find(0) == decltype(m)::NONE);
+        CHECK(m.handles() == std::vector<std::uint32_t>{1, 2, 4, 5, 6, 7, 8, 9});
+
+        for (unsigned i = 4; i < 10; i++)
+            CHECK(m[m.find(i)] == std::to_string(i));
+
+        // the most recently freed slot is reused first
+        auto [h, inserted] = m.emplace(42, "42");
+        CHECK(inserted);
+        CHECK(h == 0);
+        CHECK(m.emplace(43, "43").first == 3);
+        CHECK(&m[3] == value_3);
+        CHECK(m[m.find(42)] == "42");
+        CHECK(m.size() == 10);
+    }
+
+    SECTION("erase shifts back entries of the same probe sequence") {
+
+        slab_map<unsigned, unsigned> m;
+
+        for (unsigned i = 0; i < 1000; i++)
+            m.emplace(i, i);
+
+        for (unsigned i = 0; i < 1000; i += 2)
+            m.erase(m.find(i));
+
+        for (unsigned i = 0; i < 1000; i++)
+            CHECK((m.find(i) == decltype(m)::NONE) == (i % 2 == 0));
+    }
+}
@@ -0,0 +1,70 @@
+
+#include <catch.h>
+#include <thread>
+
+#include "lib/spsc_queue.h"
+
+TEST_CASE("spsc_queue", "[spsc_queue]") {
+
+    SECTION("items are popped in FIFO order until the queue is empty") {
+
+        spsc_queue<unsigned> q(4);
+        unsigned item = 0;
+
+        CHECK(q.capacity() == 4);
+        CHECK(q.empty());
+        CHECK_FALSE(q.try_pop(item));
+
+        for (unsigned i = 0; i < 4; i++)
+            CHECK(q.try_push(i));
+
+        CHECK_FALSE(q.try_push(4));
+        CHECK(q.size() == 4);
+
+        for (unsigned i = 0; i < 4; i++) {
+            CHECK(q.try_pop(item));
+            CHECK(item == i);
+        }
+
+        CHECK_FALSE(q.try_pop(item));
+
+        // indices wrap around the ring
+        CHECK(q.try_push(5));
+        CHECK(q.try_pop(item));
+        CHECK(item == 5);
+    }
+
+    SECTION("size must be power of two") {
+        CHECK_THROWS(spsc_queue<unsigned>(0));
+        CHECK_THROWS(spsc_queue<unsigned>(6));
+    }
+
+    SECTION("keeps the order between two threads") {
+
+        const unsigned n = 100000;
+        spsc_queue<unsigned> q(64);
+        bool in_order = true;
+
+        std::thread consumer([&]() {
+
+            unsigned item, expected = 0;
+
+            while (expected < n) {
+                if (q.try_pop(item)) {
+                    in_order &= (item == expected++);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+
+        for (unsigned i = 0; i < n; i++) {
+            while (!q.try_push(i))
+                std::this_thread::yield();
+        }
+
+        consumer.join();
+        CHECK(in_order);
+        CHECK(q.empty());
+    }
+}
@@ -0,0 +1,43 @@
+#include <catch.h>
+#include <filesystem>
+#include <fstream>
+
+#include "lib/util.h"
+
+TEST_CASE("util::files_in_directory", "[util]") {
+
+    const auto dir = std::filesystem::temp_directory_path() / "zoom_analysis_util_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directory(dir);
+
+    for (const auto& name: {"a.pcap", "a.pcap12", "b.pcapng", "b.pcapng3", "flows.csv",
+                            "pkts.zpkt", "c.pcapx", ".hidden.pcap"}) {
+        std::ofstream(dir / name);
+    }
+
+    std::filesystem::create_directory(dir / "sub.pcap");
+
+    SECTION("filters by extension with an optional sequence number") {
+
+        auto files = util::files_in_directory(dir.string(), {"pcap", "pcapng"});
+        std::vector<std::string> names;
+
+        for (const auto& f: files)
+            names.push_back(std::filesystem::path(f).filename().string());
+
+        CHECK(names == std::vector<std::string>{"a.pcap", "a.pcap12", "b.pcapng", "b.pcapng3"});
+
+        CHECK(util::files_in_directory(dir.string(), {"pcap"}).size() == 2);
+    }
+
+    SECTION("lists all non-hidden files without extensions") {
+        CHECK(util::files_in_directory(dir.string()).size() == 7);
+    }
+
+    SECTION("returns a single file as is") {
+        auto file = (dir / "flows.csv").string();
+        CHECK(util::files_in_directory(file, {"pcap"}) == std::vector<std::string>{file});
+    }
+
+    std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,618 @@
+
+#include <algorithm>
+#include <catch.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include "lib/zoom_offline_analyzer.h"
+#include "lib/zoom_parallel_analyzer.h"
+
+namespace {
+
+    std::string tmp_path(const std::string& name) {
+        return (std::filesystem::temp_directory_path() / ("zoom_analysis_" + name)).string();
+    }
+
+    std::string read_file(const std::string& path) {
+        std::ifstream is(path);
+        std::stringstream ss;
+        ss << is.rdbuf();
+        return ss.str();
+    }
+
+    //! secs s (starting at start_s) of a video stream with 2 packets per frame and 30 frames per
+    //! second
+    std::vector<zoom::pkt> video_pkts(unsigned secs = 3, unsigned ssrc = 1234,
+                                      unsigned start_s = 10) {
+
+        std::vector<zoom::pkt> pkts;
+
+        for (unsigned i = 0; i < secs * 60; i++) {
+
+            zoom::pkt pkt;
+            pkt.flags.srv = 1, pkt.flags.rtp = 1;
+            pkt.ip_5t = {0x0a000001, 0x0a000002, 8801, 50000, 17};
+            pkt.zoom_media_type = zoom::VIDEO_TYPE;
+            pkt.pkts_in_frame = 2;
+            pkt.proto.rtp = {.ssrc = ssrc, .ts = 3000 * (i / 2), .seq = (std::uint16_t) i, .pt = 98};
+            pkt.ts = {start_s + i / 60, (i % 60) * 16666};
+            pkt.udp_pl_len = 1000, pkt.pcap_frame_len = 1042;
+            pkts.push_back(pkt);
+        }
+
+        return pkts;
+    }
+
+    //! CSV rows below the header, split into columns
+    std::vector<std::vector<std::string>> read_rows(const std::string& path) {
+
+        std::vector<std::vector<std::string>> rows;
+        std::ifstream is(path);
+        std::string line, col;
+        std::getline(is, line);
+
+        while (std::getline(is, line)) {
+
+            std::stringstream ss(line);
+            rows.emplace_back();
+
+            while (std::getline(ss, col, ','))
+                rows.back().push_back(col);
+        }
+
+        return rows;
+    }
+
+    void run(zoom::offline_analyzer& a, const std::string& prefix) {
+
+        a.enable_pkt_log(tmp_path(prefix + "_pkts.csv"));
+        a.enable_frame_log(tmp_path(prefix + "_frames.csv"));
+        a.enable_stats_log(tmp_path(prefix + "_stats.csv"));
+
+        for (const auto& pkt: video_pkts())
+            a.add(pkt);
+
+        a.flush_logs();
+    }
+}
+
+TEST_CASE("zoom::analyzer: async logs", "[zoom_analyzer]") {
+
+    SECTION("write the same rows as synchronous logs") {
+
+        zoom::offline_analyzer sync, async;
+        async.enable_async_logs(8);
+
+        run(sync, "sync");
+        run(async, "async");
+
+        for (const auto& log: {"_pkts.csv", "_frames.csv", "_stats.csv"}) {
+            auto expected = read_file(tmp_path(std::string("sync") + log));
+            CHECK(std::count(expected.begin(), expected.end(), '\n') > 1);
+            CHECK(read_file(tmp_path(std::string("async") + log)) == expected);
+        }
+
+        auto stats = async.async_stats();
+        CHECK(stats.queue_len == 8);
+        CHECK(stats.rows > 180);
+        CHECK(stats.max_depth <= 8);
+        CHECK(stats.drops == 0);
+        CHECK(sync.async_stats().rows == 0);
+
+        CHECK_THROWS(async.enable_async_logs());
+    }
+
+    SECTION("count dropped rows") {
+
+        zoom::offline_analyzer a;
+        a.enable_async_logs(8, zoom::analyzer::overflow_policy::drop);
+        run(a, "drop");
+
+        auto stats = a.async_stats();
+        auto pkts = read_file(tmp_path("drop_pkts.csv"));
+        auto frames = read_file(tmp_path("drop_frames.csv"));
+        auto stats_rows = read_file(tmp_path("drop_stats.csv"));
+
+        // every row is either written (below the header) or counted as dropped
+        CHECK(std::count(pkts.begin(), pkts.end(), '\n')
+              + std::count(frames.begin(), frames.end(), '\n')
+              + std::count(stats_rows.begin(), stats_rows.end(), '\n') - 3
+              == (std::ptrdiff_t) stats.rows);
+        CHECK(stats.rows + stats.drops > 180);
+        CHECK(stats.stalls == 0);
+    }
+
+    SECTION("write Arrow IPC logs") {
+
+        zoom::offline_analyzer a;
+        a.enable_pkt_log(tmp_path("arrow_pkts.csv"), false, zoom::analyzer::log_format::arrow);
+
+        for (const auto& pkt: video_pkts())
+            a.add(pkt);
+
+        CHECK(a.flush_logs().pkt == -1);
+        CHECK_THROWS(a.enable_frame_log(tmp_path("arrow_frames.csv"), true,
+                                        zoom::analyzer::log_format::arrow));
+    }
+
+    for (const auto& prefix: {"sync", "async", "drop", "arrow"}) {
+        for (const auto& log: {"_pkts.csv", "_frames.csv", "_stats.csv"})
+            std::filesystem::remove(tmp_path(std::string(prefix) + log));
+    }
+}
+
+TEST_CASE("zoom::analyzer: stats rollups", "[zoom_analyzer]") {
+
+    zoom::offline_analyzer a, b;
+    a.enable_stats_log(tmp_path("rollup_stats.csv"));
+    a.enable_stats_log(tmp_path("rollup_stats10.csv"), false, zoom::analyzer::log_format::csv, 10);
+
+    // rollups do not depend on the 1s log
+    b.enable_stats_log(tmp_path("rollup_stats60.csv"), false, zoom::analyzer::log_format::csv, 60);
+    b.enable_stats_log(tmp_path("rollup_stats10b.csv"), false, zoom::analyzer::log_format::csv, 10);
+
+    CHECK_THROWS_AS(a.enable_stats_log(tmp_path("rollup_stats5.csv"), false,
+                                       zoom::analyzer::log_format::csv, 5), std::invalid_argument);
+
+    // seconds 10 to 34, the last second and the intervals it belongs to are not reported yet
+    for (const auto& pkt: video_pkts(25)) {
+        a.add(pkt);
+        b.add(pkt);
+    }
+
+    auto pos = a.flush_logs();
+    CHECK(pos.stats_rollups[0] > 0);
+    CHECK(pos.stats_rollups[1] == -1);
+    CHECK(b.flush_logs().stats == -1);
+
+    auto stats = read_rows(tmp_path("rollup_stats.csv"));
+    auto stats10 = read_rows(tmp_path("rollup_stats10.csv"));
+
+    CHECK(stats.size() == 24);
+    REQUIRE(stats10.size() == 2);
+    CHECK(read_rows(tmp_path("rollup_stats60.csv")).empty());
+    CHECK(read_file(tmp_path("rollup_stats10b.csv")) == read_file(tmp_path("rollup_stats10.csv")));
+
+    // each 10s row (ts_s, report_count, ..., pkts, bytes, ..., frames) sums up its 1s rows
+    for (unsigned i = 0; i < stats10.size(); i++) {
+
+        unsigned long pkts = 0, bytes = 0, frames = 0;
+
+        for (const auto& row: stats) {
+            if (std::stoul(row[0]) / 10 == std::stoul(stats10[i][0]) / 10) {
+                pkts += std::stoul(row[9]), bytes += std::stoul(row[10]);
+                frames += std::stoul(row[14]);
+            }
+        }
+
+        CHECK(stats10[i][0] == std::to_string(10 + i * 10));
+        CHECK(stats10[i][1] == std::to_string(i));
+        CHECK(std::stoul(stats10[i][9]) == pkts);
+        CHECK(std::stoul(stats10[i][10]) == bytes);
+        CHECK(std::stoul(stats10[i][14]) == frames);
+        CHECK(pkts == 600);
+    }
+
+    for (const auto& log: {"", "10", "10b", "60", "5"})
+        std::filesystem::remove(tmp_path(std::string("rollup_stats") + log + ".csv"));
+}
+
+TEST_CASE("zoom::analyzer: idle streams are retired", "[zoom_analyzer]") {
+
+    // stream 1 ends after 3 s, stream 2 continues for 20 s
+    auto pkts = video_pkts(3, 1);
+    auto pkts_2 = video_pkts(20, 2);
+    pkts.insert(pkts.end(), pkts_2.begin(), pkts_2.end());
+
+    std::stable_sort(pkts.begin(), pkts.end(), [](const auto& a, const auto& b) {
+        return a.ts.s < b.ts.s || (a.ts.s == b.ts.s && a.ts.us < b.ts.us);
+    });
+
+    zoom::offline_analyzer a;
+    a.enable_streams_log(tmp_path("idle_streams.csv"));
+    a.enable_frame_log(tmp_path("idle_frames.csv"));
+    a.enable_stats_log(tmp_path("idle_stats.csv"));
+    a.set_idle_timeout(5);
+
+    for (const auto& pkt: pkts)
+        a.add(pkt);
+
+    a.flush_logs();
+
+    CHECK(a.active_streams() == 1);
+    CHECK(a.retired_streams() == 1);
+
+    // stream 1 reported all of its 90 frames and its last second
+    auto count_rows = [](const std::string& path, unsigned col, const std::string& ssrc) {
+        auto rows = read_rows(path);
+        return std::count_if(rows.begin(), rows.end(), [&](const auto& r) { return r[col] == ssrc; });
+    };
+
+    auto streams = read_rows(tmp_path("idle_streams.csv"));
+    REQUIRE(streams.size() == 1);
+    CHECK(streams[0][0] == "1");
+    CHECK(streams[0][13] == "180");
+    CHECK(count_rows(tmp_path("idle_frames.csv"), 5, "1") == 90);
+    CHECK(count_rows(tmp_path("idle_stats.csv"), 2, "1") == 3);
+
+    a.retire_streams();
+    a.write_streams_log();
+    a.flush_logs();
+
+    CHECK(a.active_streams() == 0);
+    CHECK(read_rows(tmp_path("idle_streams.csv")).size() == 2);
+    CHECK(count_rows(tmp_path("idle_frames.csv"), 5, "2") == 600);
+    CHECK(count_rows(tmp_path("idle_stats.csv"), 2, "2") == 20);
+
+    for (const auto& log: {"streams", "frames", "stats"})
+        std::filesystem::remove(tmp_path(std::string("idle_") + log + ".csv"));
+}
+
+TEST_CASE("zoom::offline_analyzer: ring length by media type", "[zoom_analyzer]") {
+
+    // one stream per media type, the same packets except for the type
+    std::vector<zoom::pkt> pkts;
+
+    for (auto [type, ssrc]: {std::pair{zoom::AUDIO_TYPE, 1u}, {zoom::VIDEO_TYPE, 2u},
+                             {zoom::SRV_SCREEN_SHARE_TYPE, 3u}}) {
+
+        for (auto pkt: video_pkts(2, ssrc)) {
+            pkt.zoom_media_type = type;
+            pkts.push_back(pkt);
+        }
+    }
+
+    zoom::offline_analyzer a;
+
+    for (const auto& pkt: pkts)
+        a.add(pkt);
+
+    auto memory = a.memory_usage();
+    CHECK(a.active_streams() == 3);
+
+    CHECK(memory[0].ring_len == zoom::offline_analyzer::AUDIO_RING_LEN);
+    CHECK(memory[1].ring_len == zoom::offline_analyzer::VIDEO_RING_LEN);
+    CHECK(memory[2].ring_len == zoom::offline_analyzer::SCREEN_RING_LEN);
+
+    for (const auto& m: memory) {
+        CHECK(m.streams == 1);
+        CHECK(m.bytes >= m.stream_bytes);
+    }
+
+    CHECK(memory[0].stream_bytes < memory[1].stream_bytes);
+    CHECK(memory[1].stream_bytes < memory[2].stream_bytes);
+
+    // each stream is restored into the map of its type
+    {
+        checkpoint::writer w(tmp_path("ring_len.ckpt"), "test");
+        a.save(w);
+        w.commit();
+    }
+
+    zoom::offline_analyzer b;
+    checkpoint::reader r(tmp_path("ring_len.ckpt"), "test");
+    b.restore(r);
+
+    for (const auto& m: b.memory_usage())
+        CHECK(m.streams == 1);
+
+    // retired streams keep their allocated memory for later streams
+    a.retire_streams();
+    CHECK(a.active_streams() == 0);
+    CHECK(a.memory_usage()[2].streams == 0);
+    CHECK(a.memory_usage()[2].bytes >= memory[2].bytes);
+
+    std::filesystem::remove(tmp_path("ring_len.ckpt"));
+}
+
+TEST_CASE("zoom::parallel_analyzer: same logs as offline_analyzer", "[zoom_analyzer]") {
+
+    // 12 streams of 2 to 5 s, several of them are retired at the same time
+    std::vector<zoom::pkt> pkts;
+
+    for (unsigned i = 0; i < 12; i++) {
+        auto stream = video_pkts(2 + i % 4, 100 + i, 10 + i % 3);
+        pkts.insert(pkts.end(), stream.begin(), stream.end());
+    }
+
+    std::stable_sort(pkts.begin(), pkts.end(), [](const auto& a, const auto& b) {
+        return a.ts.s < b.ts.s || (a.ts.s == b.ts.s && a.ts.us < b.ts.us);
+    });
+
+    auto run_analyzer = [&](auto& a, const std::string& prefix) {
+
+        a.enable_pkt_log(tmp_path(prefix + "_pkts.csv"));
+        a.enable_streams_log(tmp_path(prefix + "_streams.csv"));
+        a.enable_frame_log(tmp_path(prefix + "_frames.csv"));
+        a.enable_stats_log(tmp_path(prefix + "_stats.csv"));
+        a.enable_stats_log(tmp_path(prefix + "_stats10.csv"), false,
+                           zoom::analyzer::log_format::csv, 10);
+        a.set_idle_timeout(2);
+
+        for (const auto& pkt: pkts)
+            a.add(pkt);
+
+        a.retire_streams();
+        a.write_streams_log();
+        a.flush_logs();
+
+        CHECK(a.active_streams() == 0);
+        CHECK(a.retired_streams() == 12);
+    };
+
+    zoom::offline_analyzer offline;
+    run_analyzer(offline, "offline");
+
+    for (unsigned workers: {1, 3, 5}) {
+
+        zoom::parallel_analyzer parallel(workers, 16);
+        run_analyzer(parallel, "parallel");
+
+        for (const auto& log: {"pkts", "streams", "frames", "stats", "stats10"}) {
+            INFO(workers << " workers, " << log);
+            auto expected = read_file(tmp_path(std::string("offline_") + log + ".csv"));
+            CHECK(!expected.empty());
+            CHECK(read_file(tmp_path(std::string("parallel_") + log + ".csv")) == expected);
+        }
+    }
+
+    for (const auto& prefix: {"offline", "parallel"}) {
+        for (const auto& log: {"pkts", "streams", "frames", "stats", "stats10"})
+            std::filesystem::remove(tmp_path(std::string(prefix) + "_" + log + ".csv"));
+    }
+}
+
+TEST_CASE("zoom::analyzer: frame quantiles", "[zoom_analyzer]") {
+
+    auto run_analyzer = [](auto& a, const std::string& prefix) {
+
+        a.enable_quantiles();
+        a.enable_streams_log(tmp_path(prefix + "_q_streams.csv"));
+        a.enable_stats_log(tmp_path(prefix + "_q_stats.csv"));
+        a.enable_stats_log(tmp_path(prefix + "_q_stats10.csv"), false,
+                           zoom::analyzer::log_format::csv, 10);
+
+        for (unsigned ssrc: {1, 2}) {
+            for (const auto& pkt: video_pkts(12, ssrc))
+                a.add(pkt);
+        }
+
+        a.retire_streams();
+        a.flush_logs();
+    };
+
+    zoom::offline_analyzer offline;
+    run_analyzer(offline, "offline");
+
+    std::ifstream is(tmp_path("offline_q_stats.csv"));
+    std::string header;
+    std::getline(is, header);
+    CHECK(header.substr(header.find(",mean_jitter")) == ",mean_jitter,"
+          "jitter_ms_p50,jitter_ms_p95,jitter_ms_p99,frame_size_p50,frame_size_p95,frame_size_p99,"
+          "frame_gap_ms_p50,frame_gap_ms_p95,frame_gap_ms_p99,fps_p50,fps_p95,fps_p99");
+
+    // 30 frames per second of the same size, 33.3 ms apart
+    auto streams = read_rows(tmp_path("offline_q_streams.csv"));
+    REQUIRE(streams.size() == 2);
+
+    for (const auto& row: streams) {
+        REQUIRE(row.size() == 15 + 12);
+        CHECK(std::stod(row[18]) == Approx(std::stod(row[20])));
+        CHECK(std::stod(row[21]) == Approx(33.3).epsilon(0.01));
+        CHECK(std::stod(row[25]) == Approx(30).epsilon(0.01));
+    }
+
+    for (const auto& row: read_rows(tmp_path("offline_q_stats10.csv"))) {
+
+        REQUIRE(row.size() == 17 + 12);
+        CHECK(std::stod(row[20]) == Approx(std::stod(row[15])).epsilon(0.01));
+        CHECK(std::stod(row[23]) == Approx(33.3).epsilon(0.01));
+    }
+
+    zoom::parallel_analyzer parallel(2, 16);
+    run_analyzer(parallel, "parallel");
+
+    zoom::offline_analyzer async;
+    async.enable_async_logs(8);
+    run_analyzer(async, "async");
+
+    for (const auto& prefix: {"parallel", "async"}) {
+        for (const auto& log: {"streams", "stats", "stats10"}) {
+            INFO(prefix << ", " << log);
+            auto expected = read_file(tmp_path(std::string("offline_q_") + log + ".csv"));
+            CHECK(read_file(tmp_path(std::string(prefix) + "_q_" + log + ".csv")) == expected);
+        }
+    }
+
+    // quantiles are dropped along with their row, never on their own
+    zoom::offline_analyzer drop;
+    drop.enable_async_logs(8, zoom::analyzer::overflow_policy::drop);
+    run_analyzer(drop, "drop");
+
+    for (const auto& row: read_rows(tmp_path("drop_q_stats.csv")))
+        CHECK(row.size() == 17 + 12);
+
+    // checkpoints are only restored with quantiles enabled likewise, as the log columns differ
+    {
+        checkpoint::writer w(tmp_path("quantiles.ckpt"), "test");
+        offline.save(w);
+        w.commit();
+    }
+
+    zoom::offline_analyzer other;
+    checkpoint::reader r(tmp_path("quantiles.ckpt"), "test");
+    CHECK_THROWS_AS(other.restore(r), std::runtime_error);
+
+    zoom::offline_analyzer same;
+    same.enable_quantiles();
+    checkpoint::reader r2(tmp_path("quantiles.ckpt"), "test");
+    CHECK_NOTHROW(same.restore(r2));
+
+    std::filesystem::remove(tmp_path("quantiles.ckpt"));
+
+    // the quantiles are records of their own, which do not enlarge the other rows
+    CHECK(sizeof(zoom::analyzer::log_record)
+          == sizeof(std::variant<zoom::pkt, zoom::analyzer::frame_row, zoom::analyzer::stats_row,
+                                 zoom::analyzer::streams_row>));
+
+    for (const auto& prefix: {"offline", "parallel", "async", "drop"}) {
+        for (const auto& log: {"streams", "stats", "stats10"})
+            std::filesystem::remove(tmp_path(std::string(prefix) + "_q_" + log + ".csv"));
+    }
+}
+
+TEST_CASE("zoom::analyzer: stats are flushed at the end of the input", "[zoom_analyzer]") {
+
+    auto run_analyzer = [](auto& a, const std::string& prefix) {
+
+        a.enable_stats_log(tmp_path(prefix + "_flush_stats.csv"));
+        a.enable_stats_log(tmp_path(prefix + "_flush_stats300.csv"), false,
+                           zoom::analyzer::log_format::csv, 300);
+
+        // seconds 10 to 34 of two streams, shorter than one 300s interval
+        for (unsigned ssrc: {1, 2}) {
+            for (const auto& pkt: video_pkts(25, ssrc))
+                a.add(pkt);
+        }
+
+        a.flush_stats();
+        a.flush_logs();
+    };
+
+    zoom::offline_analyzer offline;
+    run_analyzer(offline, "offline");
+
+    auto stats = read_rows(tmp_path("offline_flush_stats.csv"));
+    auto stats300 = read_rows(tmp_path("offline_flush_stats300.csv"));
+
+    // (ts_s, report_count, ..., pkts, ...)
+    REQUIRE(stats.size() == 2 * 25);
+    REQUIRE(stats300.size() == 2);
+
+    for (const auto& row: stats300) {
+        CHECK(row[0] == "0");
+        CHECK(std::stoul(row[9]) == 25 * 60);
+    }
+
+    zoom::parallel_analyzer parallel(2, 16);
+    run_analyzer(parallel, "parallel");
+
+    for (const auto& log: {"stats", "stats300"}) {
+        INFO(log);
+        auto expected = read_file(tmp_path(std::string("offline_flush_") + log + ".csv"));
+        CHECK(read_file(tmp_path(std::string("parallel_flush_") + log + ".csv")) == expected);
+    }
+
+    for (const auto& prefix: {"offline", "parallel"}) {
+        for (const auto& log: {"stats", "stats300"})
+            std::filesystem::remove(tmp_path(std::string(prefix) + "_flush_" + log + ".csv"));
+    }
+}
+
+TEST_CASE("zoom::analyzer: IPv6 streams", "[zoom_analyzer]") {
+
+    zoom::offline_analyzer a;
+    a.enable_pkt_log(tmp_path("ipv6_pkts.csv"));
+    a.enable_frame_log(tmp_path("ipv6_frames.csv"));
+    a.enable_stats_log(tmp_path("ipv6_stats.csv"));
+
+    // an IPv6 flow whose address digests equal the addresses of an IPv4 flow
+    for (bool ipv6: {false, true}) {
+        for (auto pkt: video_pkts()) {
+            pkt.flags.ipv6 = ipv6;
+            a.add(pkt);
+        }
+    }
+
+    a.flush_stats();
+    a.flush_logs();
+
+    // column index of ip_src, ip_dst is 2 columns further
+    for (const auto& [log, ip_src_col]: {std::pair{"pkts", 5}, {"frames", 1}, {"stats", 5}}) {
+
+        INFO(log);
+        auto rows = read_rows(tmp_path(std::string("ipv6_") + log + ".csv"));
+        REQUIRE(!rows.empty());
+        REQUIRE(rows.size() % 2 == 0);
+
+        auto na_rows = std::count_if(rows.begin(), rows.end(), [&](const auto& row) {
+            return row[ip_src_col] == "NA" && row[ip_src_col + 2] == "NA";
+        });
+
+        auto ipv4_rows = std::count_if(rows.begin(), rows.end(), [&](const auto& row) {
+            return row[ip_src_col] == "10.0.0.1" && row[ip_src_col + 2] == "10.0.0.2";
+        });
+
+        // the streams are kept apart
+        CHECK(na_rows == (std::ptrdiff_t) rows.size() / 2);
+        CHECK(ipv4_rows == (std::ptrdiff_t) rows.size() / 2);
+
+        std::filesystem::remove(tmp_path(std::string("ipv6_") + log + ".csv"));
+    }
+
+    auto v4 = zoom::media_stream_key::from_pkt(video_pkts(1).front());
+    auto v6_pkt = video_pkts(1).front();
+    v6_pkt.flags.ipv6 = 1;
+    auto v6 = zoom::media_stream_key::from_pkt(v6_pkt);
+
+    CHECK_FALSE(v4 == v6);
+    CHECK(v4 < v6);
+    CHECK(std::hash<zoom::media_stream_key>{}(v4) != std::hash<zoom::media_stream_key>{}(v6));
+}
+
+TEST_CASE("zoom::analyzer: RFC 3550 jitter is selectable", "[zoom_analyzer]") {
+
+    auto run_analyzer = [](auto& a, const std::string& prefix) {
+
+        a.enable_frame_log(tmp_path(prefix + "_jitter_frames.csv"));
+
+        for (const auto& pkt: video_pkts())
+            a.add(pkt);
+
+        a.retire_streams();
+        a.flush_logs();
+        return read_rows(tmp_path(prefix + "_jitter_frames.csv"));
+    };
+
+    zoom::offline_analyzer ms, rfc3550;
+    rfc3550.enable_rfc3550_jitter();
+    CHECK_FALSE(ms.rfc3550_jitter());
+
+    auto ms_rows = run_analyzer(ms, "ms");
+    auto rfc3550_rows = run_analyzer(rfc3550, "rfc3550");
+
+    // the same frames, only the jitter (last column) differs
+    REQUIRE(ms_rows.size() == rfc3550_rows.size());
+    REQUIRE(!ms_rows.empty());
+    CHECK(ms_rows.front().size() == rfc3550_rows.front().size());
+    CHECK(ms_rows.back().back() != rfc3550_rows.back().back());
+
+    zoom::parallel_analyzer parallel(2, 16);
+    parallel.enable_rfc3550_jitter();
+    CHECK(run_analyzer(parallel, "parallel") == rfc3550_rows);
+
+    CHECK_THROWS_AS(ms.enable_rfc3550_jitter(), std::logic_error);
+    CHECK_THROWS_AS(parallel.enable_rfc3550_jitter(), std::logic_error);
+
+    // checkpoints are only restored with the same jitter calculator
+    {
+        checkpoint::writer w(tmp_path("jitter.ckpt"), "test");
+        rfc3550.save(w);
+        w.commit();
+    }
+
+    zoom::offline_analyzer other;
+    checkpoint::reader r(tmp_path("jitter.ckpt"), "test");
+    CHECK_THROWS_AS(other.restore(r), std::runtime_error);
+
+    zoom::offline_analyzer same;
+    same.enable_rfc3550_jitter();
+    checkpoint::reader r2(tmp_path("jitter.ckpt"), "test");
+    CHECK_NOTHROW(same.restore(r2));
+
+    for (const auto& prefix: {"ms", "rfc3550", "parallel"})
+        std::filesystem::remove(tmp_path(std::string(prefix) + "_jitter_frames.csv"));
+
+    std::filesystem::remove(tmp_path("jitter.ckpt"));
+}
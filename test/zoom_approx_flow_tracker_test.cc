@@ -0,0 +1,136 @@
+
+#include <catch.h>
+#include "lib/net.h"
+#include "lib/sketches.h"
+#include "lib/zoom_approx_flow_tracker.h"
+
+TEST_CASE("aging_bloom_filter", "[sketch][aging_bloom_filter]") {
+
+    aging_bloom_filter<net::ipv4_port> f(1 << 10, 3);
+
+    net::ipv4_port p1 = { net::ipv4::str_to_addr("10.0.0.6"), 12433 };
+    net::ipv4_port p2 = { net::ipv4::str_to_addr("10.0.0.7"), 12433 };
+
+    CHECK_FALSE(f.contains_and_refresh(p1, 10, 5));
+    f.insert(p1, 10);
+    CHECK(f.contains_and_refresh(p1, 12, 5));
+    CHECK(f.contains_and_refresh(p1, 17, 5));  // refreshed at 12
+    CHECK_FALSE(f.contains_and_refresh(p1, 23, 5));
+    CHECK_FALSE(f.contains_and_refresh(p2, 17, 5));
+
+    CHECK(f.fill_ratio() > 0.0);
+    f.expire(100, 5);
+    CHECK(f.fill_ratio() == 0.0);
+    CHECK(f.memory_bytes() == (1 << 10) * sizeof(std::uint32_t));
+
+    CHECK_THROWS(aging_bloom_filter<net::ipv4_port>(1000, 3));
+}
+
+TEST_CASE("count_min_sketch", "[sketch][count_min_sketch]") {
+
+    count_min_sketch<unsigned> s(1 << 8, 4);
+
+    for (unsigned i = 0; i < 1000; i++) {
+        s.add(i % 100, i % 100);
+    }
+
+    CHECK(s.total() == 49500);
+
+    for (unsigned k = 0; k < 100; k++) {
+        CHECK(s.estimate(k) >= 10 * k);
+        CHECK(s.estimate(k) <= 10 * k + s.error_bound());
+    }
+
+    CHECK(s.confidence() > 0.98);
+    CHECK_THROWS(count_min_sketch<unsigned>(1000, 4));
+}
+
+TEST_CASE("zoom::approx_flow_tracker", "[zoom][approx_flow_tracker]") {
+
+    net::ipv4_5tuple non_zoom_udp_flow {
+            net::ipv4::str_to_addr("128.52.6.140"), net::ipv4::str_to_addr("84.202.2.49"),
+            24242, 8809, 17
+    };
+
+    net::ipv4_5tuple zoom_udp_srv_flow {
+            net::ipv4::str_to_addr("13.52.6.140"), net::ipv4::str_to_addr("10.0.0.5"),
+            8805, 10293, 17
+    };
+
+    net::ipv4_5tuple zoom_stun_flow {
+            net::ipv4::str_to_addr("10.0.0.6"), net::ipv4::str_to_addr("209.9.215.34"),
+            12433, 3478, 17
+    };
+
+    net::ipv4_5tuple zoom_p2p_flow {
+            net::ipv4::str_to_addr("10.0.0.6"), net::ipv4::str_to_addr("10.0.0.7"),
+            12433, 40200, 17
+    };
+
+    const unsigned STUN_EXPIRATION = 10;
+
+    zoom::approx_flow_tracker a(zoom::approx_flow_tracker::config::for_memory(64 * 1024),
+                                STUN_EXPIRATION);
+    zoom::flow_tracker e(STUN_EXPIRATION);
+    zoom::approx_flow_tracker::comparison cmp;
+
+    SECTION("sizes its state according to the memory budget") {
+        CHECK(a.memory_bytes() <= 64 * 1024);
+        CHECK(a.memory_bytes() >= 32 * 1024);
+    }
+
+    SECTION("falls back to the minimal config for tiny budgets") {
+
+        for (std::size_t bytes: {0, 3}) {
+            auto c = zoom::approx_flow_tracker::config::for_memory(bytes);
+            CHECK(c.peer_filter_cells == 1);
+            CHECK(c.sketch_width == 1);
+        }
+    }
+
+    SECTION("classifies packets like the exact flow tracker") {
+
+        auto track = [&](const net::ipv4_5tuple& ip_5t, long ts_s, unsigned bytes) {
+            auto ef = e.track(ip_5t, {ts_s, 0}, bytes);
+            auto af = a.track(ip_5t, {ts_s, 0}, bytes);
+            cmp.add(ef, af);
+            return af;
+        };
+
+        CHECK_FALSE(track(non_zoom_udp_flow, 1, 100));
+        CHECK_FALSE(track(zoom_p2p_flow, 1, 100));
+
+        auto f1 = track(zoom_udp_srv_flow, 2, 100);
+        CHECK(f1);
+        CHECK(f1->type == zoom::flow_tracker::flow_type::udp_srv);
+
+        auto f2 = track(zoom_stun_flow, 3, 100);
+        CHECK(f2);
+        CHECK(f2->type == zoom::flow_tracker::flow_type::udp_stun);
+
+        for (long ts = 4; ts < 20; ts++) {
+            auto f3 = track(zoom_p2p_flow, ts, 200);
+            CHECK(f3);
+            CHECK(f3->type == zoom::flow_tracker::flow_type::udp_p2p);
+            CHECK(f3->pkts >= (unsigned long) ts - 3);
+        }
+
+        cmp.add_counter_errors(e, a);
+
+        CHECK(cmp.pkts == 20);
+        CHECK(cmp.agree == 20);
+        CHECK(cmp.false_positives == 0);
+        CHECK(cmp.false_negatives == 0);
+        CHECK(cmp.flows == 3);
+        CHECK(cmp.max_pkts_rel_error == 0.0);
+
+        CHECK(a.count_total_pkts_processed() == 20);
+        CHECK(a.count_zoom_pkts_detected() == 18);
+        CHECK(a.estimate(zoom_p2p_flow).bytes == 16 * 200);
+    }
+
+    SECTION("forgets p2p peers after stun expiration") {
+        CHECK(a.track(zoom_stun_flow, {1, 0}, 100));
+        CHECK_FALSE(a.track(zoom_p2p_flow, {1 + STUN_EXPIRATION + 1, 0}, 100));
+    }
+}
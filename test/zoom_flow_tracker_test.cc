@@ -2,6 +2,7 @@
 #include <catch.h>
 #include "lib/net.h"
 #include "lib/zoom_flow_tracker.h"
+#include "lib/zoom_nets.h"
 
 TEST_CASE("zoom::flow_tracker", "[zoom][flow_tracker]") {
 
@@ -167,3 +168,139 @@ TEST_CASE("zoom::flow_tracker", "[zoom][flow_tracker]") {
         }
     }
 }
+
+TEST_CASE("zoom::flow_tracker: bidirectional mode", "[zoom][flow_tracker]") {
+
+    net::ipv4_5tuple zoom_udp_srv_flow {
+            net::ipv4::str_to_addr("13.52.6.140"), net::ipv4::str_to_addr("10.0.0.5"),
+            8805, 10293, 17
+    };
+
+    net::ipv4_5tuple zoom_stun_flow {
+            net::ipv4::str_to_addr("10.0.0.6"), net::ipv4::str_to_addr("209.9.215.34"),
+            12433, 3478, 17
+    };
+
+    net::ipv4_5tuple zoom_p2p_flow {
+            net::ipv4::str_to_addr("10.0.0.7"), net::ipv4::str_to_addr("10.0.0.6"),
+            40200, 12433, 17
+    };
+
+    SECTION("canonicalizes 5-tuples") {
+        CHECK(zoom_udp_srv_flow.canonical() == zoom_udp_srv_flow.reversed().canonical());
+        CHECK(zoom_udp_srv_flow.reversed().reversed() == zoom_udp_srv_flow);
+        CHECK(zoom_udp_srv_flow.is_canonical() != zoom_udp_srv_flow.reversed().is_canonical());
+    }
+
+    SECTION("tracks both directions of a server flow in a single entry") {
+
+        zoom::flow_tracker t(300, true);
+        CHECK(t.bidirectional());
+
+        auto f1 = t.track(zoom_udp_srv_flow, {1, 0}, 100);
+        CHECK(f1);
+        CHECK(f1->id == 0);
+        CHECK(f1->dir == zoom::flow_tracker::flow_dir::from_srv);
+
+        auto f2 = t.track(zoom_udp_srv_flow.reversed(), {2, 0}, 50);
+        CHECK(f2);
+        CHECK(f2->id == 0);
+        CHECK(f2->type == zoom::flow_tracker::flow_type::udp_srv);
+        CHECK(f2->dir == zoom::flow_tracker::flow_dir::to_srv);
+        CHECK(f2->pkts == 2);
+        CHECK(f2->bytes == 150);
+        CHECK(f2->pkts_from_srv == 1);
+        CHECK(f2->bytes_from_srv == 100);
+        CHECK(f2->pkts_to_srv == 1);
+        CHECK(f2->bytes_to_srv == 50);
+
+        CHECK(t.flows().size() == 1);
+        CHECK(t.count_zoom_flows_detected() == 1);
+        CHECK(t.count_zoom_pkts_detected() == 2);
+
+        const auto& [key, stats] = *t.flows().begin();
+        CHECK(key == zoom_udp_srv_flow.canonical());
+        CHECK(stats.dir == (key == zoom_udp_srv_flow ? zoom::flow_tracker::flow_dir::from_srv
+                                                      : zoom::flow_tracker::flow_dir::to_srv));
+    }
+
+    SECTION("tracks both directions of a p2p flow in a single entry") {
+
+        zoom::flow_tracker t(300, true);
+
+        CHECK(t.track(zoom_stun_flow, {1, 0}, 100));
+
+        auto f1 = t.track(zoom_p2p_flow, {2, 0}, 100);
+        CHECK(f1);
+        CHECK(f1->type == zoom::flow_tracker::flow_type::udp_p2p);
+        CHECK(f1->dir == zoom::flow_tracker::flow_dir::from_srv);
+
+        auto f2 = t.track(zoom_p2p_flow.reversed(), {3, 0}, 100);
+        CHECK(f2);
+        CHECK(f2->id == f1->id);
+        CHECK(f2->dir == zoom::flow_tracker::flow_dir::to_srv);
+        CHECK(f2->pkts_to_srv == 1);
+        CHECK(f2->pkts_from_srv == 1);
+
+        CHECK(t.flows().size() == 2);
+    }
+
+    SECTION("keeps directions separate by default") {
+
+        zoom::flow_tracker t;
+
+        auto f1 = t.track(zoom_udp_srv_flow, {1, 0}, 100);
+        auto f2 = t.track(zoom_udp_srv_flow.reversed(), {2, 0}, 100);
+        CHECK(f1->id != f2->id);
+        CHECK(f1->dir == zoom::flow_tracker::flow_dir::from_srv);
+        CHECK(f2->dir == zoom::flow_tracker::flow_dir::to_srv);
+        CHECK(t.flows().size() == 2);
+    }
+}
+
+TEST_CASE("zoom::flow_tracker: IPv6 flows", "[zoom][flow_tracker]") {
+
+    zoom::nets::NETS6 = {net::ipv6_mask::from_str("2001:db8:a0::/44")};
+
+    auto local = net::ipv6::str_to_addr("2001:db8:1::6");
+    auto srv = net::ipv6::str_to_addr("2001:db8:a1::5");
+    auto peer = net::ipv6::str_to_addr("2001:db8:2::49");
+
+    net::ipv6_5tuple non_zoom_flow {local, peer, 24242, 8809, 17};
+    net::ipv6_5tuple zoom_srv_flow {srv, local, 8801, 12433, 17};
+    net::ipv6_5tuple zoom_stun_flow {local, srv, 12433, 3478, 17};
+    net::ipv6_5tuple zoom_p2p_flow {peer, local, 8809, 12433, 17};
+
+    zoom::flow_tracker t(300, true);
+
+    CHECK_FALSE(t.track(non_zoom_flow, {1, 0}, 100));
+
+    auto fs = t.track(zoom_srv_flow, {2, 0}, 100);
+    REQUIRE(fs);
+    CHECK(fs->type == zoom::flow_tracker::flow_type::udp_srv);
+    CHECK(fs->dir == zoom::flow_tracker::flow_dir::from_srv);
+
+    // both directions share the entry of the canonical 5-tuple
+    fs = t.track(zoom_srv_flow.reversed(), {3, 0}, 50);
+    REQUIRE(fs);
+    CHECK(fs->dir == zoom::flow_tracker::flow_dir::to_srv);
+    CHECK(fs->pkts == 2);
+
+    REQUIRE(t.track(zoom_stun_flow, {4, 0}, 100));
+    fs = t.track(zoom_p2p_flow, {5, 0}, 100);
+    REQUIRE(fs);
+    CHECK(fs->type == zoom::flow_tracker::flow_type::udp_p2p);
+    CHECK(fs->dir == zoom::flow_tracker::flow_dir::from_srv);
+
+    CHECK(t.flows().empty());
+    CHECK(t.flows6().size() == 3);
+    CHECK(t.count_zoom_flows_detected() == 3);
+    CHECK(t.count_total_pkts_processed() == 5);
+
+    // addresses sharing their upper 64 bits still hash apart
+    CHECK(std::hash<net::ipv6_5tuple>{}(zoom_srv_flow)
+          != std::hash<net::ipv6_5tuple>{}({srv, net::ipv6::str_to_addr("2001:db8:1::7"),
+                                            8801, 12433, 17}));
+
+    zoom::nets::NETS6.clear();
+}
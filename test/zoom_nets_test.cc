@@ -1,5 +1,7 @@
 
 #include <catch.h>
+#include <filesystem>
+#include <fstream>
 #include <lib/net.h>
 #include <lib/zoom_nets.h>
 
@@ -22,3 +24,29 @@ TEST_CASE("zoom::nets", "[zoom][nets]") {
     CHECK(zoom::nets::match(net::ipv4::str_to_addr("209.9.215.34")));
     CHECK_FALSE(zoom::nets::match(net::ipv4::str_to_addr("209.9.216.3")));
 }
+
+TEST_CASE("zoom::nets: IPv6 prefixes", "[zoom][nets]") {
+
+    auto m = net::ipv6_mask::from_str("2001:db8:a0::/44");
+    CHECK(m.match(net::ipv6::str_to_addr("2001:db8:af::1")));
+    CHECK_FALSE(m.match(net::ipv6::str_to_addr("2001:db8:b0::1")));
+    CHECK(net::ipv6_mask::from_str("::/0").match(net::ipv6::str_to_addr("fe80::1")));
+    CHECK(net::ipv6_mask::from_str("fe80::1").match(net::ipv6::str_to_addr("fe80::1")));
+    CHECK_FALSE(net::ipv6_mask::from_str("fe80::1").match(net::ipv6::str_to_addr("fe80::2")));
+    CHECK_THROWS(net::ipv6_mask::from_str("2001:db8::/129"));
+    CHECK_THROWS(net::ipv6_mask::from_str("2001:db8::x/32"));
+
+    auto file_name = (std::filesystem::temp_directory_path() / "zoom_analysis_nets6.txt").string();
+    std::ofstream(file_name) << "# test prefixes\n2001:db8:a0::/44\n\n  2001:db8:ff::/48 # x\n";
+
+    CHECK_FALSE(zoom::nets::match(net::ipv6::str_to_addr("2001:db8:a0::1")));
+    zoom::nets::load_ipv6_nets(file_name);
+    CHECK(zoom::nets::NETS6.size() == 2);
+    CHECK(zoom::nets::match(net::ipv6::str_to_addr("2001:db8:a0::1")));
+    CHECK(zoom::nets::match(net::ipv6::str_to_addr("2001:db8:ff:1::1")));
+    CHECK_FALSE(zoom::nets::match(net::ipv6::str_to_addr("2001:db8:fe::1")));
+
+    zoom::nets::NETS6.clear();
+    std::filesystem::remove(file_name);
+    CHECK_THROWS(zoom::nets::load_ipv6_nets(file_name));
+}
@@ -0,0 +1,103 @@
+
+#include <catch.h>
+#include "lib/net.h"
+#include "lib/zoom_p4_model.h"
+
+TEST_CASE("zoom::p4_ternary_table", "[zoom][p4_model]") {
+
+    auto srv = zoom::p4_ternary_table::from_p4inc("../p4/src/entries_match_zoom_server.p4inc");
+    auto campus = zoom::p4_ternary_table::from_p4inc(
+        "../p4/src/entries_match_campus_sources.p4inc");
+
+    REQUIRE(srv.entries().size() > 0);
+    REQUIRE(srv.entries()[0].keys.size() == 2);
+    CHECK(srv.entries()[0].keys[0].value == 0x03072300);
+    CHECK(srv.entries()[0].keys[0].mask == 0xffffff80);
+    CHECK(srv.entries()[0].keys[1].mask == 0);
+    CHECK(srv.entries()[0].action == "set_zoom_srv_src_matched");
+
+    auto zoom_ip = net::ipv4::str_to_addr("3.7.35.10");
+    auto campus_ip = net::ipv4::str_to_addr("128.112.1.1");
+    auto other_ip = net::ipv4::str_to_addr("84.202.2.49");
+
+    // source entries are listed (and thus take priority) before destination entries
+    REQUIRE(srv.match(zoom_ip, other_ip) >= 0);
+    CHECK(srv.entries()[srv.match(zoom_ip, other_ip)].action == "set_zoom_srv_src_matched");
+    CHECK(srv.entries()[srv.match(other_ip, zoom_ip)].action == "set_zoom_srv_dst_matched");
+    CHECK(srv.entries()[srv.match(zoom_ip, zoom_ip)].action == "set_zoom_srv_src_matched");
+    CHECK(srv.match(other_ip, campus_ip) == -1);
+
+    CHECK(campus.match(campus_ip) >= 0);
+    CHECK(campus.match(other_ip) == -1);
+
+    CHECK_THROWS(zoom::p4_ternary_table::from_p4inc("does_not_exist.p4inc"));
+}
+
+TEST_CASE("zoom::p4_model", "[zoom][p4_model]") {
+
+    auto model = zoom::p4_model::from_p4_src_dir("../p4/src", {});
+
+    auto zoom_ip = net::ipv4::str_to_addr("3.7.35.10");
+    auto campus_ip = net::ipv4::str_to_addr("128.112.1.1");
+    auto other_ip = net::ipv4::str_to_addr("84.202.2.49");
+
+    net::ipv4_5tuple zoom_tcp_flow { campus_ip, zoom_ip, 52000, 443, 6 };
+    net::ipv4_5tuple zoom_udp_srv_flow { zoom_ip, campus_ip, 8801, 52001, 17 };
+    net::ipv4_5tuple zoom_stun_flow { campus_ip, zoom_ip, 52002, 3478, 17 };
+    net::ipv4_5tuple p2p_out_flow { campus_ip, other_ip, 52002, 40000, 17 };
+    net::ipv4_5tuple p2p_in_flow { other_ip, campus_ip, 40000, 52002, 17 };
+    net::ipv4_5tuple low_port_flow { campus_ip, other_ip, 52002, 53, 17 };
+    net::ipv4_5tuple icmp { campus_ip, zoom_ip, 0, 0, 1 };
+
+    timeval ts = { 1000, 0 };
+
+    CHECK(model.process(zoom_tcp_flow, ts) == zoom::flow_tracker::flow_type::tcp);
+    CHECK(model.process(zoom_udp_srv_flow, ts) == zoom::flow_tracker::flow_type::udp_srv);
+    CHECK(model.process(icmp, ts) == std::nullopt);
+
+    // P2P is only accepted after the campus peer was registered through STUN
+    CHECK(model.process(p2p_out_flow, ts) == std::nullopt);
+    CHECK(model.process(zoom_stun_flow, ts) == zoom::flow_tracker::flow_type::udp_stun);
+    CHECK(model.register_fill_ratio() > 0.0);
+    CHECK(model.process(p2p_out_flow, ts) == zoom::flow_tracker::flow_type::udp_p2p);
+    CHECK(model.process(p2p_in_flow, ts) == zoom::flow_tracker::flow_type::udp_p2p);
+    CHECK(model.process(low_port_flow, ts) == std::nullopt);
+
+    // registers expire after TIME_DUR_CUTOFF ticks of 2^16 ns without refresh
+    timeval later = { ts.tv_sec + 4 * 3600, 0 };
+    CHECK(model.process(p2p_out_flow, later) == std::nullopt);
+
+    CHECK(model.all_pkts_count() == 9);
+    CHECK(model.zoom_pkts_count() == 5);
+    CHECK(model.register_cells() == 6 * 65536);
+
+    CHECK(zoom::p4_model::ingress_tstamp({0, 65}) == 0);
+    CHECK(zoom::p4_model::ingress_tstamp({0, 66}) == 1);
+
+    CHECK_THROWS(zoom::p4_model::from_p4_src_dir("../p4/src", {17}));
+}
+
+TEST_CASE("zoom::p4_model reduced index width", "[zoom][p4_model]") {
+
+    auto model = zoom::p4_model::from_p4_src_dir("../p4/src", {8});
+
+    auto zoom_ip = net::ipv4::str_to_addr("3.7.35.10");
+    auto peer_ip = net::ipv4::str_to_addr("128.112.1.1");
+    auto alias_ip = net::ipv4::str_to_addr("128.112.2.1");
+    auto other_ip = net::ipv4::str_to_addr("84.202.2.49");
+
+    timeval ts = { 1000, 0 };
+
+    model.process({peer_ip, zoom_ip, 52002, 3478, 17}, ts);
+
+    // with 8 bit indices, 128.112.2.1:52258 shares all cells with 128.112.1.1:52002
+    CHECK(model.process({alias_ip, other_ip, 52258, 40000, 17}, ts)
+          == zoom::flow_tracker::flow_type::udp_p2p);
+    CHECK(model.register_cells() == 6 * 256);
+
+    zoom::p4_model::comparison cmp;
+    cmp.add(std::nullopt, zoom::flow_tracker::flow_type::udp_p2p);
+    cmp.add(std::nullopt, std::nullopt);
+    CHECK(cmp.model_only == 1);
+    CHECK(cmp.agreement() == 0.5);
+}
@@ -132,3 +132,142 @@ TEST_CASE("zoom::parse_zoom_pkt_buf: parses a P2P RTCP packet", "[zoom][parse]")
     CHECK(hdr.rtcp->msg.sr.sender_pkt_count == ntohl(4854));
     CHECK(hdr.rtcp->msg.sr.sender_byte_count == ntohl(663624));
 }
+
+TEST_CASE("zoom::parse_zoom_hdrs_batch: parses like parse_zoom_hdrs", "[zoom][parse]") {
+
+    std::vector<const unsigned char*> bufs = {
+        test::zoom_srv_video_buf, test::zoom_p2p_audio_buf, test::zoom_p2p_screenshare_buf,
+        test::zoom_srv_screenshare_buf, test::zoom_srv_rtcp_buf, test::zoom_p2p_rtcp_buf
+    };
+
+    // every packet is parsed both as server-based and as P2P packet
+    bool is_p2p[] = {false, true, true, false, false, true, true, false, false, true, true, false};
+    bufs.insert(bufs.end(), bufs.begin(), bufs.end());
+
+    std::vector<zoom::net_headers> net_hdrs;
+
+    for (auto* buf: bufs) {
+        net_hdrs.push_back(zoom::parse_net_hdrs(buf));
+    }
+
+    std::vector<zoom::headers> hdrs(bufs.size());
+    zoom::parse_zoom_hdrs_batch(bufs.data(), net_hdrs.data(), is_p2p, bufs.size(), hdrs.data());
+
+    for (std::size_t i = 0; i < bufs.size(); i++) {
+
+        auto expected = zoom::parse_zoom_hdrs(bufs[i], net_hdrs[i], is_p2p[i]);
+
+        CHECK(hdrs[i].ip == expected.ip);
+        CHECK(hdrs[i].udp == expected.udp);
+        CHECK(hdrs[i].zoom_outer == expected.zoom_outer);
+        CHECK(hdrs[i].zoom_inner == expected.zoom_inner);
+        CHECK(hdrs[i].rtp == expected.rtp);
+        CHECK(hdrs[i].rtcp == expected.rtcp);
+        CHECK(hdrs[i].udp_pl_offset == expected.udp_pl_offset);
+        CHECK(hdrs[i].rtp_rtcp_offset == expected.rtp_rtcp_offset);
+        CHECK(std::equal(hdrs[i].rtp_ext1, hdrs[i].rtp_ext1 + 3, expected.rtp_ext1));
+    }
+}
+
+TEST_CASE("zoom::parse_zoom_pkt_buf: specialized parsers handle all link layer framings",
+          "[zoom][parse]") {
+
+    const auto& eth_buf = test::zoom_srv_video_buf;
+    std::vector<unsigned char> vlan_buf(eth_buf, eth_buf + 12), loop_buf = {2, 0, 0, 0};
+    std::vector<unsigned char> raw_buf(eth_buf + net::eth::HDR_LEN, std::end(eth_buf));
+
+    vlan_buf.insert(vlan_buf.end(), {0x81, 0x00, 0x00, 0x64});
+    vlan_buf.insert(vlan_buf.end(), eth_buf + 12, std::end(eth_buf));
+    loop_buf.insert(loop_buf.end(), raw_buf.begin(), raw_buf.end());
+
+    CHECK(net::is_ipv4<net::link_layer::eth>(eth_buf));
+    CHECK(!net::is_vlan_tagged(eth_buf));
+    CHECK(net::is_vlan_tagged(vlan_buf.data()));
+    CHECK(net::is_ipv4<net::link_layer::eth_vlan>(vlan_buf.data()));
+    CHECK(net::is_ipv4<net::link_layer::raw>(raw_buf.data()));
+    CHECK(net::is_ipv4<net::link_layer::loop>(loop_buf.data()));
+
+    auto expected = zoom::parse_zoom_pkt_buf(eth_buf, true, false);
+
+    auto check = [&](const zoom::headers& hdr, int offset_diff) {
+        REQUIRE(hdr.rtp != nullptr);
+        CHECK(hdr.rtp->ssrc == expected.rtp->ssrc);
+        CHECK(hdr.rtp->seq == expected.rtp->seq);
+        CHECK(hdr.zoom_inner[0] == zoom::VIDEO_TYPE);
+        CHECK(hdr.rtp_rtcp_offset == expected.rtp_rtcp_offset + offset_diff);
+        CHECK(std::equal(hdr.rtp_ext1, hdr.rtp_ext1 + 3, expected.rtp_ext1));
+    };
+
+    check(zoom::parse_zoom_pkt_buf<net::link_layer::eth, false>(eth_buf), 0);
+    check(zoom::parse_zoom_pkt_buf<net::link_layer::eth_vlan, false>(vlan_buf.data()), 4);
+    check(zoom::parse_zoom_pkt_buf<net::link_layer::raw, false>(raw_buf.data()), -14);
+    check(zoom::parse_zoom_pkt_buf<net::link_layer::loop, false>(loop_buf.data()), -10);
+
+    auto net_hdr = zoom::parse_net_hdrs<net::link_layer::eth_vlan>(vlan_buf.data());
+    CHECK(net_hdr.ip_5t == zoom::parse_net_hdrs(eth_buf).ip_5t);
+
+    auto p2p_hdr = zoom::parse_zoom_pkt_buf<net::link_layer::eth, true>(test::zoom_p2p_audio_buf);
+    REQUIRE(p2p_hdr.rtp != nullptr);
+    CHECK(p2p_hdr.rtp == zoom::parse_zoom_pkt_buf(test::zoom_p2p_audio_buf, true, true).rtp);
+}
+
+TEST_CASE("zoom::parse_net6_hdrs: parses an IPv6 packet", "[zoom][parse]") {
+
+    const auto& eth_buf = test::zoom_srv_video_buf;
+    auto ip_offset = net::eth::HDR_LEN;
+    auto ipv4_hdr = (const net::ipv4::hdr*) (eth_buf + ip_offset);
+    auto udp_offset = ip_offset + ipv4_hdr->ihl_bytes();
+
+    // same Ethernet frame with the IPv4 header replaced by an IPv6 header
+    std::vector<unsigned char> buf(eth_buf, eth_buf + 12);
+    buf.insert(buf.end(), {0x86, 0xdd});
+
+    net::ipv6::hdr ipv6_hdr;
+    ipv6_hdr.version_class_label = htonl(6u << 28u);
+    ipv6_hdr.next_header = 17;
+    ipv6_hdr.src_addr = net::ipv6::str_to_addr("2001:db8:a1::5");
+    ipv6_hdr.dst_addr = net::ipv6::str_to_addr("2001:db8:1::6");
+
+    buf.insert(buf.end(), (unsigned char*) &ipv6_hdr, (unsigned char*) &ipv6_hdr + net::ipv6::HDR_LEN);
+    buf.insert(buf.end(), eth_buf + udp_offset, std::end(eth_buf));
+
+    CHECK(net::is_ipv6<net::link_layer::eth>(buf.data()));
+    CHECK_FALSE(net::is_ipv4<net::link_layer::eth>(buf.data()));
+    CHECK_FALSE(net::is_ipv6<net::link_layer::eth>(eth_buf));
+    CHECK(net::is_ipv6<net::link_layer::raw>(buf.data() + net::eth::HDR_LEN));
+
+    unsigned char loop_buf[] = {0x1e, 0, 0, 0};
+    CHECK(net::is_ipv6<net::link_layer::loop>(loop_buf));
+
+    auto net_hdr = zoom::parse_net_hdrs(eth_buf);
+    auto net6_hdr = zoom::parse_net6_hdrs<net::link_layer::eth>(buf.data());
+
+    CHECK(net6_hdr.ip_5t.ip_src == ipv6_hdr.src_addr);
+    CHECK(net6_hdr.ip_5t.ip_dst == ipv6_hdr.dst_addr);
+    CHECK(net6_hdr.ip_5t.tp_src == net_hdr.ip_5t.tp_src);
+    CHECK(net6_hdr.ip_5t.tp_dst == net_hdr.ip_5t.tp_dst);
+    CHECK(net6_hdr.ip_5t.ip_proto == 17);
+    CHECK(net6_hdr.ip_5t == net::ipv6_5tuple::from_ipv6_pkt_data(buf.data() + net::eth::HDR_LEN));
+    CHECK(net6_hdr.udp_dgram_len == net_hdr.udp_dgram_len);
+
+    auto expected = zoom::parse_zoom_hdrs<false>(eth_buf, net_hdr);
+    auto hdr = zoom::parse_zoom_hdrs<false>(buf.data(), net6_hdr);
+    int offset_diff = (int) net::ipv6::HDR_LEN - (int) ipv4_hdr->ihl_bytes();
+
+    CHECK(hdr.ip == nullptr);
+    CHECK(hdr.ip6 == net6_hdr.ip);
+    REQUIRE(hdr.rtp != nullptr);
+    CHECK(hdr.rtp->ssrc == expected.rtp->ssrc);
+    CHECK(hdr.rtp_rtcp_offset == expected.rtp_rtcp_offset + offset_diff);
+    CHECK(std::equal(hdr.rtp_ext1, hdr.rtp_ext1 + 3, expected.rtp_ext1));
+
+    zoom::pkt pkt{net6_hdr, hdr, {1, 2}, buf.size(), false};
+    zoom::pkt pkt4{net_hdr, expected, {1, 2}, sizeof(eth_buf), false};
+
+    CHECK(pkt.flags.ipv6 == 1);
+    CHECK(pkt4.flags.ipv6 == 0);
+    CHECK(pkt.ip_5t.ip_src == ipv6_hdr.src_addr.fold32());
+    CHECK(pkt.ip_5t.tp_dst == pkt4.ip_5t.tp_dst);
+    CHECK(pkt.proto.rtp.ssrc == pkt4.proto.rtp.ssrc);
+    CHECK(pkt.udp_pl_len == pkt4.udp_pl_len);
+}